@@ -0,0 +1,98 @@
+# Copyright (c) 2018 University of Illinois Board of Trustees
+# All rights reserved.
+#
+# Developed by:       Technology Services
+#                     University of Illinois at Urbana-Champaign
+#                     https://techservices.illinois.edu/
+#
+#
+# Permission is hereby granted, free of charge, to any person obtaining
+# a copy of this software and associated documentation files (the
+# "Software"), to deal with the Software without restriction, including
+# without limitation the rights to use, copy, modify, merge, publish,
+# distribute, sublicense, and/or sell copies of the Software, and to
+# permit persons to whom the Software is furnished to do so, subject to
+# the following conditions:
+#
+# - Redistributions of source code must retain the above copyright
+#   notice, this list of conditions and the following disclaimers.
+# - Redistributions in binary form must reproduce the above copyright
+#   notice, this list of conditions and the following disclaimers in the
+#   documentation and/or other materials provided with the distribution.
+# - Neither the names of Technology Services, University of Illinois at
+#   Urbana-Champaign, nor the names of its contributors may be used to
+#   endorse or promote products derived from this Software without
+#   specific prior written permission.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+# EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+# MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+# IN NO EVENT SHALL THE CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+# ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+# CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+# WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS WITH THE SOFTWARE.
+
+# Driven by the pgo target. Every phase builds in PGO_BINARY_DIR so the
+# object paths, and so the profile file names, match between them.
+
+foreach(var PGO_SOURCE_DIR PGO_BINARY_DIR PGO_INSTALL_DIR PGO_GENERATOR)
+    if(NOT ${var})
+        message(FATAL_ERROR "${var} must be set")
+    endif()
+endforeach()
+if(NOT PGO_CONFIG OR NOT EXISTS "${PGO_CONFIG}")
+    message(FATAL_ERROR "Set UIUC_SHIBPLUGINS_PGO_CONFIG to a storage configuration for the training run")
+endif()
+if(PGO_TRACE AND NOT EXISTS "${PGO_TRACE}")
+    message(FATAL_ERROR "PGO trace file does not exist: ${PGO_TRACE}")
+endif()
+
+function(pgo_run)
+    execute_process(COMMAND ${ARGN}
+        WORKING_DIRECTORY ${PGO_BINARY_DIR}
+        RESULT_VARIABLE result
+    )
+    if(NOT result EQUAL 0)
+        message(FATAL_ERROR "PGO step failed (${result}): ${ARGN}")
+    endif()
+endfunction()
+
+function(pgo_build phase install_dir)
+    message(STATUS "PGO ${phase} build")
+    pgo_run(${CMAKE_COMMAND} -G ${PGO_GENERATOR}
+        -DCMAKE_C_COMPILER=${PGO_C_COMPILER}
+        -DCMAKE_CXX_COMPILER=${PGO_CXX_COMPILER}
+        -DUIUC_SHIBPLUGINS_LTO=ON
+        -DUIUC_SHIBPLUGINS_PGO_PHASE=${phase}
+        -DUIUC_SHIBPLUGINS_INSTALL_DIR=${install_dir}
+        ${PGO_SOURCE_DIR}
+    )
+    pgo_run(${CMAKE_COMMAND} --build .)
+endfunction()
+
+file(MAKE_DIRECTORY ${PGO_BINARY_DIR})
+pgo_build(generate ${PGO_BINARY_DIR}/instrumented)
+
+# a profile left from an earlier run would be merged into this one
+file(GLOB_RECURSE stale_profiles ${PGO_BINARY_DIR}/*.gcda)
+if(stale_profiles)
+    file(REMOVE ${stale_profiles})
+endif()
+
+file(GLOB plugin ${PGO_BINARY_DIR}/project-build/libuiuc-shibplugins.*)
+message(STATUS "PGO training run")
+pgo_run(${PGO_BINARY_DIR}/project-build/stress-test/uiuc-shibplugins-stress
+    -c ${PGO_CONFIG}
+    -l ${plugin}
+    --threads 1,4,16
+    --duration 10
+)
+if(PGO_TRACE)
+    pgo_run(${PGO_BINARY_DIR}/project-build/store-tool/uiuc-shibplugins-store
+        -c ${PGO_CONFIG}
+        -l ${plugin}
+        replay ${PGO_TRACE} --speed 0
+    )
+endif()
+
+pgo_build(use ${PGO_INSTALL_DIR})
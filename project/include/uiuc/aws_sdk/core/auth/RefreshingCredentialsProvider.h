@@ -0,0 +1,84 @@
+/* Copyright (c) 2018 University of Illinois Board of Trustees
+ * All rights reserved.
+ *
+ * Developed by:       Technology Services
+ *                     University of Illinois at Urbana-Champaign
+ *                     https://techservices.illinois.edu/
+ *
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal with the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimers.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimers in the
+ *   documentation and/or other materials provided with the distribution.
+ * - Neither the names of Technology Services, University of Illinois at
+ *   Urbana-Champaign, nor the names of its contributors may be used to
+ *   endorse or promote products derived from this Software without
+ *   specific prior written permission.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS WITH THE SOFTWARE.
+ */
+
+#pragma once
+#include <atomic>
+#include <aws/core/auth/AWSCredentialsProvider.h>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <xmltooling/logging.h>
+
+namespace UIUC {
+
+namespace AWS_SDK {
+
+namespace Auth {
+
+class RefreshingCredentialsProvider : public Aws::Auth::AWSCredentialsProvider {
+
+public:
+    RefreshingCredentialsProvider(
+        std::shared_ptr<Aws::Auth::AWSCredentialsProvider> provider,
+        std::chrono::seconds interval,
+        unsigned int alertFailures
+    );
+    ~RefreshingCredentialsProvider();
+
+    Aws::Auth::AWSCredentials GetAWSCredentials();
+
+    unsigned int getFailures() const { return m_failures; }
+
+private:
+    bool refresh();
+    void run();
+
+    unsigned int m_alertFailures;
+    std::condition_variable m_cond;
+    std::shared_ptr<const Aws::Auth::AWSCredentials> m_credentials;
+    std::atomic<unsigned int> m_failures;
+    std::chrono::seconds m_interval;
+    xmltooling::logging::Category& m_log;
+    std::mutex m_mutex;
+    std::shared_ptr<Aws::Auth::AWSCredentialsProvider> m_provider;
+    std::thread m_refresher;
+    bool m_shutdown;
+};
+
+} // namespace Auth
+} // namespace AWS_SDK
+} // namespace UIUC
@@ -0,0 +1,143 @@
+/* Copyright (c) 2018 University of Illinois Board of Trustees
+ * All rights reserved.
+ *
+ * Developed by:       Technology Services
+ *                     University of Illinois at Urbana-Champaign
+ *                     https://techservices.illinois.edu/
+ *
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal with the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimers.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimers in the
+ *   documentation and/or other materials provided with the distribution.
+ * - Neither the names of Technology Services, University of Illinois at
+ *   Urbana-Champaign, nor the names of its contributors may be used to
+ *   endorse or promote products derived from this Software without
+ *   specific prior written permission.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS WITH THE SOFTWARE.
+ */
+
+#pragma once
+#include <aws/core/Aws.h>
+#include <aws/core/client/ClientConfiguration.h>
+#include <aws/core/http/HttpClientFactory.h>
+#include <aws/core/http/curl/CurlHttpClient.h>
+#include <chrono>
+#include <curl/curl.h>
+#include <memory>
+#include <mutex>
+#include <xmltooling/logging.h>
+
+namespace UIUC {
+
+namespace AWS_SDK {
+
+namespace Http {
+
+class SharedCurlState {
+
+public:
+    struct Stats {
+        unsigned long requests;
+        unsigned long connectionsOpened;
+        unsigned long connectionsOpen;
+        unsigned long connectionsPeak;
+    };
+
+    SharedCurlState(bool http2, std::chrono::seconds statsInterval);
+    ~SharedCurlState();
+
+    void configure(CURL* handle);
+    Stats getStats() const;
+    void logStats(bool force = false);
+
+private:
+    static void lock(CURL* handle, curl_lock_data data, curl_lock_access access, void* userptr);
+    static void unlock(CURL* handle, curl_lock_data data, void* userptr);
+    static curl_socket_t openSocket(void* clientp, curlsocktype purpose, struct curl_sockaddr* address);
+    static int closeSocket(void* clientp, curl_socket_t item);
+
+    bool m_http2;
+    std::mutex m_locks[CURL_LOCK_DATA_LAST];
+    xmltooling::logging::Category& m_log;
+    CURLSH* m_share;
+    Stats m_stats;
+    std::chrono::steady_clock::time_point m_statsLogged;
+    std::chrono::seconds m_statsInterval;
+    mutable std::mutex m_statsMutex;
+};
+
+
+// Keeps the shared state alive until after the CurlHttpClient base,
+// and the easy handles it owns, have been destroyed.
+class SharedCurlStateHolder {
+
+protected:
+    SharedCurlStateHolder(std::shared_ptr<SharedCurlState> state) : m_state(state) {}
+
+    std::shared_ptr<SharedCurlState> m_state;
+};
+
+
+class SharedCurlHttpClient : private SharedCurlStateHolder, public Aws::Http::CurlHttpClient {
+
+public:
+    SharedCurlHttpClient(
+        const Aws::Client::ClientConfiguration &clientConfiguration,
+        std::shared_ptr<SharedCurlState> state
+    );
+    ~SharedCurlHttpClient() {}
+
+protected:
+    void OverrideOptionsOnConnectionHandle(CURL* handle) const;
+};
+
+
+class SharedCurlHttpClientFactory : public Aws::Http::HttpClientFactory {
+
+public:
+    SharedCurlHttpClientFactory(bool http2, std::chrono::seconds statsInterval);
+    ~SharedCurlHttpClientFactory() {}
+
+    std::shared_ptr<Aws::Http::HttpClient> CreateHttpClient(
+        const Aws::Client::ClientConfiguration &clientConfiguration
+    ) const;
+    std::shared_ptr<Aws::Http::HttpRequest> CreateHttpRequest(
+        const Aws::String &uri,
+        Aws::Http::HttpMethod method,
+        const Aws::IOStreamFactory &streamFactory
+    ) const;
+    std::shared_ptr<Aws::Http::HttpRequest> CreateHttpRequest(
+        const Aws::Http::URI &uri,
+        Aws::Http::HttpMethod method,
+        const Aws::IOStreamFactory &streamFactory
+    ) const;
+
+    void InitStaticState();
+    void CleanupStaticState();
+
+private:
+    bool m_http2;
+    std::shared_ptr<SharedCurlState> m_state;
+    std::chrono::seconds m_statsInterval;
+};
+
+} // namespace Http
+} // namespace AWS_SDK
+} // namespace UIUC
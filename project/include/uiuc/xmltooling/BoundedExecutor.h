@@ -0,0 +1,142 @@
+/* Copyright (c) 2018 University of Illinois Board of Trustees
+ * All rights reserved.
+ *
+ * Developed by:       Technology Services
+ *                     University of Illinois at Urbana-Champaign
+ *                     https://techservices.illinois.edu/
+ *
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal with the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimers.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimers in the
+ *   documentation and/or other materials provided with the distribution.
+ * - Neither the names of Technology Services, University of Illinois at
+ *   Urbana-Champaign, nor the names of its contributors may be used to
+ *   endorse or promote products derived from this Software without
+ *   specific prior written permission.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS WITH THE SOFTWARE.
+ */
+
+#pragma once
+#include <aws/core/utils/threading/Executor.h>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <xmltooling/logging.h>
+
+namespace UIUC {
+
+namespace XMLTooling {
+
+class BoundedExecutor : public Aws::Utils::Threading::Executor {
+
+public:
+    struct Stats {
+        unsigned int threads;
+        size_t queueSize;
+        size_t queueDepth;
+        size_t maxQueueDepth;
+        unsigned long submitted;
+        unsigned long completed;
+        unsigned long helped;
+        unsigned long ranInline;
+        unsigned long stolen;
+        unsigned long blocked;
+        std::chrono::microseconds queueWait;
+        std::chrono::microseconds maxQueueWait;
+        std::chrono::microseconds runTime;
+    };
+
+    BoundedExecutor(unsigned int threads, size_t queueSize);
+    ~BoundedExecutor();
+
+    Stats getStats() const;
+    void logStats() const;
+
+    // Waits for the result of a task. On one of the executor's own
+    // threads it runs queued tasks in the meantime, since the result
+    // might be waiting behind them. There it has to be the result of a
+    // task on this executor, which wakes it up when it finishes.
+    template <typename T>
+    void wait(const std::future<T> &result)
+    {
+        if (!isCurrent()) {
+            result.wait();
+            return;
+        }
+        while (true) {
+            const unsigned long progress = getProgress();
+            if (result.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+                return;
+            }
+            if (!runQueued()) {
+                waitForProgress(progress);
+            }
+        }
+    }
+
+    static std::shared_ptr<BoundedExecutor> getShared(unsigned int threads, size_t queueSize);
+
+protected:
+    bool SubmitToThread(std::function<void()> &&fn) override;
+
+private:
+    struct Task {
+        std::function<void()> fn;
+        std::chrono::steady_clock::time_point queuedAt;
+    };
+
+    struct Worker {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+        std::thread thread;
+    };
+
+    unsigned long getProgress() const;
+    bool isCurrent() const;
+    void run(unsigned int index);
+    void runTask(Task &task);
+    bool runQueued();
+    bool takeTask(unsigned int index, Task &task);
+    bool tryTakeTask(unsigned int index, Task &task);
+    void waitForProgress(unsigned long progress);
+
+    xmltooling::logging::Category& m_log;
+    mutable std::mutex m_mutex;
+    unsigned int m_next;
+    unsigned long m_progress;
+    std::condition_variable m_progressCond;
+    size_t m_queued;
+    size_t m_queueSize;
+    std::condition_variable m_roomCond;
+    bool m_shutdown;
+    Stats m_stats;
+    std::condition_variable m_workCond;
+    std::vector<std::unique_ptr<Worker>> m_workers;
+};
+
+
+} // namespace XMLTooling
+} // namespace UIUC
@@ -0,0 +1,107 @@
+/* Copyright (c) 2018 University of Illinois Board of Trustees
+ * All rights reserved.
+ *
+ * Developed by:       Technology Services
+ *                     University of Illinois at Urbana-Champaign
+ *                     https://techservices.illinois.edu/
+ *
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal with the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimers.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimers in the
+ *   documentation and/or other materials provided with the distribution.
+ * - Neither the names of Technology Services, University of Illinois at
+ *   Urbana-Champaign, nor the names of its contributors may be used to
+ *   endorse or promote products derived from this Software without
+ *   specific prior written permission.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS WITH THE SOFTWARE.
+ */
+
+#pragma once
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <xmltooling/logging.h>
+
+namespace UIUC {
+
+namespace XMLTooling {
+
+class CircuitBreaker {
+
+public:
+    enum State {
+        CLOSED,
+        OPEN,
+        HALF_OPEN
+    };
+
+    CircuitBreaker(
+        const std::string& name,
+        int failureThreshold,
+        int failureRate,
+        std::chrono::milliseconds window,
+        std::chrono::milliseconds latencyThreshold,
+        std::chrono::milliseconds openInterval
+    );
+    ~CircuitBreaker() {}
+
+    // Sets probe when the request is the one let through to test a
+    // half open circuit; pass it back when recording the outcome.
+    bool allowRequest(bool& probe);
+    void recordSuccess(std::chrono::milliseconds latency, bool probe);
+    void recordFailure(bool probe);
+
+    State getState() const;
+
+    static const char* getStateName(State state);
+
+private:
+    // Outcomes are counted in buckets that each cover a slice of the
+    // window, so old requests age out without keeping each one.
+    struct Bucket {
+        long long slice;
+        int failures;
+        int requests;
+    };
+
+    void count(bool failed);
+    void countWindow(int& failures, int& requests) const;
+    void open(const char* reason, int failures, int requests);
+    long long slice(std::chrono::steady_clock::time_point time) const;
+
+    std::vector<Bucket> m_buckets;
+    int m_failureRate;
+    int m_failureThreshold;
+    std::chrono::milliseconds m_latencyThreshold;
+    xmltooling::logging::Category& m_log;
+    mutable std::mutex m_mutex;
+    std::string m_name;
+    std::chrono::milliseconds m_openInterval;
+    std::chrono::steady_clock::time_point m_opened;
+    bool m_probing;
+    std::chrono::steady_clock::time_point m_probeStarted;
+    State m_state;
+    std::chrono::milliseconds m_window;
+};
+
+
+} // namespace XMLTooling
+} // namespace UIUC
@@ -0,0 +1,91 @@
+/* Copyright (c) 2018 University of Illinois Board of Trustees
+ * All rights reserved.
+ *
+ * Developed by:       Technology Services
+ *                     University of Illinois at Urbana-Champaign
+ *                     https://techservices.illinois.edu/
+ *
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal with the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimers.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimers in the
+ *   documentation and/or other materials provided with the distribution.
+ * - Neither the names of Technology Services, University of Illinois at
+ *   Urbana-Champaign, nor the names of its contributors may be used to
+ *   endorse or promote products derived from this Software without
+ *   specific prior written permission.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS WITH THE SOFTWARE.
+ */
+
+#pragma once
+#include <chrono>
+#include <ctime>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace UIUC {
+
+namespace XMLTooling {
+
+class ContextKeyCache {
+
+public:
+    // partition and key of each item in a context
+    typedef std::vector<std::pair<std::string, std::string>> Keys;
+
+    ContextKeyCache(bool authoritative, std::chrono::seconds ttl, size_t size);
+    ~ContextKeyCache() {}
+
+    bool getKeys(const std::string &context, Keys &keys, unsigned long &generation);
+    void setKeys(const std::string &context, const Keys &keys, time_t expiration, unsigned long generation, bool listed);
+
+    void addKey(const std::string &context, const std::string &partition, const std::string &key, time_t expiration);
+    void removeKey(const std::string &context, const std::string &key);
+    void checkKey(const std::string &context, const std::string &key);
+
+    void invalidate(const std::string &context);
+    void erase(const std::string &context);
+
+private:
+    struct Entry {
+        std::unordered_map<std::string, std::pair<std::string, time_t>> keys;
+        bool complete;
+        unsigned long generation;
+        std::chrono::steady_clock::time_point listedAt;
+        std::list<std::string>::iterator lru;
+    };
+
+    Entry& touch(const std::string &context);
+
+    bool m_authoritative;
+    std::unordered_map<std::string, Entry> m_entries;
+    unsigned long m_generation;
+    std::list<std::string> m_lru;
+    std::mutex m_mutex;
+    size_t m_size;
+    std::chrono::seconds m_ttl;
+};
+
+
+} // namespace XMLTooling
+} // namespace UIUC
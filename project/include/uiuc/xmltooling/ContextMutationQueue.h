@@ -0,0 +1,97 @@
+/* Copyright (c) 2018 University of Illinois Board of Trustees
+ * All rights reserved.
+ *
+ * Developed by:       Technology Services
+ *                     University of Illinois at Urbana-Champaign
+ *                     https://techservices.illinois.edu/
+ *
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal with the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimers.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimers in the
+ *   documentation and/or other materials provided with the distribution.
+ * - Neither the names of Technology Services, University of Illinois at
+ *   Urbana-Champaign, nor the names of its contributors may be used to
+ *   endorse or promote products derived from this Software without
+ *   specific prior written permission.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS WITH THE SOFTWARE.
+ */
+
+#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <ctime>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <xmltooling/logging.h>
+
+namespace UIUC {
+
+namespace XMLTooling {
+
+class ContextMutationQueue {
+
+public:
+    typedef std::function<void (const std::string &context, bool remove, time_t expiration)> Apply;
+
+    ContextMutationQueue(
+        Apply apply,
+        unsigned int size,
+        unsigned int workers,
+        unsigned int attempts,
+        std::chrono::milliseconds backoff
+    );
+    ~ContextMutationQueue();
+
+    bool enqueue(const std::string &context, bool remove, time_t expiration);
+    bool isDeletePending(const std::string &context) const;
+    void settle(const std::string &context);
+    void flush();
+
+private:
+    struct Mutation {
+        bool remove;
+        time_t expiration;
+    };
+
+    void run();
+    void applyWithRetry(const std::string &context, const Mutation &mutation);
+
+    std::unordered_map<std::string, Mutation> m_active;
+    Apply m_apply;
+    unsigned int m_attempts;
+    std::chrono::milliseconds m_backoff;
+    mutable std::condition_variable m_cond;
+    xmltooling::logging::Category& m_log;
+    mutable std::mutex m_mutex;
+    std::deque<std::string> m_order;
+    std::unordered_map<std::string, Mutation> m_pending;
+    bool m_shutdown;
+    unsigned int m_size;
+    std::vector<std::thread> m_workers;
+};
+
+
+} // namespace XMLTooling
+} // namespace UIUC
@@ -0,0 +1,104 @@
+/* Copyright (c) 2018 University of Illinois Board of Trustees
+ * All rights reserved.
+ *
+ * Developed by:       Technology Services
+ *                     University of Illinois at Urbana-Champaign
+ *                     https://techservices.illinois.edu/
+ *
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal with the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimers.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimers in the
+ *   documentation and/or other materials provided with the distribution.
+ * - Neither the names of Technology Services, University of Illinois at
+ *   Urbana-Champaign, nor the names of its contributors may be used to
+ *   endorse or promote products derived from this Software without
+ *   specific prior written permission.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS WITH THE SOFTWARE.
+ */
+
+#pragma once
+#include <chrono>
+#include <ctime>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace UIUC {
+
+namespace XMLTooling {
+
+class ContextPrefetchCache {
+
+public:
+    struct Item {
+        std::string value;
+        time_t expiration;
+        int version;
+        // false for values split into chunks, which are read directly
+        bool complete;
+    };
+    typedef std::unordered_map<std::string, Item> Items;
+
+    enum Lookup {
+        FOUND,
+        ABSENT,
+        INCOMPLETE,
+        NOT_CACHED,
+        TOO_LARGE
+    };
+
+    ContextPrefetchCache(const std::vector<std::string> &prefixes, std::chrono::milliseconds ttl, size_t size, size_t maxItems);
+    ~ContextPrefetchCache() {}
+
+    bool matches(const char* context) const;
+    size_t getMaxItems() const { return m_maxItems; }
+
+    Lookup lookup(const std::string &context, const std::string &key, Item &item, unsigned long &generation);
+    void store(const std::string &context, Items &items, unsigned long generation);
+    void storeTooLarge(const std::string &context, unsigned long generation);
+    void invalidate(const std::string &context);
+
+private:
+    struct Entry {
+        Items items;
+        bool complete;
+        unsigned long generation;
+        std::chrono::steady_clock::time_point fetchedAt;
+        std::list<std::string>::iterator lru;
+        bool tooLarge;
+    };
+
+    Entry& touch(const std::string &context);
+
+    std::unordered_map<std::string, Entry> m_entries;
+    unsigned long m_generation;
+    std::list<std::string> m_lru;
+    size_t m_maxItems;
+    std::mutex m_mutex;
+    std::vector<std::string> m_prefixes;
+    size_t m_size;
+    std::chrono::milliseconds m_ttl;
+};
+
+
+} // namespace XMLTooling
+} // namespace UIUC
@@ -0,0 +1,91 @@
+/* Copyright (c) 2018 University of Illinois Board of Trustees
+ * All rights reserved.
+ *
+ * Developed by:       Technology Services
+ *                     University of Illinois at Urbana-Champaign
+ *                     https://techservices.illinois.edu/
+ *
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal with the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimers.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimers in the
+ *   documentation and/or other materials provided with the distribution.
+ * - Neither the names of Technology Services, University of Illinois at
+ *   Urbana-Champaign, nor the names of its contributors may be used to
+ *   endorse or promote products derived from this Software without
+ *   specific prior written permission.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS WITH THE SOFTWARE.
+ */
+
+#pragma once
+#include <aws/core/client/AWSError.h>
+#include <aws/core/client/CoreErrors.h>
+#include <aws/core/client/RetryStrategy.h>
+#include <chrono>
+#include <memory>
+
+namespace UIUC {
+
+namespace XMLTooling {
+
+class Deadline {
+
+public:
+    class Scope {
+
+    public:
+        Scope(const Deadline* deadline);
+        ~Scope();
+
+    private:
+        const Deadline* m_previous;
+    };
+
+    Deadline(std::chrono::milliseconds budget);
+    ~Deadline() {}
+
+    bool isLimited() const { return m_limited; }
+    bool hasExpired() const;
+    std::chrono::milliseconds getRemaining() const;
+
+    static const Deadline* getCurrent();
+    static void sleep(std::chrono::milliseconds delay);
+
+private:
+    std::chrono::steady_clock::time_point m_expires;
+    bool m_limited;
+};
+
+
+class DeadlineRetryStrategy : public Aws::Client::RetryStrategy {
+
+public:
+    DeadlineRetryStrategy(std::shared_ptr<Aws::Client::RetryStrategy> strategy);
+    ~DeadlineRetryStrategy() {}
+
+    bool ShouldRetry(const Aws::Client::AWSError<Aws::Client::CoreErrors>& error, long attemptedRetries) const;
+    long CalculateDelayBeforeNextRetry(const Aws::Client::AWSError<Aws::Client::CoreErrors>& error, long attemptedRetries) const;
+
+private:
+    std::shared_ptr<Aws::Client::RetryStrategy> m_strategy;
+};
+
+
+} // namespace XMLTooling
+} // namespace UIUC
@@ -0,0 +1,84 @@
+/* Copyright (c) 2018 University of Illinois Board of Trustees
+ * All rights reserved.
+ *
+ * Developed by:       Technology Services
+ *                     University of Illinois at Urbana-Champaign
+ *                     https://techservices.illinois.edu/
+ *
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal with the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimers.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimers in the
+ *   documentation and/or other materials provided with the distribution.
+ * - Neither the names of Technology Services, University of Illinois at
+ *   Urbana-Champaign, nor the names of its contributors may be used to
+ *   endorse or promote products derived from this Software without
+ *   specific prior written permission.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS WITH THE SOFTWARE.
+ */
+
+#pragma once
+#include <aws/dynamodb/DynamoDBClient.h>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <uiuc/xmltooling/CircuitBreaker.h>
+
+namespace UIUC {
+
+namespace XMLTooling {
+
+class DynamoDBEndpoint {
+
+public:
+    DynamoDBEndpoint(
+        const std::string& name,
+        std::shared_ptr<Aws::DynamoDB::DynamoDBClient> client,
+        bool primary,
+        std::shared_ptr<CircuitBreaker> breaker = nullptr
+    );
+    ~DynamoDBEndpoint() {}
+
+    const std::string& getName() const { return m_name; }
+    const Aws::DynamoDB::DynamoDBClient& getClient() const { return *m_client; }
+    bool isPrimary() const { return m_primary; }
+    CircuitBreaker* getBreaker() const { return m_breaker.get(); }
+
+    bool isHealthy() const;
+    double getScore() const;
+
+    void recordSuccess(std::chrono::milliseconds latency);
+    void recordFailure();
+
+private:
+    std::shared_ptr<CircuitBreaker> m_breaker;
+    std::shared_ptr<Aws::DynamoDB::DynamoDBClient> m_client;
+    int m_failures;
+    std::chrono::steady_clock::time_point m_lastFailure;
+    double m_latency;
+    bool m_measured;
+    mutable std::mutex m_mutex;
+    std::string m_name;
+    bool m_primary;
+};
+
+
+} // namespace XMLTooling
+} // namespace UIUC
@@ -38,11 +38,25 @@
 #include <aws/dynamodb/DynamoDBClient.h>
 #include <aws/dynamodb/DynamoDBRequest.h>
 #include <chrono>
+#include <condition_variable>
 #include <ctime>
 #include <functional>
+#include <future>
+#include <memory>
 #include <mutex>
 #include <string>
+#include <thread>
 #include <unordered_map>
+#include <utility>
+#include <uiuc/xmltooling/BoundedExecutor.h>
+#include <uiuc/xmltooling/CapacityProfiler.h>
+#include <uiuc/xmltooling/ContextKeyCache.h>
+#include <uiuc/xmltooling/ContextMutationQueue.h>
+#include <uiuc/xmltooling/ContextPrefetchCache.h>
+#include <uiuc/xmltooling/DynamoDBEndpoint.h>
+#include <uiuc/xmltooling/StaleItemCache.h>
+#include <uiuc/xmltooling/TraceRecorder.h>
+#include <vector>
 #include <xercesc/dom/DOMElement.hpp>
 #include <xmltooling/base.h>
 #include <xmltooling/logging.h>
@@ -59,10 +73,31 @@ class DynamoDBStorageService : public xmltooling::StorageService {
 public:
     typedef Aws::Map<Aws::String, Aws::DynamoDB::Model::AttributeValue> Item;
 
-    ~DynamoDBStorageService() {}
+    struct AttributeNames {
+        std::string context;
+        std::string key;
+        std::string value;
+        std::string expires;
+        std::string version;
+        std::string chunks;
+    };
+
+    struct ReadRequest {
+        std::string context;
+        std::string key;
+        int version;
+    };
+
+    struct ReadResult {
+        int version;
+        std::string value;
+        time_t expiration;
+    };
+
+    ~DynamoDBStorageService();
 
     const Capabilities& getCapabilities() const {
-        return m_caps;
+        return *m_caps;
     }
 
     bool createString(
@@ -129,34 +164,155 @@ public:
     void updateContext(const char* context, time_t expiration);
     void deleteContext(const char* context);
 
+    std::future<bool> createStringAsync(
+            const std::string &context,
+            const std::string &key,
+            const std::string &value,
+            time_t expiration
+    );
+    std::future<ReadResult> readStringAsync(
+            const std::string &context,
+            const std::string &key,
+            int version = 0
+    );
+    std::future<int> updateStringAsync(
+            const std::string &context,
+            const std::string &key,
+            const std::string &value,
+            time_t expiration = 0,
+            int version = 0
+    );
+    std::future<bool> deleteStringAsync(
+            const std::string &context,
+            const std::string &key
+    );
+    std::future<void> updateContextAsync(const std::string &context, time_t expiration);
+    std::future<void> deleteContextAsync(const std::string &context);
+
+    std::vector<ReadResult> readStrings(const std::vector<ReadRequest> &requests, bool values = true);
+    unsigned long copyTable(const std::string &sourceTable, const AttributeNames &sourceNames, unsigned long* pskipped = nullptr);
+
     void forEachContextKey(
         const char* context,
         std::function<bool (const Aws::DynamoDB::Model::AttributeValue&)> callback
     );
 
     Aws::Client::ClientConfiguration getDynamoDBClientConfiguration() const { return m_clientConfig; }
+    const CapacityProfiler* getCapacityProfiler() const { return m_profiler.get(); }
+    const BoundedExecutor* getExecutor() const { return m_executor.get(); }
+    const StaleItemCache* getStaleItemCache() const { return m_stale.get(); }
+    const AttributeNames& getAttributeNames() const { return m_names; }
+
+    static AttributeNames parseAttributeNames(const std::string &names);
 
 private:
+    struct Route {
+        std::string prefix;
+        std::string tableName;
+        std::vector<std::shared_ptr<DynamoDBEndpoint>> endpoints;
+        int warmupConnections;
+    };
+
     DynamoDBStorageService(const xercesc::DOMElement* e);
 
+    bool createStringItem(const char* context, const char* key, const char* value, time_t expiration);
+    int readStringItem(const char* context, const char* key, std::string* pvalue, time_t* pexpiration, int version);
+    int updateStringItem(const char* context, const char* key, const char* value, time_t expiration, int version);
+    bool deleteStringItem(const char* context, const char* key, int version = 0);
+    void checkContext(const char* context) const;
+    void checkKey(const char* context, const char* key) const;
+
+    void applyUpdateContext(const char* context, time_t expiration);
+    void applyDeleteContext(const char* context);
+
+    bool readPrefetched(const char* context, const char* key, std::string* pvalue, time_t* pexpiration, int version, int &itemVersion);
+    bool prefetchContext(const char* context, unsigned long generation);
+    void invalidatePrefetch(const char* context);
+
+    std::vector<std::string> splitChunks(const char* value) const;
+    const std::string getChunkKey(const char* key, int chunk) const;
+    int getChunks(const Item &item) const;
+    bool createChunkedString(const char* context, const char* key, const std::vector<std::string> &chunks, time_t expiration);
+    int updateChunkedString(const char* context, const char* key, const std::vector<std::string>* chunks, time_t expiration, int version);
+    bool readChunks(const char* context, const char* key, int chunks, int version, std::string &value);
+    void deleteChunks(const char* context, const char* key, int from, int to);
+
     template <typename T>
     T getItemN(const char* context, const char* key, const Item &item, const std::string &itemKey) const;
-    const std::string getItemS(const char* context, const char* key, const Item &item, const std::string &itemKey) const;
+    const std::string& getItemS(const char* context, const char* key, const Item &item, const std::string &itemKey) const;
+
+    const std::string getPartition(const char* context, const char* key) const;
+    std::vector<std::string> getPartitions(const char* context) const;
+    void forEachPartition(const char* context, const std::function<void (const std::string&)> &fn) const;
+    void forEachPartitionKey(
+        const std::string &partition,
+        const char* context,
+        std::function<bool (const Aws::DynamoDB::Model::AttributeValue&)> callback,
+        const ContextKeyCache::Keys *keys = nullptr,
+        bool useIndex = false
+    );
+
+    template <typename T>
+    std::future<T> fanOut(std::function<T ()> fn) const;
+    template <typename T>
+    std::future<T> submit(std::function<T ()> fn);
+
+    template <typename O>
+    O invoke(bool write, const char* context, const std::function<O (const Aws::DynamoDB::DynamoDBClient&)> &call);
+    template <typename R>
+    void prepareRequest(R &request) const;
+    const Route* getRoute(const char* context) const;
+    const std::string& getTableName(const char* context) const;
+    const std::vector<std::shared_ptr<DynamoDBEndpoint>>& getEndpoints(const char* context) const;
+    std::vector<std::shared_ptr<DynamoDBEndpoint>> orderEndpoints(
+        const std::vector<std::shared_ptr<DynamoDBEndpoint>> &endpoints
+    ) const;
+
+    void warmEndpoints(bool validateTable);
+    void warmConnections(DynamoDBEndpoint &endpoint, const std::string &tableName, int count, bool validateTable);
+    void validateKeysIndex(const Aws::DynamoDB::Model::TableDescription &table, const DynamoDBEndpoint &endpoint) const;
+    void keepAlive();
 
     void logError(const Aws::Client::AWSError<Aws::DynamoDB::DynamoDBErrors> &error) const;
     void logRequest(const Aws::DynamoDB::DynamoDBRequest &request) const;
 
     std::chrono::milliseconds m_batchBackoffMax;
     std::chrono::milliseconds m_batchBackoffScaleFactor;
-    int m_batchSize;
-    Capabilities m_caps;
-    std::shared_ptr<Aws::DynamoDB::DynamoDBClient> m_client;
+    unsigned int m_batchConcurrency;
+    unsigned int m_batchSize;
+    std::condition_variable m_asyncCond;
+    std::mutex m_asyncMutex;
+    unsigned long m_asyncPending;
+    std::unique_ptr<Capabilities> m_caps;
+    unsigned int m_chunkSize;
     Aws::Client::ClientConfiguration m_clientConfig;
+    std::chrono::milliseconds m_contextTimeout;
+    std::vector<std::shared_ptr<DynamoDBEndpoint>> m_endpoints;
+    std::shared_ptr<BoundedExecutor> m_executor;
+    std::unique_ptr<ContextKeyCache> m_keyCache;
+    std::chrono::seconds m_keepAliveInterval;
+    std::string m_keysIndexName;
+    std::condition_variable m_keepAliveCond;
+    std::mutex m_keepAliveMutex;
+    std::thread m_keepAliveThread;
     xmltooling::logging::Category& m_log;
+    int m_maxChunks;
+    AttributeNames m_names;
+    std::unique_ptr<ContextMutationQueue> m_mutations;
+    std::unique_ptr<ContextPrefetchCache> m_prefetch;
+    std::unique_ptr<CapacityProfiler> m_profiler;
+    std::chrono::milliseconds m_readTimeout;
+    std::vector<Route> m_routes;
+    std::vector<std::pair<std::string, int>> m_shards;
+    bool m_shutdown;
+    std::unique_ptr<StaleItemCache> m_stale;
     std::string m_tableName;
+    std::unique_ptr<TraceRecorder> m_tracer;
     int m_updateContextWindow;
     std::unordered_map<std::string, time_t> m_updateContextExpirations;
     std::mutex m_updateContextExpirationsMutex;
+    int m_warmupConnections;
+    std::chrono::milliseconds m_writeTimeout;
 
     friend xmltooling::StorageService* DynamoDBStorageServiceFactory(const xercesc::DOMElement* const &, bool);
 };
@@ -0,0 +1,104 @@
+/* Copyright (c) 2018 University of Illinois Board of Trustees
+ * All rights reserved.
+ *
+ * Developed by:       Technology Services
+ *                     University of Illinois at Urbana-Champaign
+ *                     https://techservices.illinois.edu/
+ *
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal with the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimers.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimers in the
+ *   documentation and/or other materials provided with the distribution.
+ * - Neither the names of Technology Services, University of Illinois at
+ *   Urbana-Champaign, nor the names of its contributors may be used to
+ *   endorse or promote products derived from this Software without
+ *   specific prior written permission.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS WITH THE SOFTWARE.
+ */
+
+#pragma once
+#include <chrono>
+#include <ctime>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace UIUC {
+
+namespace XMLTooling {
+
+class StaleItemCache {
+
+public:
+    struct Item {
+        std::string value;
+        time_t expiration;
+        int version;
+        std::chrono::steady_clock::time_point storedAt;
+    };
+
+    StaleItemCache(std::chrono::milliseconds maxStaleness, size_t size, size_t maxBytes);
+    ~StaleItemCache() {}
+
+    void store(const std::string &context, const std::string &key, const std::string &value, time_t expiration, int version);
+    void touch(const std::string &context, const std::string &key, int version);
+    bool lookup(const std::string &context, const std::string &key, Item &item);
+    void updateExpiration(const std::string &context, time_t expiration);
+    void erase(const std::string &context, const std::string &key);
+    void erase(const std::string &context);
+
+    size_t getBytes() const;
+    unsigned long getServed() const;
+
+private:
+    // Every item, freshest first, as (context, key).
+    typedef std::list<std::pair<std::string, std::string>> ItemList;
+
+    struct Stored {
+        Item item;
+        size_t bytes;
+        ItemList::iterator order;
+    };
+
+    struct Entry {
+        std::unordered_map<std::string, Stored> items;
+        std::list<std::string>::iterator lru;
+    };
+
+    Entry& use(const std::string &context);
+    void drop(std::unordered_map<std::string, Entry>::iterator entry, std::unordered_map<std::string, Stored>::iterator it);
+    void dropContext(std::unordered_map<std::string, Entry>::iterator entry);
+    void prune();
+
+    size_t m_bytes;
+    std::unordered_map<std::string, Entry> m_entries;
+    ItemList m_items;
+    std::list<std::string> m_lru;
+    size_t m_maxBytes;
+    std::chrono::milliseconds m_maxStaleness;
+    mutable std::mutex m_mutex;
+    unsigned long m_served;
+    size_t m_size;
+};
+
+
+} // namespace XMLTooling
+} // namespace UIUC
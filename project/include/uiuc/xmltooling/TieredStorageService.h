@@ -0,0 +1,182 @@
+/* Copyright (c) 2018 University of Illinois Board of Trustees
+ * All rights reserved.
+ *
+ * Developed by:       Technology Services
+ *                     University of Illinois at Urbana-Champaign
+ *                     https://techservices.illinois.edu/
+ *
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal with the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimers.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimers in the
+ *   documentation and/or other materials provided with the distribution.
+ * - Neither the names of Technology Services, University of Illinois at
+ *   Urbana-Champaign, nor the names of its contributors may be used to
+ *   endorse or promote products derived from this Software without
+ *   specific prior written permission.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS WITH THE SOFTWARE.
+ */
+
+#pragma once
+#include <chrono>
+#include <ctime>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <xercesc/dom/DOMElement.hpp>
+#include <xmltooling/base.h>
+#include <xmltooling/logging.h>
+#include <xmltooling/util/StorageService.h>
+
+namespace UIUC {
+
+namespace XMLTooling {
+
+xmltooling::StorageService* TieredStorageServiceFactory(const xercesc::DOMElement* const & e, bool);
+
+class TieredStorageService : public xmltooling::StorageService {
+
+public:
+    struct Stats {
+        unsigned long hits;
+        unsigned long misses;
+        unsigned long evictions;
+        size_t entries;
+        size_t bytes;
+    };
+
+    ~TieredStorageService();
+
+    const Capabilities& getCapabilities() const {
+        return m_backend->getCapabilities();
+    }
+
+    bool createString(
+            const char* context,
+            const char* key,
+            const char* value,
+            time_t expiration
+     );
+    int readString(
+            const char* context,
+            const char* key,
+            std::string* pvalue = nullptr,
+            time_t* pexpiration = nullptr,
+            int version = 0
+    );
+    int updateString(
+            const char* context,
+            const char* key,
+            const char* value = nullptr,
+            time_t expiration = 0,
+            int version = 0
+    );
+    bool deleteString(
+            const char* context,
+            const char* key
+    );
+
+
+    bool createText(
+            const char* context,
+            const char* key,
+            const char* value,
+            time_t expiration
+        ) {
+        return createString(context, key, value, expiration);
+    }
+    int readText(
+            const char* context,
+            const char* key,
+            std::string* pvalue = nullptr,
+            time_t* pexpiration = nullptr,
+            int version = 0
+        ) {
+        return readString(context, key, pvalue, pexpiration, version);
+    }
+    int updateText(
+            const char* context,
+            const char* key,
+            const char* value = nullptr,
+            time_t expiration = 0,
+            int version = 0
+        ) {
+        return updateString(context, key, value, expiration, version);
+    }
+    bool deleteText(
+            const char* context,
+            const char* key
+        ) {
+        return deleteString(context, key);
+    }
+
+    void reap(const char* context) {
+        m_backend->reap(context);
+    }
+
+    void updateContext(const char* context, time_t expiration);
+    void deleteContext(const char* context);
+
+    Stats getStats() const;
+
+private:
+    TieredStorageService(const xercesc::DOMElement* e);
+
+    struct Entry {
+        std::string context;
+        std::string key;
+        std::string value;
+        bool hasValue;
+        int version;
+        time_t expiration;
+        std::chrono::steady_clock::time_point cachedAt;
+        std::list<std::string>::iterator lru;
+    };
+
+    const std::string getCacheKey(const char* context, const char* key) const;
+    void store(const char* context, const char* key, const char* value, int version, time_t expiration);
+    void erase(const std::string &cacheKey);
+    void logStats(bool force = false);
+
+    size_t m_bytes;
+    std::unordered_map<std::string, Entry> m_cache;
+    std::unordered_map<std::string, std::unordered_set<std::string>> m_contexts;
+    std::unique_ptr<xmltooling::StorageService> m_backend;
+    unsigned long m_deletes;
+    unsigned long m_evictions;
+    unsigned long m_hits;
+    xmltooling::logging::Category& m_log;
+    std::list<std::string> m_lru;
+    size_t m_maxBytes;
+    size_t m_maxEntries;
+    unsigned long m_misses;
+    mutable std::mutex m_mutex;
+    std::chrono::steady_clock::time_point m_statsLogged;
+    std::chrono::seconds m_statsInterval;
+    std::chrono::seconds m_ttl;
+
+    friend xmltooling::StorageService* TieredStorageServiceFactory(const xercesc::DOMElement* const &, bool);
+};
+
+
+} // namespace XMLTooling
+} // namespace UIUC
@@ -0,0 +1,147 @@
+/* Copyright (c) 2018 University of Illinois Board of Trustees
+ * All rights reserved.
+ *
+ * Developed by:       Technology Services
+ *                     University of Illinois at Urbana-Champaign
+ *                     https://techservices.illinois.edu/
+ *
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal with the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimers.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimers in the
+ *   documentation and/or other materials provided with the distribution.
+ * - Neither the names of Technology Services, University of Illinois at
+ *   Urbana-Champaign, nor the names of its contributors may be used to
+ *   endorse or promote products derived from this Software without
+ *   specific prior written permission.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS WITH THE SOFTWARE.
+ */
+
+#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <ctime>
+#include <deque>
+#include <fstream>
+#include <istream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <xmltooling/logging.h>
+
+namespace UIUC {
+
+namespace XMLTooling {
+
+class TraceRecorder {
+
+public:
+    enum Operation {
+        CREATE_STRING = 1,
+        READ_STRING = 2,
+        UPDATE_STRING = 3,
+        DELETE_STRING = 4,
+        UPDATE_CONTEXT = 5,
+        DELETE_CONTEXT = 6
+    };
+
+    enum Flags {
+        NO_VALUE = 1
+    };
+
+    enum Outcome {
+        SUCCESS = 0,
+        NOT_FOUND = 1,
+        CONFLICT = 2,
+        FAILURE = 3
+    };
+
+    struct Record {
+        uint64_t timestamp;
+        uint64_t contextHash;
+        uint64_t keyHash;
+        uint32_t valueSize;
+        int32_t expiration;
+        int32_t version;
+        uint32_t latency;
+        uint8_t operation;
+        uint8_t outcome;
+        uint8_t flags;
+    };
+
+    class Scope {
+
+    public:
+        Scope(
+            TraceRecorder* recorder,
+            Operation operation,
+            const char* context,
+            const char* key = nullptr,
+            size_t valueSize = 0,
+            time_t expiration = 0,
+            int version = 0,
+            bool hasValue = true
+        );
+        ~Scope();
+
+        void finish(Outcome outcome, size_t valueSize = 0);
+
+    private:
+        bool m_finished;
+        TraceRecorder* m_recorder;
+        Record m_record;
+        std::chrono::steady_clock::time_point m_start;
+    };
+
+    TraceRecorder(const std::string &path, size_t maxSize, unsigned int maxFiles, size_t queueSize);
+    ~TraceRecorder();
+
+    void record(const Record &record);
+
+    static uint64_t hash(const char* value);
+    static bool readHeader(std::istream &in);
+    static bool readRecord(std::istream &in, Record &record);
+
+    static const size_t RECORD_SIZE = 48;
+
+private:
+    void run();
+    bool openFile();
+    void rotate();
+    void write(const Record &record);
+
+    std::condition_variable m_cond;
+    unsigned long m_dropped;
+    std::ofstream m_file;
+    size_t m_fileSize;
+    xmltooling::logging::Category& m_log;
+    unsigned int m_maxFiles;
+    size_t m_maxSize;
+    std::mutex m_mutex;
+    std::string m_path;
+    std::deque<Record> m_queue;
+    size_t m_queueSize;
+    bool m_shutdown;
+    std::thread m_writer;
+};
+
+
+} // namespace XMLTooling
+} // namespace UIUC
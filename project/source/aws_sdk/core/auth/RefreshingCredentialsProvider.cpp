@@ -0,0 +1,163 @@
+/* Copyright (c) 2018 University of Illinois Board of Trustees
+ * All rights reserved.
+ *
+ * Developed by:       Technology Services
+ *                     University of Illinois at Urbana-Champaign
+ *                     https://techservices.illinois.edu/
+ *
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal with the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimers.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimers in the
+ *   documentation and/or other materials provided with the distribution.
+ * - Neither the names of Technology Services, University of Illinois at
+ *   Urbana-Champaign, nor the names of its contributors may be used to
+ *   endorse or promote products derived from this Software without
+ *   specific prior written permission.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS WITH THE SOFTWARE.
+ */
+
+#include <uiuc/aws_sdk/core/auth/RefreshingCredentialsProvider.h>
+
+#include <algorithm>
+#include <exception>
+
+using namespace std;
+using namespace xmltooling::logging;
+
+using Aws::Auth::AWSCredentials;
+using Aws::Auth::AWSCredentialsProvider;
+
+// After a failed refresh, try again after this long, doubling with each
+// failure until it reaches the normal interval.
+static const chrono::seconds RETRY_MIN(1);
+
+
+namespace UIUC {
+
+namespace AWS_SDK {
+
+namespace Auth {
+
+RefreshingCredentialsProvider::RefreshingCredentialsProvider(
+    shared_ptr<AWSCredentialsProvider> provider,
+    chrono::seconds interval,
+    unsigned int alertFailures
+)
+    : m_alertFailures(alertFailures < 1 ? 1 : alertFailures),
+      m_failures(0),
+      m_interval(interval < RETRY_MIN ? RETRY_MIN : interval),
+      m_log(Category::getInstance("UIUC.AWS_SDK.Auth")),
+      m_provider(provider),
+      m_shutdown(false)
+{
+    // load once up front so the first request finds credentials waiting
+    refresh();
+
+    m_refresher = thread(&RefreshingCredentialsProvider::run, this);
+}
+
+
+RefreshingCredentialsProvider::~RefreshingCredentialsProvider()
+{
+    {
+        lock_guard<mutex> lock(m_mutex);
+        m_shutdown = true;
+    }
+    m_cond.notify_all();
+
+    if (m_refresher.joinable()) {
+        m_refresher.join();
+    }
+}
+
+
+AWSCredentials RefreshingCredentialsProvider::GetAWSCredentials()
+{
+    // The hot path only copies the current credentials. They are swapped
+    // as a whole by the refresher, so a request never sees half of an
+    // update and never waits on the metadata endpoint.
+    shared_ptr<const AWSCredentials> credentials = atomic_load(&m_credentials);
+    if (credentials) {
+        return *credentials;
+    }
+
+    // nothing has loaded yet; ask the wrapped provider like the SDK would
+    return m_provider->GetAWSCredentials();
+}
+
+
+bool RefreshingCredentialsProvider::refresh()
+{
+    AWSCredentials credentials;
+    try {
+        // The SDK providers cache what they load and only go back to the
+        // metadata endpoint or STS when that is about to expire, so
+        // asking often is cheap and moves those reloads onto this thread.
+        credentials = m_provider->GetAWSCredentials();
+    } catch (const exception &ex) {
+        m_log.warn("credentials provider threw an exception: %s", ex.what());
+    }
+
+    if (credentials.IsEmpty()) {
+        unsigned int failures = ++m_failures;
+        if (failures >= m_alertFailures) {
+            m_log.crit("unable to refresh AWS credentials after %u attempts; %s",
+                failures,
+                atomic_load(&m_credentials) ? "using the last credentials loaded" : "no credentials are available"
+            );
+        } else {
+            m_log.warn("unable to refresh AWS credentials (attempt=%u)", failures);
+        }
+        return false;
+    }
+
+    if (m_failures > 0) {
+        m_log.info("refreshed AWS credentials after %u failed attempts", m_failures.load());
+        m_failures = 0;
+    }
+    atomic_store(&m_credentials, shared_ptr<const AWSCredentials>(make_shared<AWSCredentials>(credentials)));
+    return true;
+}
+
+
+void RefreshingCredentialsProvider::run()
+{
+    unique_lock<mutex> lock(m_mutex);
+    while (!m_shutdown) {
+        chrono::seconds wait = m_interval;
+        if (m_failures > 0) {
+            unsigned int shift = min(m_failures.load() - 1, 16u);
+            wait = min(m_interval, RETRY_MIN * (1 << shift));
+        }
+
+        m_cond.wait_for(lock, wait, [this]{ return m_shutdown; });
+        if (m_shutdown) {
+            break;
+        }
+
+        lock.unlock();
+        refresh();
+        lock.lock();
+    }
+}
+
+} // namespace Auth
+} // namespace AWS_SDK
+} // namespace UIUC
@@ -0,0 +1,290 @@
+/* Copyright (c) 2018 University of Illinois Board of Trustees
+ * All rights reserved.
+ *
+ * Developed by:       Technology Services
+ *                     University of Illinois at Urbana-Champaign
+ *                     https://techservices.illinois.edu/
+ *
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal with the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimers.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimers in the
+ *   documentation and/or other materials provided with the distribution.
+ * - Neither the names of Technology Services, University of Illinois at
+ *   Urbana-Champaign, nor the names of its contributors may be used to
+ *   endorse or promote products derived from this Software without
+ *   specific prior written permission.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS WITH THE SOFTWARE.
+ */
+
+#include <uiuc/aws_sdk/core/http/curl/SharedCurlHttpClient.h>
+
+#include <algorithm>
+#include <aws/core/http/standard/StandardHttpRequest.h>
+#include <sys/socket.h>
+#include <uiuc/xmltooling/Deadline.h>
+#include <unistd.h>
+
+using namespace std;
+using namespace xmltooling::logging;
+
+using UIUC::XMLTooling::Deadline;
+
+using Aws::Http::HttpClient;
+using Aws::Http::HttpMethod;
+using Aws::Http::HttpRequest;
+using Aws::Http::URI;
+
+static const char* ALLOCATION_TAG = "ShibSharedCurlHttpClient";
+
+
+namespace UIUC {
+
+namespace AWS_SDK {
+
+namespace Http {
+
+SharedCurlState::SharedCurlState(bool http2, chrono::seconds statsInterval)
+    : m_http2(http2),
+      m_log(Category::getInstance("UIUC.AWS_SDK.Http")),
+      m_statsLogged(chrono::steady_clock::now()),
+      m_statsInterval(statsInterval)
+{
+    m_stats.requests = 0;
+    m_stats.connectionsOpened = 0;
+    m_stats.connectionsOpen = 0;
+    m_stats.connectionsPeak = 0;
+
+    // Every client's handles share one DNS cache and TLS session cache,
+    // so a new connection skips the lookup and the full TLS handshake.
+    // Connections themselves stay with the handle that opened them:
+    // curl doesn't support sharing its connection cache between handles
+    // that run at the same time on different threads, which the SDK's
+    // pooled handles do.
+    m_share = curl_share_init();
+    if (m_share) {
+        curl_share_setopt(m_share, CURLSHOPT_LOCKFUNC, &SharedCurlState::lock);
+        curl_share_setopt(m_share, CURLSHOPT_UNLOCKFUNC, &SharedCurlState::unlock);
+        curl_share_setopt(m_share, CURLSHOPT_USERDATA, this);
+
+        curl_share_setopt(m_share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+        curl_share_setopt(m_share, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+    } else {
+        m_log.error("unable to create a curl share handle; DNS and TLS sessions will not be shared");
+    }
+}
+
+
+SharedCurlState::~SharedCurlState()
+{
+    logStats(true);
+
+    if (m_share) {
+        curl_share_cleanup(m_share);
+    }
+}
+
+
+void SharedCurlState::configure(CURL* handle)
+{
+    if (m_share) {
+        curl_easy_setopt(handle, CURLOPT_SHARE, m_share);
+    }
+
+#if LIBCURL_VERSION_NUM >= 0x072f00
+    if (m_http2) {
+        // HTTP/2 where the endpoint offers it over ALPN, otherwise keep
+        // alive HTTP/1.1. Each handle performs its own requests, so they
+        // are never multiplexed on one connection.
+        curl_easy_setopt(handle, CURLOPT_HTTP_VERSION, static_cast<long>(CURL_HTTP_VERSION_2TLS));
+    } else {
+        curl_easy_setopt(handle, CURLOPT_HTTP_VERSION, static_cast<long>(CURL_HTTP_VERSION_1_1));
+    }
+#endif
+
+    curl_easy_setopt(handle, CURLOPT_OPENSOCKETFUNCTION, &SharedCurlState::openSocket);
+    curl_easy_setopt(handle, CURLOPT_OPENSOCKETDATA, this);
+    curl_easy_setopt(handle, CURLOPT_CLOSESOCKETFUNCTION, &SharedCurlState::closeSocket);
+    curl_easy_setopt(handle, CURLOPT_CLOSESOCKETDATA, this);
+
+    {
+        lock_guard<mutex> lock(m_statsMutex);
+        ++m_stats.requests;
+    }
+
+    logStats();
+}
+
+
+SharedCurlState::Stats SharedCurlState::getStats() const
+{
+    lock_guard<mutex> lock(m_statsMutex);
+    return m_stats;
+}
+
+
+void SharedCurlState::logStats(bool force)
+{
+    Stats stats;
+    {
+        lock_guard<mutex> lock(m_statsMutex);
+
+        auto now = chrono::steady_clock::now();
+        if (!force && (m_statsInterval.count() <= 0 || (now - m_statsLogged) < m_statsInterval)) {
+            return;
+        }
+        m_statsLogged = now;
+        stats = m_stats;
+    }
+
+    m_log.info("http connections: requests=%lu; opened=%lu; open=%lu; peak=%lu; requestsPerConnection=%.1f",
+        stats.requests,
+        stats.connectionsOpened,
+        stats.connectionsOpen,
+        stats.connectionsPeak,
+        stats.connectionsOpened ? static_cast<double>(stats.requests) / stats.connectionsOpened : 0.0
+    );
+}
+
+
+void SharedCurlState::lock(CURL*, curl_lock_data data, curl_lock_access, void* userptr)
+{
+    static_cast<SharedCurlState*>(userptr)->m_locks[data].lock();
+}
+
+
+void SharedCurlState::unlock(CURL*, curl_lock_data data, void* userptr)
+{
+    static_cast<SharedCurlState*>(userptr)->m_locks[data].unlock();
+}
+
+
+curl_socket_t SharedCurlState::openSocket(void* clientp, curlsocktype, struct curl_sockaddr* address)
+{
+    SharedCurlState* state = static_cast<SharedCurlState*>(clientp);
+
+    curl_socket_t sock = socket(address->family, address->socktype, address->protocol);
+    if (sock != CURL_SOCKET_BAD) {
+        lock_guard<mutex> lock(state->m_statsMutex);
+
+        ++state->m_stats.connectionsOpened;
+        ++state->m_stats.connectionsOpen;
+        if (state->m_stats.connectionsOpen > state->m_stats.connectionsPeak) {
+            state->m_stats.connectionsPeak = state->m_stats.connectionsOpen;
+        }
+    }
+
+    return sock;
+}
+
+
+int SharedCurlState::closeSocket(void* clientp, curl_socket_t item)
+{
+    SharedCurlState* state = static_cast<SharedCurlState*>(clientp);
+    {
+        lock_guard<mutex> lock(state->m_statsMutex);
+        if (state->m_stats.connectionsOpen > 0) {
+            --state->m_stats.connectionsOpen;
+        }
+    }
+
+    return close(item);
+}
+
+
+SharedCurlHttpClient::SharedCurlHttpClient(
+    const Aws::Client::ClientConfiguration &clientConfiguration,
+    shared_ptr<SharedCurlState> state
+)
+    : SharedCurlStateHolder(state),
+      CurlHttpClient(clientConfiguration)
+{
+}
+
+
+void SharedCurlHttpClient::OverrideOptionsOnConnectionHandle(CURL* handle) const
+{
+    m_state->configure(handle);
+
+    // Handles are reused, so this is set (or cleared) on every request.
+    // A request that is part of an operation with a deadline gets only
+    // the time that is left, and at least 1ms since 0 means no limit.
+    long timeoutMS = 0;
+    const Deadline* deadline = Deadline::getCurrent();
+    if (deadline && deadline->isLimited()) {
+        timeoutMS = max(deadline->getRemaining().count(), static_cast<chrono::milliseconds::rep>(1));
+    }
+    curl_easy_setopt(handle, CURLOPT_TIMEOUT_MS, timeoutMS);
+}
+
+
+SharedCurlHttpClientFactory::SharedCurlHttpClientFactory(bool http2, chrono::seconds statsInterval)
+    : m_http2(http2),
+      m_statsInterval(statsInterval)
+{
+}
+
+
+shared_ptr<HttpClient> SharedCurlHttpClientFactory::CreateHttpClient(
+    const Aws::Client::ClientConfiguration &clientConfiguration
+) const
+{
+    return Aws::MakeShared<SharedCurlHttpClient>(ALLOCATION_TAG, clientConfiguration, m_state);
+}
+
+
+shared_ptr<HttpRequest> SharedCurlHttpClientFactory::CreateHttpRequest(
+    const Aws::String &uri,
+    HttpMethod method,
+    const Aws::IOStreamFactory &streamFactory
+) const
+{
+    return CreateHttpRequest(URI(uri), method, streamFactory);
+}
+
+
+shared_ptr<HttpRequest> SharedCurlHttpClientFactory::CreateHttpRequest(
+    const URI &uri,
+    HttpMethod method,
+    const Aws::IOStreamFactory &streamFactory
+) const
+{
+    auto request = Aws::MakeShared<Aws::Http::Standard::StandardHttpRequest>(ALLOCATION_TAG, uri, method);
+    request->SetResponseStreamFactory(streamFactory);
+
+    return request;
+}
+
+
+void SharedCurlHttpClientFactory::InitStaticState()
+{
+    Aws::Http::CurlHttpClient::InitGlobalState();
+    m_state = make_shared<SharedCurlState>(m_http2, m_statsInterval);
+}
+
+
+void SharedCurlHttpClientFactory::CleanupStaticState()
+{
+    m_state.reset();
+    Aws::Http::CurlHttpClient::CleanupGlobalState();
+}
+
+} // namespace Http
+} // namespace AWS_SDK
+} // namespace UIUC
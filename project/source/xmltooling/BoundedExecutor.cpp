@@ -0,0 +1,368 @@
+/* Copyright (c) 2018 University of Illinois Board of Trustees
+ * All rights reserved.
+ *
+ * Developed by:       Technology Services
+ *                     University of Illinois at Urbana-Champaign
+ *                     https://techservices.illinois.edu/
+ *
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal with the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimers.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimers in the
+ *   documentation and/or other materials provided with the distribution.
+ * - Neither the names of Technology Services, University of Illinois at
+ *   Urbana-Champaign, nor the names of its contributors may be used to
+ *   endorse or promote products derived from this Software without
+ *   specific prior written permission.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS WITH THE SOFTWARE.
+ */
+
+#include <uiuc/xmltooling/BoundedExecutor.h>
+
+#include <algorithm>
+#include <exception>
+#include <xmltooling/exceptions.h>
+
+using namespace xmltooling;
+using namespace std;
+
+
+namespace UIUC {
+
+namespace XMLTooling {
+
+// the executor whose worker is running on this thread, if any, and
+// the worker's index
+static thread_local const BoundedExecutor* t_current = nullptr;
+static thread_local unsigned int t_index = 0;
+
+
+BoundedExecutor::BoundedExecutor(unsigned int threads, size_t queueSize)
+    : m_log(logging::Category::getInstance("UIUC.XMLTooling.BoundedExecutor")),
+      m_next(0),
+      m_progress(0),
+      m_queued(0),
+      m_queueSize(queueSize < 1 ? 1 : queueSize),
+      m_shutdown(false),
+      m_stats()
+{
+    if (threads < 1) {
+        threads = 1;
+    }
+    m_stats.threads = threads;
+    m_stats.queueSize = m_queueSize;
+
+    for (unsigned int i = 0; i < threads; ++i) {
+        m_workers.push_back(unique_ptr<Worker>(new Worker()));
+    }
+    // every worker has to exist before any of them can steal
+    for (unsigned int i = 0; i < threads; ++i) {
+        m_workers[i]->thread = thread(&BoundedExecutor::run, this, i);
+    }
+}
+
+
+BoundedExecutor::~BoundedExecutor()
+{
+    {
+        lock_guard<mutex> lock(m_mutex);
+        m_shutdown = true;
+
+        if (m_queued > 0) {
+            m_log.info("finishing %d queued tasks", static_cast<int>(m_queued));
+        }
+    }
+    m_workCond.notify_all();
+    m_roomCond.notify_all();
+    m_progressCond.notify_all();
+
+    // the workers only exit once the queues are empty; SDK callers wait
+    // on futures that would otherwise never be set
+    for (auto &worker : m_workers) {
+        worker->thread.join();
+    }
+}
+
+
+// Never turns a task away: the SDK ignores the result of Submit, and a
+// rejected task would leave its caller waiting forever. When the queues
+// are full the caller waits for room instead. A worker can't just wait
+// for room it might be the one to make, so it runs queued tasks until
+// there is some, sleeping only while other threads have them all, and
+// it queues its own tasks where it will look for work first. Tasks only run right away on the caller once the executor
+// is shutting down.
+bool BoundedExecutor::SubmitToThread(function<void()> &&fn)
+{
+    const bool worker = isCurrent();
+
+    unique_lock<mutex> lock(m_mutex);
+    if (m_queued >= m_queueSize && !m_shutdown) {
+        ++m_stats.blocked;
+        if (worker) {
+            while (m_queued >= m_queueSize && !m_shutdown) {
+                const unsigned long progress = m_progress;
+                lock.unlock();
+                const bool ran = runQueued();
+                lock.lock();
+
+                if (!ran) {
+                    m_progressCond.wait(lock, [this, progress] {
+                        return m_progress != progress || m_queued < m_queueSize || m_shutdown;
+                    });
+                }
+            }
+        } else {
+            m_roomCond.wait(lock, [this] { return m_queued < m_queueSize || m_shutdown; });
+        }
+    }
+
+    if (!m_shutdown) {
+        ++m_queued;
+        ++m_stats.submitted;
+        m_stats.maxQueueDepth = max(m_stats.maxQueueDepth, m_queued);
+
+        Worker &target = *m_workers[worker ? t_index : m_next++ % m_workers.size()];
+        {
+            lock_guard<mutex> workerLock(target.mutex);
+            target.tasks.push_back(Task{ std::move(fn), chrono::steady_clock::now() });
+        }
+        ++m_progress;
+        lock.unlock();
+
+        m_workCond.notify_one();
+        m_progressCond.notify_all();
+        return true;
+    }
+
+    ++m_stats.submitted;
+    ++m_stats.ranInline;
+    lock.unlock();
+
+    Task task{ std::move(fn), chrono::steady_clock::now() };
+    runTask(task);
+    return true;
+}
+
+
+BoundedExecutor::Stats BoundedExecutor::getStats() const
+{
+    lock_guard<mutex> lock(m_mutex);
+
+    Stats stats = m_stats;
+    stats.queueDepth = m_queued;
+    return stats;
+}
+
+
+void BoundedExecutor::logStats() const
+{
+    const Stats stats = getStats();
+
+    m_log.info("executor stats (threads=%u; queueDepth=%lu; maxQueueDepth=%lu; submitted=%lu; completed=%lu; helped=%lu; inline=%lu; stolen=%lu; blocked=%lu; avgQueueWait=%lldus; maxQueueWait=%lldus; avgRunTime=%lldus)",
+        stats.threads,
+        static_cast<unsigned long>(stats.queueDepth),
+        static_cast<unsigned long>(stats.maxQueueDepth),
+        stats.submitted,
+        stats.completed,
+        stats.helped,
+        stats.ranInline,
+        stats.stolen,
+        stats.blocked,
+        static_cast<long long>(stats.submitted > stats.ranInline ? stats.queueWait.count() / static_cast<long long>(stats.submitted - stats.ranInline) : 0),
+        static_cast<long long>(stats.maxQueueWait.count()),
+        static_cast<long long>(stats.completed > 0 ? stats.runTime.count() / static_cast<long long>(stats.completed) : 0)
+    );
+}
+
+
+// The first caller picks the size of the shared executor, which lives
+// for as long as anyone holds it. Asking for a different size while it
+// is held is a configuration error, not something to quietly ignore.
+shared_ptr<BoundedExecutor> BoundedExecutor::getShared(unsigned int threads, size_t queueSize)
+{
+    static mutex sharedMutex;
+    static weak_ptr<BoundedExecutor> shared;
+
+    lock_guard<mutex> lock(sharedMutex);
+    shared_ptr<BoundedExecutor> executor = shared.lock();
+    if (!executor) {
+        executor = make_shared<BoundedExecutor>(threads, queueSize);
+        shared = executor;
+    } else if (
+        executor->m_workers.size() != max(threads, 1u)
+        || executor->m_queueSize != max(queueSize, static_cast<size_t>(1))
+    ) {
+        executor->m_log.error("the shared executor has %d threads and a queue of %d, not %d threads and a queue of %d",
+            static_cast<int>(executor->m_workers.size()),
+            static_cast<int>(executor->m_queueSize),
+            static_cast<int>(threads),
+            static_cast<int>(queueSize)
+        );
+        throw XMLToolingException("DynamoDB Storage executorThreads and executorQueueSize must be the same for every service using the shared executor.");
+    }
+
+    return executor;
+}
+
+
+unsigned long BoundedExecutor::getProgress() const
+{
+    lock_guard<mutex> lock(m_mutex);
+    return m_progress;
+}
+
+
+bool BoundedExecutor::isCurrent() const
+{
+    return t_current == this;
+}
+
+
+void BoundedExecutor::run(unsigned int index)
+{
+    t_current = this;
+    t_index = index;
+
+    Task task;
+    while (takeTask(index, task)) {
+        runTask(task);
+    }
+}
+
+
+void BoundedExecutor::runTask(Task &task)
+{
+    auto start = chrono::steady_clock::now();
+    try {
+        task.fn();
+    } catch (const exception &ex) {
+        m_log.error("task failed: %s", ex.what());
+    } catch (...) {
+        m_log.error("task failed with an unknown exception");
+    }
+    auto runTime = chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - start);
+
+    task.fn = nullptr;
+
+    {
+        lock_guard<mutex> lock(m_mutex);
+        ++m_stats.completed;
+        m_stats.runTime += runTime;
+        ++m_progress;
+    }
+    m_progressCond.notify_all();
+}
+
+
+// Runs one queued task on a worker that is waiting for something else.
+// Returns false when there was none to take.
+bool BoundedExecutor::runQueued()
+{
+    Task task;
+    if (!tryTakeTask(t_index, task)) {
+        return false;
+    }
+
+    {
+        lock_guard<mutex> lock(m_mutex);
+        ++m_stats.helped;
+    }
+    runTask(task);
+    return true;
+}
+
+
+// Returns false once the executor is shutting down and every queue is
+// empty.
+bool BoundedExecutor::takeTask(unsigned int index, Task &task)
+{
+    while (true) {
+        const unsigned long progress = getProgress();
+        if (tryTakeTask(index, task)) {
+            return true;
+        }
+
+        unique_lock<mutex> lock(m_mutex);
+        if (m_queued == 0) {
+            if (m_shutdown) {
+                return false;
+            }
+            m_workCond.wait(lock, [this] { return m_queued > 0 || m_shutdown; });
+        } else {
+            // another worker has a task out of its queue but hasn't
+            // counted it yet, which it does before anything else
+            m_progressCond.wait(lock, [this, progress] { return m_progress != progress; });
+        }
+    }
+}
+
+
+// Takes the oldest task from the worker's own queue, or else steals the
+// newest task from another worker's queue.
+bool BoundedExecutor::tryTakeTask(unsigned int index, Task &task)
+{
+    const size_t count = m_workers.size();
+
+    for (size_t i = 0; i < count; ++i) {
+        Worker &worker = *m_workers[(index + i) % count];
+
+        unique_lock<mutex> workerLock(worker.mutex);
+        if (worker.tasks.empty()) {
+            continue;
+        }
+        if (i == 0) {
+            task = std::move(worker.tasks.front());
+            worker.tasks.pop_front();
+        } else {
+            task = std::move(worker.tasks.back());
+            worker.tasks.pop_back();
+        }
+        workerLock.unlock();
+
+        auto queueWait = chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - task.queuedAt);
+        {
+            lock_guard<mutex> lock(m_mutex);
+            --m_queued;
+            if (i != 0) {
+                ++m_stats.stolen;
+            }
+            m_stats.queueWait += queueWait;
+            m_stats.maxQueueWait = max(m_stats.maxQueueWait, queueWait);
+            ++m_progress;
+        }
+        m_roomCond.notify_one();
+        m_progressCond.notify_all();
+        return true;
+    }
+
+    return false;
+}
+
+
+// Sleeps until a task is queued, taken or finished after progress was
+// read.
+void BoundedExecutor::waitForProgress(unsigned long progress)
+{
+    unique_lock<mutex> lock(m_mutex);
+    m_progressCond.wait(lock, [this, progress] { return m_progress != progress; });
+}
+
+
+} // namespace XMLTooling
+} // namespace UIUC
@@ -0,0 +1,170 @@
+/* Copyright (c) 2018 University of Illinois Board of Trustees
+ * All rights reserved.
+ *
+ * Developed by:       Technology Services
+ *                     University of Illinois at Urbana-Champaign
+ *                     https://techservices.illinois.edu/
+ *
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal with the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimers.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimers in the
+ *   documentation and/or other materials provided with the distribution.
+ * - Neither the names of Technology Services, University of Illinois at
+ *   Urbana-Champaign, nor the names of its contributors may be used to
+ *   endorse or promote products derived from this Software without
+ *   specific prior written permission.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS WITH THE SOFTWARE.
+ */
+
+#include <uiuc/xmltooling/CapacityProfiler.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+
+using namespace xmltooling;
+using namespace std;
+
+// Contexts that end in an identifier at least this long (session IDs,
+// UUIDs) are grouped together by replacing it with a '*'.
+static const size_t GROUP_ID_LENGTH = 16;
+// Past this many operation and group pairs new groups are counted as
+// "(other)", so that odd context names cannot grow the table forever.
+static const size_t MAX_USAGE_ENTRIES = 1000;
+static const char* OTHER_GROUP = "(other)";
+
+
+namespace UIUC {
+
+namespace XMLTooling {
+
+CapacityProfiler::CapacityProfiler(chrono::seconds interval, unsigned int top)
+    : m_interval(interval),
+      m_log(logging::Category::getInstance("UIUC.XMLTooling.CapacityProfiler")),
+      m_logged(chrono::steady_clock::now()),
+      m_top(top)
+{
+}
+
+
+CapacityProfiler::~CapacityProfiler()
+{
+    logReport(true);
+}
+
+
+void CapacityProfiler::record(const char* operation, const char* context, bool write, double units)
+{
+    string group = getGroup(context);
+    {
+        lock_guard<mutex> lock(m_mutex);
+
+        string usageKey = string(operation) + '\0' + group;
+        auto it = m_usage.find(usageKey);
+        if (it == m_usage.end() && m_usage.size() >= MAX_USAGE_ENTRIES) {
+            group = OTHER_GROUP;
+            usageKey = string(operation) + '\0' + group;
+            it = m_usage.find(usageKey);
+        }
+
+        if (it == m_usage.end()) {
+            Usage usage = { operation, group, 0, 0.0, 0.0 };
+            it = m_usage.insert(make_pair(usageKey, usage)).first;
+        }
+
+        ++it->second.requests;
+        if (write) {
+            it->second.writeUnits += units;
+        } else {
+            it->second.readUnits += units;
+        }
+    }
+
+    logReport();
+}
+
+
+vector<CapacityProfiler::Usage> CapacityProfiler::getUsage() const
+{
+    vector<Usage> usage;
+    {
+        lock_guard<mutex> lock(m_mutex);
+
+        usage.reserve(m_usage.size());
+        for (const auto &it : m_usage) {
+            usage.push_back(it.second);
+        }
+    }
+
+    sort(usage.begin(), usage.end(), [](const Usage &a, const Usage &b) {
+        return (a.readUnits + a.writeUnits) > (b.readUnits + b.writeUnits);
+    });
+
+    return usage;
+}
+
+
+void CapacityProfiler::logReport(bool force)
+{
+    {
+        lock_guard<mutex> lock(m_mutex);
+
+        auto now = chrono::steady_clock::now();
+        if (!force && (m_interval.count() <= 0 || (now - m_logged) < m_interval)) {
+            return;
+        }
+        m_logged = now;
+    }
+
+    vector<Usage> usage = getUsage();
+    if (usage.empty()) {
+        return;
+    }
+
+    m_log.info("top %d of %d capacity consumers since startup", min(m_top, static_cast<unsigned int>(usage.size())), static_cast<int>(usage.size()));
+    for (size_t i = 0; i < usage.size() && i < m_top; ++i) {
+        m_log.info("capacity consumer (operation=%s; context=%s; requests=%lu; readUnits=%.1f; writeUnits=%.1f)",
+            usage[i].operation.c_str(),
+            usage[i].group.c_str(),
+            usage[i].requests,
+            usage[i].readUnits,
+            usage[i].writeUnits
+        );
+    }
+}
+
+
+string CapacityProfiler::getGroup(const char* context)
+{
+    size_t length = strlen(context);
+    size_t idStart = length;
+    while (idStart > 0 && (isxdigit(static_cast<unsigned char>(context[idStart - 1])) || context[idStart - 1] == '-')) {
+        --idStart;
+    }
+
+    if (length - idStart >= GROUP_ID_LENGTH) {
+        return string(context, idStart) + '*';
+    }
+    return context;
+}
+
+
+} // namespace XMLTooling
+} // namespace UIUC
@@ -0,0 +1,245 @@
+/* Copyright (c) 2018 University of Illinois Board of Trustees
+ * All rights reserved.
+ *
+ * Developed by:       Technology Services
+ *                     University of Illinois at Urbana-Champaign
+ *                     https://techservices.illinois.edu/
+ *
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal with the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimers.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimers in the
+ *   documentation and/or other materials provided with the distribution.
+ * - Neither the names of Technology Services, University of Illinois at
+ *   Urbana-Champaign, nor the names of its contributors may be used to
+ *   endorse or promote products derived from this Software without
+ *   specific prior written permission.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS WITH THE SOFTWARE.
+ */
+
+#include <uiuc/xmltooling/CircuitBreaker.h>
+
+#include <algorithm>
+
+using namespace xmltooling;
+using namespace std;
+
+
+namespace UIUC {
+
+namespace XMLTooling {
+
+static const int WINDOW_BUCKETS = 10;
+
+
+CircuitBreaker::CircuitBreaker(
+    const string& name,
+    int failureThreshold,
+    int failureRate,
+    chrono::milliseconds window,
+    chrono::milliseconds latencyThreshold,
+    chrono::milliseconds openInterval
+)
+    : m_buckets(WINDOW_BUCKETS, Bucket{-1, 0, 0}),
+      m_failureRate(failureRate),
+      m_failureThreshold(failureThreshold),
+      m_latencyThreshold(latencyThreshold),
+      m_log(logging::Category::getInstance("UIUC.XMLTooling.CircuitBreaker")),
+      m_name(name),
+      m_openInterval(openInterval),
+      m_probing(false),
+      m_state(CLOSED),
+      m_window(window)
+{
+}
+
+
+bool CircuitBreaker::allowRequest(bool& probe)
+{
+    lock_guard<mutex> lock(m_mutex);
+    auto now = chrono::steady_clock::now();
+    probe = false;
+
+    switch (m_state) {
+        case CLOSED:
+            return true;
+
+        case OPEN:
+            if (now - m_opened < m_openInterval) {
+                return false;
+            }
+
+            m_log.info("circuit half open; sending a probe request (endpoint=%s)", m_name.c_str());
+            m_state = HALF_OPEN;
+            m_probing = true;
+            m_probeStarted = now;
+            probe = true;
+            return true;
+
+        case HALF_OPEN:
+            // One probe at a time. A probe that never reports back (the
+            // caller threw) is given up on after another open interval.
+            if (m_probing && now - m_probeStarted < m_openInterval) {
+                return false;
+            }
+
+            m_probing = true;
+            m_probeStarted = now;
+            probe = true;
+            return true;
+    }
+
+    return true;
+}
+
+
+void CircuitBreaker::recordSuccess(chrono::milliseconds latency, bool probe)
+{
+    if (m_latencyThreshold.count() > 0 && latency >= m_latencyThreshold) {
+        m_log.debug("request took %lldms; counting it as a failure (endpoint=%s)",
+            static_cast<long long>(latency.count()),
+            m_name.c_str()
+        );
+        recordFailure(probe);
+        return;
+    }
+
+    lock_guard<mutex> lock(m_mutex);
+
+    // Only the probe says anything about the endpoint now. A request let
+    // through before the circuit opened may finish well after it did.
+    if (probe) {
+        if (m_state == HALF_OPEN && m_probing) {
+            m_log.notice("circuit closed; probe request succeeded (endpoint=%s)", m_name.c_str());
+            m_state = CLOSED;
+            m_probing = false;
+            for (auto &bucket : m_buckets) {
+                bucket = Bucket{-1, 0, 0};
+            }
+        }
+        return;
+    }
+
+    if (m_state == CLOSED) {
+        count(false);
+    }
+}
+
+
+void CircuitBreaker::recordFailure(bool probe)
+{
+    lock_guard<mutex> lock(m_mutex);
+
+    if (probe) {
+        if (m_state == HALF_OPEN && m_probing) {
+            open("probe request failed", 1, 1);
+        }
+        return;
+    }
+
+    if (m_state != CLOSED) {
+        return;
+    }
+
+    count(true);
+
+    int failures, requests;
+    countWindow(failures, requests);
+    if (failures >= m_failureThreshold && failures * 100 >= m_failureRate * requests) {
+        open("too many failed or slow requests", failures, requests);
+    }
+}
+
+
+CircuitBreaker::State CircuitBreaker::getState() const
+{
+    lock_guard<mutex> lock(m_mutex);
+    return m_state;
+}
+
+
+const char* CircuitBreaker::getStateName(State state)
+{
+    switch (state) {
+        case CLOSED:    return "closed";
+        case OPEN:      return "open";
+        case HALF_OPEN: return "half open";
+    }
+    return "unknown";
+}
+
+
+void CircuitBreaker::count(bool failed)
+{
+    const long long current = slice(chrono::steady_clock::now());
+
+    Bucket& bucket = m_buckets[current % WINDOW_BUCKETS];
+    if (bucket.slice != current) {
+        bucket = Bucket{current, 0, 0};
+    }
+
+    ++bucket.requests;
+    if (failed) {
+        ++bucket.failures;
+    }
+}
+
+
+void CircuitBreaker::countWindow(int& failures, int& requests) const
+{
+    const long long current = slice(chrono::steady_clock::now());
+
+    failures = 0;
+    requests = 0;
+    for (const auto &bucket : m_buckets) {
+        if (bucket.slice >= 0 && current - bucket.slice < WINDOW_BUCKETS) {
+            failures += bucket.failures;
+            requests += bucket.requests;
+        }
+    }
+}
+
+
+void CircuitBreaker::open(const char* reason, int failures, int requests)
+{
+    m_log.error("circuit open for %lldms; %s (endpoint=%s; failures=%d; requests=%d)",
+        static_cast<long long>(m_openInterval.count()),
+        reason,
+        m_name.c_str(),
+        failures,
+        requests
+    );
+
+    m_state = OPEN;
+    m_opened = chrono::steady_clock::now();
+    m_probing = false;
+    for (auto &bucket : m_buckets) {
+        bucket = Bucket{-1, 0, 0};
+    }
+}
+
+
+long long CircuitBreaker::slice(chrono::steady_clock::time_point time) const
+{
+    const long long width = max<long long>(1, m_window.count() / WINDOW_BUCKETS);
+    return chrono::duration_cast<chrono::milliseconds>(time.time_since_epoch()).count() / width;
+}
+
+} // namespace XMLTooling
+} // namespace UIUC
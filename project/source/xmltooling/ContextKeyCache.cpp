@@ -0,0 +1,213 @@
+/* Copyright (c) 2018 University of Illinois Board of Trustees
+ * All rights reserved.
+ *
+ * Developed by:       Technology Services
+ *                     University of Illinois at Urbana-Champaign
+ *                     https://techservices.illinois.edu/
+ *
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal with the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimers.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimers in the
+ *   documentation and/or other materials provided with the distribution.
+ * - Neither the names of Technology Services, University of Illinois at
+ *   Urbana-Champaign, nor the names of its contributors may be used to
+ *   endorse or promote products derived from this Software without
+ *   specific prior written permission.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS WITH THE SOFTWARE.
+ */
+
+#include <uiuc/xmltooling/ContextKeyCache.h>
+
+using namespace std;
+
+
+namespace UIUC {
+
+namespace XMLTooling {
+
+ContextKeyCache::ContextKeyCache(bool authoritative, chrono::seconds ttl, size_t size)
+    : m_authoritative(authoritative),
+      m_generation(0),
+      m_size(size < 1 ? 1 : size),
+      m_ttl(ttl)
+{
+}
+
+
+// Returns true and the unexpired keys when the cached list can be used
+// instead of a Query. Otherwise returns false and a generation to pass
+// to setKeys once the keys have been listed.
+bool ContextKeyCache::getKeys(const string &context, Keys &keys, unsigned long &generation)
+{
+    lock_guard<mutex> lock(m_mutex);
+
+    Entry &entry = touch(context);
+    generation = entry.generation;
+
+    if (!entry.complete) {
+        return false;
+    }
+    if (!m_authoritative && (chrono::steady_clock::now() - entry.listedAt) >= m_ttl) {
+        return false;
+    }
+
+    time_t now = time(nullptr);
+    keys.clear();
+    for (const auto &key : entry.keys) {
+        if (key.second.second == 0 || key.second.second > now) {
+            keys.push_back(make_pair(key.second.first, key.first));
+        }
+    }
+
+    return true;
+}
+
+
+// Stores the keys found by listing the context, or the new expiration
+// of the keys from getKeys. It is ignored if the context changed in
+// the meantime, since the list might be missing the change.
+void ContextKeyCache::setKeys(
+    const string &context,
+    const Keys &keys,
+    time_t expiration,
+    unsigned long generation,
+    bool listed
+)
+{
+    lock_guard<mutex> lock(m_mutex);
+
+    Entry &entry = touch(context);
+    if (entry.generation != generation) {
+        return;
+    }
+
+    entry.keys.clear();
+    for (const auto &key : keys) {
+        entry.keys[key.second] = make_pair(key.first, expiration);
+    }
+
+    entry.complete = true;
+    entry.generation = ++m_generation;
+    if (listed) {
+        entry.listedAt = chrono::steady_clock::now();
+    }
+}
+
+
+// A key created in a context the cache doesn't know might not be the
+// context's first: the entry could have been evicted, or the process
+// restarted. Only a list that came from a Query is ever complete.
+void ContextKeyCache::addKey(
+    const string &context,
+    const string &partition,
+    const string &key,
+    time_t expiration
+)
+{
+    lock_guard<mutex> lock(m_mutex);
+
+    auto it = m_entries.find(context);
+    if (it == m_entries.end()) {
+        return;
+    }
+
+    Entry &entry = touch(context);
+    entry.keys[key] = make_pair(partition, expiration);
+    entry.generation = ++m_generation;
+}
+
+
+void ContextKeyCache::removeKey(const string &context, const string &key)
+{
+    lock_guard<mutex> lock(m_mutex);
+
+    auto it = m_entries.find(context);
+    if (it != m_entries.end()) {
+        it->second.keys.erase(key);
+        it->second.generation = ++m_generation;
+    }
+}
+
+
+// A key we did not know about means some other node wrote to the
+// context, so the cached list is no longer complete.
+void ContextKeyCache::checkKey(const string &context, const string &key)
+{
+    lock_guard<mutex> lock(m_mutex);
+
+    auto it = m_entries.find(context);
+    if (it != m_entries.end() && it->second.complete && it->second.keys.find(key) == it->second.keys.end()) {
+        it->second.complete = false;
+        it->second.generation = ++m_generation;
+    }
+}
+
+
+void ContextKeyCache::invalidate(const string &context)
+{
+    lock_guard<mutex> lock(m_mutex);
+
+    auto it = m_entries.find(context);
+    if (it != m_entries.end()) {
+        it->second.keys.clear();
+        it->second.complete = false;
+        it->second.generation = ++m_generation;
+    }
+}
+
+
+void ContextKeyCache::erase(const string &context)
+{
+    lock_guard<mutex> lock(m_mutex);
+
+    auto it = m_entries.find(context);
+    if (it != m_entries.end()) {
+        m_lru.erase(it->second.lru);
+        m_entries.erase(it);
+    }
+}
+
+
+ContextKeyCache::Entry& ContextKeyCache::touch(const string &context)
+{
+    auto it = m_entries.find(context);
+    if (it != m_entries.end()) {
+        m_lru.splice(m_lru.begin(), m_lru, it->second.lru);
+        return it->second;
+    }
+
+    while (m_entries.size() >= m_size) {
+        m_entries.erase(m_lru.back());
+        m_lru.pop_back();
+    }
+
+    m_lru.push_front(context);
+
+    Entry &entry = m_entries[context];
+    entry.complete = false;
+    entry.generation = ++m_generation;
+    entry.lru = m_lru.begin();
+
+    return entry;
+}
+
+
+} // namespace XMLTooling
+} // namespace UIUC
@@ -0,0 +1,249 @@
+/* Copyright (c) 2018 University of Illinois Board of Trustees
+ * All rights reserved.
+ *
+ * Developed by:       Technology Services
+ *                     University of Illinois at Urbana-Champaign
+ *                     https://techservices.illinois.edu/
+ *
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal with the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimers.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimers in the
+ *   documentation and/or other materials provided with the distribution.
+ * - Neither the names of Technology Services, University of Illinois at
+ *   Urbana-Champaign, nor the names of its contributors may be used to
+ *   endorse or promote products derived from this Software without
+ *   specific prior written permission.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS WITH THE SOFTWARE.
+ */
+
+#include <uiuc/xmltooling/ContextMutationQueue.h>
+
+#include <algorithm>
+#include <exception>
+
+using namespace xmltooling;
+using namespace std;
+
+
+namespace UIUC {
+
+namespace XMLTooling {
+
+ContextMutationQueue::ContextMutationQueue(
+    Apply apply,
+    unsigned int size,
+    unsigned int workers,
+    unsigned int attempts,
+    chrono::milliseconds backoff
+)
+    : m_apply(apply),
+      m_attempts(attempts < 1 ? 1 : attempts),
+      m_backoff(backoff),
+      m_log(logging::Category::getInstance("UIUC.XMLTooling.ContextMutationQueue")),
+      m_shutdown(false),
+      m_size(size)
+{
+    if (workers < 1) {
+        workers = 1;
+    }
+
+    for (unsigned int i = 0; i < workers; ++i) {
+        m_workers.push_back(thread(&ContextMutationQueue::run, this));
+    }
+}
+
+
+ContextMutationQueue::~ContextMutationQueue()
+{
+    {
+        lock_guard<mutex> lock(m_mutex);
+        m_shutdown = true;
+
+        if (!m_pending.empty()) {
+            m_log.info("flushing %d pending context mutations", static_cast<int>(m_pending.size()));
+        }
+    }
+    m_cond.notify_all();
+
+    // the workers only exit once everything pending has been applied
+    for (auto &worker : m_workers) {
+        worker.join();
+    }
+}
+
+
+bool ContextMutationQueue::enqueue(const string &context, bool remove, time_t expiration)
+{
+    {
+        lock_guard<mutex> lock(m_mutex);
+
+        auto pending = m_pending.find(context);
+        if (pending != m_pending.end()) {
+            // a pending delete makes any later update pointless
+            if (!pending->second.remove) {
+                pending->second.remove = remove;
+                pending->second.expiration = expiration;
+            }
+            return true;
+        }
+
+        if (m_shutdown || m_pending.size() >= m_size) {
+            return false;
+        }
+
+        Mutation mutation = { remove, expiration };
+        m_pending[context] = mutation;
+        m_order.push_back(context);
+    }
+    m_cond.notify_all();
+
+    return true;
+}
+
+
+bool ContextMutationQueue::isDeletePending(const string &context) const
+{
+    lock_guard<mutex> lock(m_mutex);
+
+    auto pending = m_pending.find(context);
+    if (pending != m_pending.end() && pending->second.remove) {
+        return true;
+    }
+
+    auto active = m_active.find(context);
+    return active != m_active.end() && active->second.remove;
+}
+
+
+void ContextMutationQueue::settle(const string &context)
+{
+    unique_lock<mutex> lock(m_mutex);
+    m_cond.wait(lock, [&]() { return m_active.find(context) == m_active.end(); });
+
+    auto pending = m_pending.find(context);
+    if (pending == m_pending.end()) {
+        return;
+    }
+
+    // apply it here, on the caller's thread, so that any error is the
+    // caller's to handle
+    Mutation mutation = pending->second;
+    m_pending.erase(pending);
+    m_order.erase(find(m_order.begin(), m_order.end(), context));
+    m_active[context] = mutation;
+    lock.unlock();
+
+    try {
+        m_apply(context, mutation.remove, mutation.expiration);
+    } catch (...) {
+        lock.lock();
+        m_active.erase(context);
+        if (m_pending.find(context) == m_pending.end()) {
+            m_pending[context] = mutation;
+            m_order.push_front(context);
+        }
+        lock.unlock();
+        m_cond.notify_all();
+
+        throw;
+    }
+
+    lock.lock();
+    m_active.erase(context);
+    lock.unlock();
+    m_cond.notify_all();
+}
+
+
+void ContextMutationQueue::flush()
+{
+    unique_lock<mutex> lock(m_mutex);
+    m_cond.wait(lock, [this]() { return m_pending.empty() && m_active.empty(); });
+}
+
+
+void ContextMutationQueue::run()
+{
+    unique_lock<mutex> lock(m_mutex);
+
+    while (true) {
+        // the oldest context that no other thread is working on
+        auto next = find_if(m_order.begin(), m_order.end(), [this](const string &context) {
+            return m_active.find(context) == m_active.end();
+        });
+        if (next == m_order.end()) {
+            if (m_shutdown && m_order.empty()) {
+                return;
+            }
+
+            m_cond.wait(lock);
+            continue;
+        }
+
+        const string context = *next;
+        m_order.erase(next);
+
+        auto pending = m_pending.find(context);
+        Mutation mutation = pending->second;
+        m_pending.erase(pending);
+        m_active[context] = mutation;
+        lock.unlock();
+
+        applyWithRetry(context, mutation);
+
+        lock.lock();
+        m_active.erase(context);
+        m_cond.notify_all();
+    }
+}
+
+
+void ContextMutationQueue::applyWithRetry(const string &context, const Mutation &mutation)
+{
+    for (unsigned int attempt = 1; ; ++attempt) {
+        try {
+            m_apply(context, mutation.remove, mutation.expiration);
+            return;
+        } catch (exception &ex) {
+            if (attempt >= m_attempts) {
+                m_log.error("%s context failed after %d attempts; dropping it (context=%s): %s",
+                    mutation.remove ? "delete" : "update",
+                    attempt,
+                    context.c_str(),
+                    ex.what()
+                );
+                return;
+            }
+
+            m_log.warn("%s context failed; retrying (context=%s; attempt=%d): %s",
+                mutation.remove ? "delete" : "update",
+                context.c_str(),
+                attempt,
+                ex.what()
+            );
+        }
+
+        this_thread::sleep_for(m_backoff * (1 << (attempt - 1)));
+    }
+}
+
+
+} // namespace XMLTooling
+} // namespace UIUC
@@ -0,0 +1,191 @@
+/* Copyright (c) 2018 University of Illinois Board of Trustees
+ * All rights reserved.
+ *
+ * Developed by:       Technology Services
+ *                     University of Illinois at Urbana-Champaign
+ *                     https://techservices.illinois.edu/
+ *
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal with the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimers.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimers in the
+ *   documentation and/or other materials provided with the distribution.
+ * - Neither the names of Technology Services, University of Illinois at
+ *   Urbana-Champaign, nor the names of its contributors may be used to
+ *   endorse or promote products derived from this Software without
+ *   specific prior written permission.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS WITH THE SOFTWARE.
+ */
+
+#include <uiuc/xmltooling/ContextPrefetchCache.h>
+
+#include <cstring>
+
+using namespace std;
+
+
+namespace UIUC {
+
+namespace XMLTooling {
+
+ContextPrefetchCache::ContextPrefetchCache(
+    const vector<string> &prefixes,
+    chrono::milliseconds ttl,
+    size_t size,
+    size_t maxItems
+)
+    : m_generation(0),
+      m_maxItems(maxItems),
+      m_prefixes(prefixes),
+      m_size(size < 1 ? 1 : size),
+      m_ttl(ttl)
+{
+}
+
+
+bool ContextPrefetchCache::matches(const char* context) const
+{
+    for (const auto &prefix : m_prefixes) {
+        if (strncmp(context, prefix.c_str(), prefix.length()) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+
+// FOUND and ABSENT answer the read from the cache. INCOMPLETE and
+// TOO_LARGE mean the key has to be read directly, and NOT_CACHED that the
+// context has to be fetched first, passing the generation to store.
+ContextPrefetchCache::Lookup ContextPrefetchCache::lookup(
+    const string &context,
+    const string &key,
+    Item &item,
+    unsigned long &generation
+)
+{
+    lock_guard<mutex> lock(m_mutex);
+
+    Entry &entry = touch(context);
+    if ((entry.complete || entry.tooLarge) && (chrono::steady_clock::now() - entry.fetchedAt) >= m_ttl) {
+        entry.items.clear();
+        entry.complete = false;
+        entry.generation = ++m_generation;
+        entry.tooLarge = false;
+    }
+    generation = entry.generation;
+
+    if (entry.tooLarge) {
+        return TOO_LARGE;
+    }
+    if (!entry.complete) {
+        return NOT_CACHED;
+    }
+
+    auto it = entry.items.find(key);
+    if (it == entry.items.end()) {
+        return ABSENT;
+    }
+    if (!it->second.complete) {
+        return INCOMPLETE;
+    }
+
+    item = it->second;
+    return FOUND;
+}
+
+
+// Ignored if the context was written to since the lookup, because the
+// fetched items might be missing the change.
+void ContextPrefetchCache::store(const string &context, Items &items, unsigned long generation)
+{
+    lock_guard<mutex> lock(m_mutex);
+
+    Entry &entry = touch(context);
+    if (entry.generation != generation) {
+        return;
+    }
+
+    entry.items.swap(items);
+    entry.complete = true;
+    entry.fetchedAt = chrono::steady_clock::now();
+    entry.generation = ++m_generation;
+}
+
+
+// Remembers for the TTL that the context has more than maxItems items, so
+// reads don't keep paying for a Query that is thrown away. Writes leave it
+// set; a context that shrinks is prefetched again once the TTL passes.
+void ContextPrefetchCache::storeTooLarge(const string &context, unsigned long generation)
+{
+    lock_guard<mutex> lock(m_mutex);
+
+    Entry &entry = touch(context);
+    if (entry.generation != generation) {
+        return;
+    }
+
+    entry.items.clear();
+    entry.complete = false;
+    entry.fetchedAt = chrono::steady_clock::now();
+    entry.generation = ++m_generation;
+    entry.tooLarge = true;
+}
+
+
+void ContextPrefetchCache::invalidate(const string &context)
+{
+    lock_guard<mutex> lock(m_mutex);
+
+    auto it = m_entries.find(context);
+    if (it != m_entries.end()) {
+        it->second.items.clear();
+        it->second.complete = false;
+        it->second.generation = ++m_generation;
+    }
+}
+
+
+ContextPrefetchCache::Entry& ContextPrefetchCache::touch(const string &context)
+{
+    auto it = m_entries.find(context);
+    if (it != m_entries.end()) {
+        m_lru.splice(m_lru.begin(), m_lru, it->second.lru);
+        return it->second;
+    }
+
+    while (m_entries.size() >= m_size) {
+        m_entries.erase(m_lru.back());
+        m_lru.pop_back();
+    }
+
+    m_lru.push_front(context);
+
+    Entry &entry = m_entries[context];
+    entry.complete = false;
+    entry.generation = ++m_generation;
+    entry.lru = m_lru.begin();
+    entry.tooLarge = false;
+
+    return entry;
+}
+
+
+} // namespace XMLTooling
+} // namespace UIUC
@@ -0,0 +1,137 @@
+/* Copyright (c) 2018 University of Illinois Board of Trustees
+ * All rights reserved.
+ *
+ * Developed by:       Technology Services
+ *                     University of Illinois at Urbana-Champaign
+ *                     https://techservices.illinois.edu/
+ *
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal with the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimers.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimers in the
+ *   documentation and/or other materials provided with the distribution.
+ * - Neither the names of Technology Services, University of Illinois at
+ *   Urbana-Champaign, nor the names of its contributors may be used to
+ *   endorse or promote products derived from this Software without
+ *   specific prior written permission.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS WITH THE SOFTWARE.
+ */
+
+#include <uiuc/xmltooling/Deadline.h>
+
+#include <algorithm>
+#include <thread>
+
+using namespace std;
+
+// The deadline of the operation running on this thread, which the HTTP
+// client and retry strategy use to cut requests and retries short.
+static thread_local const UIUC::XMLTooling::Deadline* currentDeadline = nullptr;
+
+
+namespace UIUC {
+
+namespace XMLTooling {
+
+Deadline::Scope::Scope(const Deadline* deadline)
+    : m_previous(currentDeadline)
+{
+    currentDeadline = deadline;
+}
+
+
+Deadline::Scope::~Scope()
+{
+    currentDeadline = m_previous;
+}
+
+
+Deadline::Deadline(chrono::milliseconds budget)
+    : m_expires(chrono::steady_clock::now() + budget),
+      m_limited(budget.count() > 0)
+{
+}
+
+
+bool Deadline::hasExpired() const
+{
+    return m_limited && chrono::steady_clock::now() >= m_expires;
+}
+
+
+chrono::milliseconds Deadline::getRemaining() const
+{
+    if (!m_limited) {
+        return chrono::milliseconds::max();
+    }
+
+    auto remaining = chrono::duration_cast<chrono::milliseconds>(m_expires - chrono::steady_clock::now());
+    return max(remaining, chrono::milliseconds(0));
+}
+
+
+const Deadline* Deadline::getCurrent()
+{
+    return currentDeadline;
+}
+
+
+// Backoff sleeps never outlast the current deadline; the next request
+// then fails its check instead of starting late.
+void Deadline::sleep(chrono::milliseconds delay)
+{
+    if (currentDeadline) {
+        delay = min(delay, currentDeadline->getRemaining());
+    }
+    if (delay.count() > 0) {
+        this_thread::sleep_for(delay);
+    }
+}
+
+
+DeadlineRetryStrategy::DeadlineRetryStrategy(shared_ptr<Aws::Client::RetryStrategy> strategy)
+    : m_strategy(strategy)
+{
+}
+
+
+// Don't start a retry that couldn't get past its backoff delay before
+// the current deadline.
+bool DeadlineRetryStrategy::ShouldRetry(const Aws::Client::AWSError<Aws::Client::CoreErrors>& error, long attemptedRetries) const
+{
+    if (!m_strategy->ShouldRetry(error, attemptedRetries)) {
+        return false;
+    }
+
+    const Deadline* deadline = currentDeadline;
+    if (deadline && deadline->isLimited()) {
+        long delay = m_strategy->CalculateDelayBeforeNextRetry(error, attemptedRetries);
+        return deadline->getRemaining().count() > delay;
+    }
+    return true;
+}
+
+
+long DeadlineRetryStrategy::CalculateDelayBeforeNextRetry(const Aws::Client::AWSError<Aws::Client::CoreErrors>& error, long attemptedRetries) const
+{
+    return m_strategy->CalculateDelayBeforeNextRetry(error, attemptedRetries);
+}
+
+} // namespace XMLTooling
+} // namespace UIUC
@@ -0,0 +1,121 @@
+/* Copyright (c) 2018 University of Illinois Board of Trustees
+ * All rights reserved.
+ *
+ * Developed by:       Technology Services
+ *                     University of Illinois at Urbana-Champaign
+ *                     https://techservices.illinois.edu/
+ *
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal with the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimers.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimers in the
+ *   documentation and/or other materials provided with the distribution.
+ * - Neither the names of Technology Services, University of Illinois at
+ *   Urbana-Champaign, nor the names of its contributors may be used to
+ *   endorse or promote products derived from this Software without
+ *   specific prior written permission.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS WITH THE SOFTWARE.
+ */
+
+#include <uiuc/xmltooling/DynamoDBEndpoint.h>
+
+using namespace std;
+
+using namespace Aws::DynamoDB;
+
+// how many consecutive failures before the endpoint is considered
+// unhealthy, and how long it stays that way before being tried again
+static const int FAILURE_THRESHOLD = 3;
+static const chrono::seconds FAILURE_RECOVERY_INTERVAL(30);
+
+// weight of the most recent request in the latency average
+static const double LATENCY_ALPHA = 0.2;
+// latency assumed for an endpoint that has never answered, so that it
+// ranks after every endpoint that has
+static const double UNTRIED_LATENCY = 10000.0;
+static const double UNHEALTHY_PENALTY = 1000000.0;
+
+
+namespace UIUC {
+
+namespace XMLTooling {
+
+DynamoDBEndpoint::DynamoDBEndpoint(
+    const string& name,
+    shared_ptr<DynamoDBClient> client,
+    bool primary,
+    shared_ptr<CircuitBreaker> breaker
+)
+    : m_breaker(breaker),
+      m_client(client),
+      m_failures(0),
+      m_latency(0.0),
+      m_measured(false),
+      m_name(name),
+      m_primary(primary)
+{
+}
+
+
+bool DynamoDBEndpoint::isHealthy() const
+{
+    lock_guard<mutex> lock(m_mutex);
+
+    return m_failures < FAILURE_THRESHOLD
+        || (chrono::steady_clock::now() - m_lastFailure) >= FAILURE_RECOVERY_INTERVAL;
+}
+
+
+double DynamoDBEndpoint::getScore() const
+{
+    lock_guard<mutex> lock(m_mutex);
+
+    double score = (m_measured ? m_latency : UNTRIED_LATENCY) * (1 + m_failures);
+    if (m_failures >= FAILURE_THRESHOLD && (chrono::steady_clock::now() - m_lastFailure) < FAILURE_RECOVERY_INTERVAL) {
+        score += UNHEALTHY_PENALTY;
+    }
+
+    return score;
+}
+
+
+void DynamoDBEndpoint::recordSuccess(chrono::milliseconds latency)
+{
+    lock_guard<mutex> lock(m_mutex);
+
+    if (!m_measured) {
+        m_latency = latency.count();
+        m_measured = true;
+    } else {
+        m_latency = LATENCY_ALPHA * latency.count() + (1 - LATENCY_ALPHA) * m_latency;
+    }
+    m_failures = 0;
+}
+
+
+void DynamoDBEndpoint::recordFailure()
+{
+    lock_guard<mutex> lock(m_mutex);
+
+    ++m_failures;
+    m_lastFailure = chrono::steady_clock::now();
+}
+
+} // namespace XMLTooling
+} // namespace UIUC
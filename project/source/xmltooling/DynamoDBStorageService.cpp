@@ -37,16 +37,33 @@
 
 #include <aws/core/auth/AWSCredentialsProvider.h>
 #include <aws/core/client/ClientConfiguration.h>
+#include <aws/core/client/DefaultRetryStrategy.h>
 #include <aws/core/utils/Outcome.h>
+#include <aws/dynamodb/model/BatchGetItemRequest.h>
 #include <aws/dynamodb/model/BatchWriteItemRequest.h>
 #include <aws/dynamodb/model/DeleteItemRequest.h>
+#include <aws/dynamodb/model/DescribeTableRequest.h>
 #include <aws/dynamodb/model/GetItemRequest.h>
 #include <aws/dynamodb/model/PutItemRequest.h>
 #include <aws/dynamodb/model/QueryRequest.h>
+#include <aws/dynamodb/model/ScanRequest.h>
+#include <aws/dynamodb/model/TransactWriteItemsRequest.h>
 #include <aws/dynamodb/model/UpdateItemRequest.h>
+#include <algorithm>
+#include <boost/algorithm/string.hpp>
 #include <boost/lexical_cast.hpp>
 #include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <future>
+#include <map>
+#include <set>
 #include <thread>
+#include <tuple>
+#include <uiuc/aws_sdk/core/auth/RefreshingCredentialsProvider.h>
+#include <uiuc/xmltooling/Deadline.h>
 #include <xercesc/util/XMLUniDefs.hpp>
 #include <xmltooling/unicode.h>
 #include <xmltooling/XMLToolingConfig.h>
@@ -59,30 +76,154 @@ using namespace std;
 
 using boost::lexical_cast;
 using boost::bad_lexical_cast;
+using UIUC::AWS_SDK::Auth::RefreshingCredentialsProvider;
 
 using namespace Aws::DynamoDB;
 using namespace Aws::DynamoDB::Model;
 
 static const char* ALLOCATION_TAG = "ShibDynamoDBStore";
-static const string CONTEXT( "Context" );
-static const string EXPIRES( "Expires" );
-static const string KEY( "Key" );
-static const string VALUE( "Value" );
-static const string VERSION( "Version" );
-
+static const string EMPTY_STRING;
+
+static const int DEFAULT_ASYNC_ATTEMPTS = 3;
+static const char* DEFAULT_ATTRIBUTE_NAMES = "legacy";
+static const int DEFAULT_ASYNC_BACKOFF_MS = 100;
+static const bool DEFAULT_ASYNC_CONTEXT_UPDATES = false;
+static const int DEFAULT_ASYNC_QUEUE_SIZE = 10000;
+static const int DEFAULT_ASYNC_WORKERS = 2;
 static const int DEFAULT_BATCH_BACKOFF_MAX = 1000;
 static const int DEFAULT_BATCH_BACKOFF_SCALE_FACTOR = 50;
-static const int DEFAULT_BATCH_SIZE = 5;
+static const int DEFAULT_BATCH_CONCURRENCY = 4;
+static const int DEFAULT_BATCH_SIZE = 25;
+static const int DEFAULT_BREAKER_FAILURES = 5;
+static const int DEFAULT_BREAKER_FAILURE_RATE = 50;
+static const int DEFAULT_BREAKER_LATENCY_MS = 0;
+static const int DEFAULT_BREAKER_OPEN_MS = 5000;
+static const int DEFAULT_BREAKER_WINDOW_MS = 10000;
+static const bool DEFAULT_CAPACITY_PROFILE = false;
+static const int DEFAULT_CAPACITY_PROFILE_INTERVAL = 300;
+static const int DEFAULT_CAPACITY_PROFILE_TOP = 10;
+static const int DEFAULT_CREDENTIALS_ALERT_FAILURES = 3;
+static const int DEFAULT_CREDENTIALS_REFRESH_INTERVAL = 0;
 static const int DEFAULT_CONNECT_TIMEOUT_MS = 1000;
+static const int DEFAULT_CONTEXT_TIMEOUT_MS = 0;
+static const char* DEFAULT_CONTEXT_KEY_CACHE = "off";
+static const int DEFAULT_CONTEXT_KEY_CACHE_SIZE = 10000;
+static const int DEFAULT_CONTEXT_KEY_CACHE_TTL = 60;
+static const int DEFAULT_EXECUTOR_QUEUE_SIZE = 1000;
+static const bool DEFAULT_EXECUTOR_SHARED = false;
+static const int DEFAULT_EXECUTOR_THREADS = 8;
+static const int DEFAULT_KEEP_ALIVE_INTERVAL = 0;
+static const int DEFAULT_PREFETCH_MAX_ITEMS = 32;
+static const int DEFAULT_PREFETCH_SIZE = 10000;
+static const int DEFAULT_PREFETCH_TTL_MS = 1000;
+static const int DEFAULT_READ_TIMEOUT_MS = 0;
 static const int DEFAULT_REQUEST_TIMEOUT_MS = 3000;
+static const int DEFAULT_MAX_CHUNKS = 1;
 static const int DEFAULT_MAX_CONNECTIONS = 25;
+static const int DEFAULT_MAX_RETRIES = 10;
 static const char* DEFAULT_TABLE_NAME = "shibsp_storage";
+static const int DEFAULT_STALE_IF_ERROR_BYTES = 16 * 1024 * 1024;
+static const int DEFAULT_STALE_IF_ERROR_MS = 0;
+static const int DEFAULT_STALE_IF_ERROR_SIZE = 10000;
+static const bool DEFAULT_TCP_KEEP_ALIVE = true;
+static const int DEFAULT_TCP_KEEP_ALIVE_INTERVAL_MS = 30000;
+static const int DEFAULT_TRACE_MAX_FILES = 4;
+static const int DEFAULT_TRACE_MAX_SIZE = 64*1024*1024;
+static const int DEFAULT_TRACE_QUEUE_SIZE = 10000;
 static const int DEFAULT_UPDATE_CONTEXT_WINDOW = 10*60;
 static const bool DEFAULT_VERIFY_SSL = true;
+static const bool DEFAULT_WARMUP = false;
+static const int DEFAULT_WRITE_TIMEOUT_MS = 0;
 
 static const unsigned int MAX_CONTEXT_SIZE = 255;
 static const unsigned int MAX_KEY_SIZE = 255;
 static const unsigned int MAX_ITEM_SIZE = 400 * 1024;
+static const unsigned int MAX_BATCH_SIZE = 25;
+static const unsigned int MAX_BATCH_GET_SIZE = 100;
+
+// A transaction is limited to 4MB, so that is as many full items as we
+// can write at once. Each chunk key gets a suffix no longer than this,
+// and a chunk can come up this many bytes short to keep a multibyte
+// character whole. The separator is rejected in keys, so a chunk key
+// can't be mistaken for one.
+static const int MAX_CHUNKS = 10;
+static const unsigned int CHUNK_KEY_OVERHEAD = 16;
+static const unsigned int CHUNK_UTF8_SLACK = 3;
+static const char* CHUNK_KEY_SEPARATOR = "\x1F";
+static const int CHUNK_UPDATE_ATTEMPTS = 3;
+static const int CHUNK_READ_ATTEMPTS = 3;
+
+// Comes between a sharded context and its shard number. It is rejected
+// in contexts, so a context can't be mistaken for a shard of another.
+static const char* SHARD_SEPARATOR = "\x1E";
+
+static bool hasPrefix(const char* context, const string &prefix)
+{
+    return strncmp(context, prefix.c_str(), prefix.length()) == 0;
+}
+
+static double getConsumedCapacity(const Aws::Vector<ConsumedCapacity> &capacity)
+{
+    double units = 0.0;
+    for (const auto &c : capacity) {
+        units += c.GetCapacityUnits();
+    }
+    return units;
+}
+
+static double getConsumedCapacity(const GetItemResult &result, const char* &operation)
+{
+    operation = "GetItem";
+    return result.GetConsumedCapacity().GetCapacityUnits();
+}
+
+static double getConsumedCapacity(const PutItemResult &result, const char* &operation)
+{
+    operation = "PutItem";
+    return result.GetConsumedCapacity().GetCapacityUnits();
+}
+
+static double getConsumedCapacity(const UpdateItemResult &result, const char* &operation)
+{
+    operation = "UpdateItem";
+    return result.GetConsumedCapacity().GetCapacityUnits();
+}
+
+static double getConsumedCapacity(const DeleteItemResult &result, const char* &operation)
+{
+    operation = "DeleteItem";
+    return result.GetConsumedCapacity().GetCapacityUnits();
+}
+
+static double getConsumedCapacity(const QueryResult &result, const char* &operation)
+{
+    operation = "Query";
+    return result.GetConsumedCapacity().GetCapacityUnits();
+}
+
+static double getConsumedCapacity(const ScanResult &result, const char* &operation)
+{
+    operation = "Scan";
+    return result.GetConsumedCapacity().GetCapacityUnits();
+}
+
+static double getConsumedCapacity(const BatchGetItemResult &result, const char* &operation)
+{
+    operation = "BatchGetItem";
+    return getConsumedCapacity(result.GetConsumedCapacity());
+}
+
+static double getConsumedCapacity(const BatchWriteItemResult &result, const char* &operation)
+{
+    operation = "BatchWriteItem";
+    return getConsumedCapacity(result.GetConsumedCapacity());
+}
+
+static double getConsumedCapacity(const TransactWriteItemsResult &result, const char* &operation)
+{
+    operation = "TransactWriteItems";
+    return getConsumedCapacity(result.GetConsumedCapacity());
+}
 
 
 namespace UIUC {
@@ -97,62 +238,281 @@ StorageService* DynamoDBStorageServiceFactory(const DOMElement* const & e, bool)
 
 DynamoDBStorageService::DynamoDBStorageService(const DOMElement* eRoot)
     : m_log(logging::Category::getInstance("UIUC.XMLTooling.DynamoDBStorageService")),
-      m_caps(
-          MAX_CONTEXT_SIZE,
-          MAX_KEY_SIZE,
-          MAX_ITEM_SIZE
-            - (CONTEXT.length() + MAX_CONTEXT_SIZE)
-            - (KEY.length() + MAX_KEY_SIZE)
-            - (EXPIRES.length() + 10)
-            - (VERSION.length() + 10)
-            - VALUE.length()
-      ),
       m_batchBackoffMax(DEFAULT_BATCH_BACKOFF_MAX),
-      m_batchBackoffScaleFactor(DEFAULT_BATCH_BACKOFF_SCALE_FACTOR)
+      m_batchBackoffScaleFactor(DEFAULT_BATCH_BACKOFF_SCALE_FACTOR),
+      m_asyncPending(0),
+      m_shutdown(false)
 {
     static const XMLCh x_ACCESS_KEY_ID[] = UNICODE_LITERAL_11(a,c,c,e,s,s,K,e,y,I,D);
+    static const XMLCh x_ASYNC_ATTEMPTS[] = UNICODE_LITERAL_13(a,s,y,n,c,A,t,t,e,m,p,t,s);
+    static const XMLCh x_ASYNC_CONTEXT_UPDATES[] = UNICODE_LITERAL_19(a,s,y,n,c,C,o,n,t,e,x,t,U,p,d,a,t,e,s);
+    static const XMLCh x_ASYNC_QUEUE_SIZE[] = UNICODE_LITERAL_14(a,s,y,n,c,Q,u,e,u,e,S,i,z,e);
+    static const XMLCh x_ASYNC_WORKERS[] = UNICODE_LITERAL_12(a,s,y,n,c,W,o,r,k,e,r,s);
+    static const XMLCh x_ATTRIBUTE_NAMES[] = UNICODE_LITERAL_14(a,t,t,r,i,b,u,t,e,N,a,m,e,s);
+    static const XMLCh x_BATCH_CONCURRENCY[] = UNICODE_LITERAL_16(b,a,t,c,h,C,o,n,c,u,r,r,e,n,c,y);
     static const XMLCh x_BATCH_SIZE[] = UNICODE_LITERAL_9(b,a,t,c,h,S,i,z,e);
+    static const XMLCh x_BREAKER_FAILURES[] = UNICODE_LITERAL_15(b,r,e,a,k,e,r,F,a,i,l,u,r,e,s);
+    static const XMLCh x_BREAKER_FAILURE_RATE[] = UNICODE_LITERAL_18(b,r,e,a,k,e,r,F,a,i,l,u,r,e,R,a,t,e);
+    static const XMLCh x_BREAKER_LATENCY_MS[] = UNICODE_LITERAL_16(b,r,e,a,k,e,r,L,a,t,e,n,c,y,M,S);
+    static const XMLCh x_BREAKER_OPEN_MS[] = UNICODE_LITERAL_13(b,r,e,a,k,e,r,O,p,e,n,M,S);
+    static const XMLCh x_BREAKER_WINDOW_MS[] = UNICODE_LITERAL_15(b,r,e,a,k,e,r,W,i,n,d,o,w,M,S);
     static const XMLCh x_CA_FILE[] = UNICODE_LITERAL_6(c,a,F,i,l,e);
     static const XMLCh x_CA_PATH[] = UNICODE_LITERAL_6(c,a,P,a,t,h);
+    static const XMLCh x_CAPACITY_PROFILE[] = UNICODE_LITERAL_15(c,a,p,a,c,i,t,y,P,r,o,f,i,l,e);
+    static const XMLCh x_CAPACITY_PROFILE_INTERVAL[] = UNICODE_LITERAL_23(c,a,p,a,c,i,t,y,P,r,o,f,i,l,e,I,n,t,e,r,v,a,l);
+    static const XMLCh x_CAPACITY_PROFILE_TOP[] = UNICODE_LITERAL_18(c,a,p,a,c,i,t,y,P,r,o,f,i,l,e,T,o,p);
     static const XMLCh x_CONNECT_TIMEOUT_MS[] = UNICODE_LITERAL_16(c,o,n,n,e,c,t,T,i,m,e,o,u,t,M,S);
+    static const XMLCh x_CONTEXT_KEY_CACHE[] = UNICODE_LITERAL_15(c,o,n,t,e,x,t,K,e,y,C,a,c,h,e);
+    static const XMLCh x_CONTEXT_KEY_CACHE_SIZE[] = UNICODE_LITERAL_19(c,o,n,t,e,x,t,K,e,y,C,a,c,h,e,S,i,z,e);
+    static const XMLCh x_CONTEXT_KEY_CACHE_TTL[] = UNICODE_LITERAL_18(c,o,n,t,e,x,t,K,e,y,C,a,c,h,e,T,T,L);
+    static const XMLCh x_CONTEXT_TIMEOUT_MS[] = UNICODE_LITERAL_16(c,o,n,t,e,x,t,T,i,m,e,o,u,t,M,S);
     static const XMLCh x_CREDENTIALS[] = UNICODE_LITERAL_11(C,r,e,d,e,n,t,i,a,l,s);
+    static const XMLCh x_CREDENTIALS_ALERT_FAILURES[] = UNICODE_LITERAL_24(c,r,e,d,e,n,t,i,a,l,s,A,l,e,r,t,F,a,i,l,u,r,e,s);
+    static const XMLCh x_CREDENTIALS_REFRESH_INTERVAL[] = UNICODE_LITERAL_26(c,r,e,d,e,n,t,i,a,l,s,R,e,f,r,e,s,h,I,n,t,e,r,v,a,l);
     static const XMLCh x_ENDPOINT[] = UNICODE_LITERAL_8(e,n,d,p,o,i,n,t);
+    static const XMLCh x_EXECUTOR_QUEUE_SIZE[] = UNICODE_LITERAL_17(e,x,e,c,u,t,o,r,Q,u,e,u,e,S,i,z,e);
+    static const XMLCh x_EXECUTOR_SHARED[] = UNICODE_LITERAL_14(e,x,e,c,u,t,o,r,S,h,a,r,e,d);
+    static const XMLCh x_EXECUTOR_THREADS[] = UNICODE_LITERAL_15(e,x,e,c,u,t,o,r,T,h,r,e,a,d,s);
+    static const XMLCh x_KEEP_ALIVE_INTERVAL[] = UNICODE_LITERAL_17(k,e,e,p,A,l,i,v,e,I,n,t,e,r,v,a,l);
+    static const XMLCh x_KEYS_INDEX_NAME[] = UNICODE_LITERAL_13(k,e,y,s,I,n,d,e,x,N,a,m,e);
+    static const XMLCh x_ENDPOINT_ELEMENT[] = UNICODE_LITERAL_8(E,n,d,p,o,i,n,t);
+    static const XMLCh x_MAX_CHUNKS[] = UNICODE_LITERAL_9(m,a,x,C,h,u,n,k,s);
     static const XMLCh x_MAX_CONNECTIONS[] = UNICODE_LITERAL_14(m,a,x,C,o,n,n,e,c,t,i,o,n,s);
+    static const XMLCh x_MAX_RETRIES[] = UNICODE_LITERAL_10(m,a,x,R,e,t,r,i,e,s);
+    static const XMLCh x_PREFETCH[] = UNICODE_LITERAL_8(P,r,e,f,e,t,c,h);
+    static const XMLCh x_PREFETCH_MAX_ITEMS[] = UNICODE_LITERAL_16(p,r,e,f,e,t,c,h,M,a,x,I,t,e,m,s);
+    static const XMLCh x_PREFETCH_PREFIX[] = UNICODE_LITERAL_6(p,r,e,f,i,x);
+    static const XMLCh x_PREFETCH_SIZE[] = UNICODE_LITERAL_12(p,r,e,f,e,t,c,h,S,i,z,e);
+    static const XMLCh x_PREFETCH_TTL_MS[] = UNICODE_LITERAL_13(p,r,e,f,e,t,c,h,T,T,L,M,S);
+    static const XMLCh x_PRIMARY[] = UNICODE_LITERAL_7(p,r,i,m,a,r,y);
+    static const XMLCh x_READ_TIMEOUT_MS[] = UNICODE_LITERAL_13(r,e,a,d,T,i,m,e,o,u,t,M,S);
     static const XMLCh x_REGION[] = UNICODE_LITERAL_6(r,e,g,i,o,n);
     static const XMLCh x_REQUEST_TIMEOUT_MS[] = UNICODE_LITERAL_16(r,e,q,u,e,s,t,T,i,m,e,o,u,t,M,S);
+    static const XMLCh x_ROUTE[] = UNICODE_LITERAL_5(R,o,u,t,e);
+    static const XMLCh x_ROUTE_PREFIX[] = UNICODE_LITERAL_6(p,r,e,f,i,x);
     static const XMLCh x_SECRET_KEY[] = UNICODE_LITERAL_9(s,e,c,r,e,t,K,e,y);
     static const XMLCh x_SESSION_TOKEN[] = UNICODE_LITERAL_12(s,e,s,s,i,o,n,T,o,k,e,n);
+    static const XMLCh x_SHARD[] = UNICODE_LITERAL_5(S,h,a,r,d);
+    static const XMLCh x_SHARD_COUNT[] = UNICODE_LITERAL_5(c,o,u,n,t);
+    static const XMLCh x_SHARD_PREFIX[] = UNICODE_LITERAL_6(p,r,e,f,i,x);
+    static const XMLCh x_STALE_IF_ERROR_BYTES[] = UNICODE_LITERAL_17(s,t,a,l,e,I,f,E,r,r,o,r,B,y,t,e,s);
+    static const XMLCh x_STALE_IF_ERROR_MS[] = UNICODE_LITERAL_14(s,t,a,l,e,I,f,E,r,r,o,r,M,S);
+    static const XMLCh x_STALE_IF_ERROR_SIZE[] = UNICODE_LITERAL_16(s,t,a,l,e,I,f,E,r,r,o,r,S,i,z,e);
     static const XMLCh x_TABLE_NAME[] = UNICODE_LITERAL_9(t,a,b,l,e,N,a,m,e);
+    static const XMLCh x_TCP_KEEP_ALIVE[] = UNICODE_LITERAL_12(t,c,p,K,e,e,p,A,l,i,v,e);
+    static const XMLCh x_TCP_KEEP_ALIVE_INTERVAL_MS[] = UNICODE_LITERAL_22(t,c,p,K,e,e,p,A,l,i,v,e,I,n,t,e,r,v,a,l,M,S);
+    static const XMLCh x_TRACE_FILE[] = UNICODE_LITERAL_9(t,r,a,c,e,F,i,l,e);
+    static const XMLCh x_TRACE_MAX_FILES[] = UNICODE_LITERAL_13(t,r,a,c,e,M,a,x,F,i,l,e,s);
+    static const XMLCh x_TRACE_MAX_SIZE[] = UNICODE_LITERAL_12(t,r,a,c,e,M,a,x,S,i,z,e);
+    static const XMLCh x_TRACE_QUEUE_SIZE[] = UNICODE_LITERAL_14(t,r,a,c,e,Q,u,e,u,e,S,i,z,e);
     static const XMLCh x_UPDATE_CONTEXT_WINDOW[] = UNICODE_LITERAL_19(u,p,d,a,t,e,C,o,n,t,e,x,t,W,i,n,d,o,w);
     static const XMLCh x_VERIFY_SSL[] = UNICODE_LITERAL_9(v,e,r,i,f,y,S,S,L);
+    static const XMLCh x_WARMUP[] = UNICODE_LITERAL_6(w,a,r,m,u,p);
+    static const XMLCh x_WARMUP_CONNECTIONS[] = UNICODE_LITERAL_17(w,a,r,m,u,p,C,o,n,n,e,c,t,i,o,n,s);
+    static const XMLCh x_WRITE_TIMEOUT_MS[] = UNICODE_LITERAL_14(w,r,i,t,e,T,i,m,e,o,u,t,M,S);
 
     #ifdef _DEBUG
     NDC ndc("DynamoDBStorageService")
     #endif
 
     m_tableName = XMLHelper::getAttrString(eRoot, DEFAULT_TABLE_NAME, x_TABLE_NAME);
-    m_batchSize = XMLHelper::getAttrInt(eRoot, DEFAULT_BATCH_SIZE, x_BATCH_SIZE);
+    m_names = parseAttributeNames(XMLHelper::getAttrString(eRoot, DEFAULT_ATTRIBUTE_NAMES, x_ATTRIBUTE_NAMES));
+    m_keysIndexName = XMLHelper::getAttrString(eRoot, "", x_KEYS_INDEX_NAME);
+    {
+        int batchSize = XMLHelper::getAttrInt(eRoot, DEFAULT_BATCH_SIZE, x_BATCH_SIZE);
+        if (batchSize < 1 || batchSize > static_cast<int>(MAX_BATCH_SIZE)) {
+            m_log.warn("batchSize of %d is out of range; using %d", batchSize, MAX_BATCH_SIZE);
+            batchSize = MAX_BATCH_SIZE;
+        }
+        m_batchSize = batchSize;
+
+        int batchConcurrency = XMLHelper::getAttrInt(eRoot, DEFAULT_BATCH_CONCURRENCY, x_BATCH_CONCURRENCY);
+        m_batchConcurrency = batchConcurrency < 1 ? 1 : batchConcurrency;
+    }
     m_updateContextWindow = XMLHelper::getAttrInt(eRoot, DEFAULT_UPDATE_CONTEXT_WINDOW, x_UPDATE_CONTEXT_WINDOW);
 
+    m_readTimeout = chrono::milliseconds(XMLHelper::getAttrInt(eRoot, DEFAULT_READ_TIMEOUT_MS, x_READ_TIMEOUT_MS));
+    m_writeTimeout = chrono::milliseconds(XMLHelper::getAttrInt(eRoot, DEFAULT_WRITE_TIMEOUT_MS, x_WRITE_TIMEOUT_MS));
+    m_contextTimeout = chrono::milliseconds(XMLHelper::getAttrInt(eRoot, DEFAULT_CONTEXT_TIMEOUT_MS, x_CONTEXT_TIMEOUT_MS));
+
+    for (
+        const DOMElement* eShard = XMLHelper::getFirstChildElement(eRoot, x_SHARD);
+        eShard;
+        eShard = XMLHelper::getNextSiblingElement(eShard, x_SHARD)
+    ) {
+        const string prefix = XMLHelper::getAttrString(eShard, "", x_SHARD_PREFIX);
+        const int count = XMLHelper::getAttrInt(eShard, 0, x_SHARD_COUNT);
+
+        if (prefix.empty()) {
+            throw XMLToolingException("DynamoDB Storage requires a prefix for each Shard in configuration.");
+        }
+        if (count < 1) {
+            throw XMLToolingException("DynamoDB Storage requires a positive count for each Shard in configuration.");
+        }
+
+        m_shards.push_back(make_pair(prefix, count));
+    }
+
     {
-        const string endpoint = XMLHelper::getAttrString(eRoot, "", x_ENDPOINT);
-        const string region = XMLHelper::getAttrString(eRoot, "", x_REGION);
+        // a sharded context is stored with a separator and the shard
+        // number after it
+        unsigned int shardSuffix = 0;
+        for (const auto &shard : m_shards) {
+            if (shard.second > 1) {
+                const unsigned int suffix = strlen(SHARD_SEPARATOR) + lexical_cast<string>(shard.second - 1).length();
+                shardSuffix = max(shardSuffix, suffix);
+            }
+        }
 
-        if (endpoint.empty() && region.empty()) {
-            throw XMLToolingException("DynamoDB Storage requires either endpoint or region in configuration.");
+        unsigned int stringSize = MAX_ITEM_SIZE
+            - (m_names.context.length() + MAX_CONTEXT_SIZE + shardSuffix)
+            - (m_names.key.length() + MAX_KEY_SIZE)
+            - (m_names.expires.length() + 10)
+            - (m_names.version.length() + 10)
+            - m_names.value.length();
+
+        m_maxChunks = XMLHelper::getAttrInt(eRoot, DEFAULT_MAX_CHUNKS, x_MAX_CHUNKS);
+        if (m_maxChunks > MAX_CHUNKS) {
+            m_log.warn("maxChunks of %d is too large; using %d", m_maxChunks, MAX_CHUNKS);
+            m_maxChunks = MAX_CHUNKS;
+        }
+
+        if (m_maxChunks > 1) {
+            // every chunk item also carries the number of chunks and a
+            // suffix on its key
+            m_chunkSize = stringSize - (m_names.chunks.length() + 10) - CHUNK_KEY_OVERHEAD;
+            stringSize = (m_chunkSize - CHUNK_UTF8_SLACK) * m_maxChunks;
+        } else {
+            m_chunkSize = stringSize;
+        }
+
+        m_caps.reset(new Capabilities(MAX_CONTEXT_SIZE, MAX_KEY_SIZE, stringSize));
+    }
+
+    if (XMLHelper::getAttrBool(eRoot, DEFAULT_CAPACITY_PROFILE, x_CAPACITY_PROFILE)) {
+        m_profiler.reset(new CapacityProfiler(
+            chrono::seconds(XMLHelper::getAttrInt(eRoot, DEFAULT_CAPACITY_PROFILE_INTERVAL, x_CAPACITY_PROFILE_INTERVAL)),
+            XMLHelper::getAttrInt(eRoot, DEFAULT_CAPACITY_PROFILE_TOP, x_CAPACITY_PROFILE_TOP)
+        ));
+    }
+
+    {
+        const string traceFile = XMLHelper::getAttrString(eRoot, "", x_TRACE_FILE);
+        if (!traceFile.empty()) {
+            int traceMaxSize = XMLHelper::getAttrInt(eRoot, DEFAULT_TRACE_MAX_SIZE, x_TRACE_MAX_SIZE);
+            int traceMaxFiles = XMLHelper::getAttrInt(eRoot, DEFAULT_TRACE_MAX_FILES, x_TRACE_MAX_FILES);
+            int traceQueueSize = XMLHelper::getAttrInt(eRoot, DEFAULT_TRACE_QUEUE_SIZE, x_TRACE_QUEUE_SIZE);
+            if (traceMaxSize < 1 || traceMaxFiles < 1 || traceQueueSize < 1) {
+                throw XMLToolingException("DynamoDB Storage trace settings must be positive.");
+            }
+
+            m_log.info("recording operation trace (path=%s)", traceFile.c_str());
+            m_tracer.reset(new TraceRecorder(traceFile, traceMaxSize, traceMaxFiles, traceQueueSize));
+        }
+    }
+
+    {
+        int staleIfError = XMLHelper::getAttrInt(eRoot, DEFAULT_STALE_IF_ERROR_MS, x_STALE_IF_ERROR_MS);
+        if (staleIfError > 0) {
+            const int staleBytes = XMLHelper::getAttrInt(eRoot, DEFAULT_STALE_IF_ERROR_BYTES, x_STALE_IF_ERROR_BYTES);
+            if (staleBytes < 1) {
+                throw XMLToolingException("DynamoDB Storage staleIfErrorBytes must be positive.");
+            }
+
+            m_stale.reset(new StaleItemCache(
+                chrono::milliseconds(staleIfError),
+                XMLHelper::getAttrInt(eRoot, DEFAULT_STALE_IF_ERROR_SIZE, x_STALE_IF_ERROR_SIZE),
+                staleBytes
+            ));
+        }
+    }
+
+    {
+        const string keyCache = XMLHelper::getAttrString(eRoot, DEFAULT_CONTEXT_KEY_CACHE, x_CONTEXT_KEY_CACHE);
+        if (keyCache == "advisory" || keyCache == "authoritative") {
+            m_keyCache.reset(new ContextKeyCache(
+                keyCache == "authoritative",
+                chrono::seconds(XMLHelper::getAttrInt(eRoot, DEFAULT_CONTEXT_KEY_CACHE_TTL, x_CONTEXT_KEY_CACHE_TTL)),
+                XMLHelper::getAttrInt(eRoot, DEFAULT_CONTEXT_KEY_CACHE_SIZE, x_CONTEXT_KEY_CACHE_SIZE)
+            ));
+        } else if (keyCache != "off") {
+            throw XMLToolingException("DynamoDB Storage contextKeyCache must be off, advisory, or authoritative.");
+        }
+    }
+
+    {
+        vector<string> prefetchPrefixes;
+        for (
+            const DOMElement* ePrefetch = XMLHelper::getFirstChildElement(eRoot, x_PREFETCH);
+            ePrefetch;
+            ePrefetch = XMLHelper::getNextSiblingElement(ePrefetch, x_PREFETCH)
+        ) {
+            const string prefix = XMLHelper::getAttrString(ePrefetch, "", x_PREFETCH_PREFIX);
+            if (prefix.empty()) {
+                throw XMLToolingException("DynamoDB Storage requires a prefix for each Prefetch in configuration.");
+            }
+            prefetchPrefixes.push_back(prefix);
+        }
+
+        if (!prefetchPrefixes.empty()) {
+            m_prefetch.reset(new ContextPrefetchCache(
+                prefetchPrefixes,
+                chrono::milliseconds(XMLHelper::getAttrInt(eRoot, DEFAULT_PREFETCH_TTL_MS, x_PREFETCH_TTL_MS)),
+                XMLHelper::getAttrInt(eRoot, DEFAULT_PREFETCH_SIZE, x_PREFETCH_SIZE),
+                XMLHelper::getAttrInt(eRoot, DEFAULT_PREFETCH_MAX_ITEMS, x_PREFETCH_MAX_ITEMS)
+            ));
         }
-        m_clientConfig.endpointOverride = endpoint;
-        m_clientConfig.region = region;
+    }
+
+    {
         m_clientConfig.maxConnections = XMLHelper::getAttrInt(eRoot, DEFAULT_MAX_CONNECTIONS, x_MAX_CONNECTIONS);
 
         m_clientConfig.connectTimeoutMs = XMLHelper::getAttrInt(eRoot, DEFAULT_CONNECT_TIMEOUT_MS, x_CONNECT_TIMEOUT_MS);
         m_clientConfig.requestTimeoutMs = XMLHelper::getAttrInt(eRoot, DEFAULT_REQUEST_TIMEOUT_MS, x_REQUEST_TIMEOUT_MS);
+        m_clientConfig.retryStrategy = Aws::MakeShared<DeadlineRetryStrategy>(ALLOCATION_TAG,
+            Aws::MakeShared<Aws::Client::DefaultRetryStrategy>(ALLOCATION_TAG,
+                XMLHelper::getAttrInt(eRoot, DEFAULT_MAX_RETRIES, x_MAX_RETRIES)
+            )
+        );
+
+        m_clientConfig.enableTcpKeepAlive = XMLHelper::getAttrBool(eRoot, DEFAULT_TCP_KEEP_ALIVE, x_TCP_KEEP_ALIVE);
+        m_clientConfig.tcpKeepAliveIntervalMs = XMLHelper::getAttrInt(eRoot, DEFAULT_TCP_KEEP_ALIVE_INTERVAL_MS, x_TCP_KEEP_ALIVE_INTERVAL_MS);
 
         m_clientConfig.verifySSL = XMLHelper::getAttrBool(eRoot, DEFAULT_VERIFY_SSL, x_VERIFY_SSL);
         m_clientConfig.caFile = XMLHelper::getAttrString(eRoot, "", x_CA_FILE);
         m_clientConfig.caPath = XMLHelper::getAttrString(eRoot, "", x_CA_PATH);
     }
 
+    m_warmupConnections = XMLHelper::getAttrInt(eRoot, m_clientConfig.maxConnections, x_WARMUP_CONNECTIONS);
+    if (m_warmupConnections > static_cast<int>(m_clientConfig.maxConnections)) {
+        m_warmupConnections = m_clientConfig.maxConnections;
+    }
+    m_keepAliveInterval = chrono::seconds(XMLHelper::getAttrInt(eRoot, DEFAULT_KEEP_ALIVE_INTERVAL, x_KEEP_ALIVE_INTERVAL));
+
+    // Runs the async calls, the clients' own async work, and the fan out
+    // of context operations over partitions and batches. The SDK's
+    // default would start a thread for every task.
+    {
+        int executorThreads = XMLHelper::getAttrInt(eRoot, DEFAULT_EXECUTOR_THREADS, x_EXECUTOR_THREADS);
+        if (executorThreads < 1) {
+            m_log.warn("executorThreads of %d is out of range; using 1", executorThreads);
+            executorThreads = 1;
+        }
+        int executorQueueSize = XMLHelper::getAttrInt(eRoot, DEFAULT_EXECUTOR_QUEUE_SIZE, x_EXECUTOR_QUEUE_SIZE);
+        if (executorQueueSize < 1) {
+            m_log.warn("executorQueueSize of %d is out of range; using 1", executorQueueSize);
+            executorQueueSize = 1;
+        }
+
+        if (XMLHelper::getAttrBool(eRoot, DEFAULT_EXECUTOR_SHARED, x_EXECUTOR_SHARED)) {
+            m_executor = BoundedExecutor::getShared(executorThreads, executorQueueSize);
+        } else {
+            m_executor = make_shared<BoundedExecutor>(executorThreads, executorQueueSize);
+        }
+        m_clientConfig.executor = m_executor;
+    }
+
+    shared_ptr<Aws::Auth::AWSCredentials> credentials;
     const DOMElement* eCreds = XMLHelper::getFirstChildElement(eRoot, x_CREDENTIALS);
     if (eCreds) {
         const string accessKeyID = XMLHelper::getAttrString(eCreds, "", x_ACCESS_KEY_ID);
@@ -164,13 +524,255 @@ DynamoDBStorageService::DynamoDBStorageService(const DOMElement* eRoot)
         if (secretKey.empty())
             throw new XMLToolingException("DynamoDB Storage requires a secretKey in its Credentials configuration.");
 
-        m_client = Aws::MakeShared<DynamoDBClient>(ALLOCATION_TAG,
-            Aws::Auth::AWSCredentials(accessKeyID, secretKey, sessionToken),
-            m_clientConfig
+        credentials = Aws::MakeShared<Aws::Auth::AWSCredentials>(ALLOCATION_TAG, accessKeyID, secretKey, sessionToken);
+    }
+
+    // Without static credentials the default chain loads them from the
+    // environment, the EC2 or ECS metadata endpoints, or by assuming a
+    // role. Wrapping it keeps those reloads off the request threads.
+    shared_ptr<Aws::Auth::AWSCredentialsProvider> credentialsProvider;
+    if (!credentials) {
+        int refreshInterval = XMLHelper::getAttrInt(eRoot, DEFAULT_CREDENTIALS_REFRESH_INTERVAL, x_CREDENTIALS_REFRESH_INTERVAL);
+        if (refreshInterval > 0) {
+            credentialsProvider = Aws::MakeShared<RefreshingCredentialsProvider>(
+                ALLOCATION_TAG,
+                Aws::MakeShared<Aws::Auth::DefaultAWSCredentialsProviderChain>(ALLOCATION_TAG),
+                chrono::seconds(refreshInterval),
+                XMLHelper::getAttrInt(eRoot, DEFAULT_CREDENTIALS_ALERT_FAILURES, x_CREDENTIALS_ALERT_FAILURES)
+            );
+        }
+    }
+
+    // Each client gets its own breaker, so that a degraded endpoint or
+    // route fails fast without taking the others with it.
+    const int breakerFailures = XMLHelper::getAttrInt(eRoot, DEFAULT_BREAKER_FAILURES, x_BREAKER_FAILURES);
+    const int breakerFailureRate = XMLHelper::getAttrInt(eRoot, DEFAULT_BREAKER_FAILURE_RATE, x_BREAKER_FAILURE_RATE);
+    const chrono::milliseconds breakerLatency(XMLHelper::getAttrInt(eRoot, DEFAULT_BREAKER_LATENCY_MS, x_BREAKER_LATENCY_MS));
+    const chrono::milliseconds breakerOpen(XMLHelper::getAttrInt(eRoot, DEFAULT_BREAKER_OPEN_MS, x_BREAKER_OPEN_MS));
+    const chrono::milliseconds breakerWindow(XMLHelper::getAttrInt(eRoot, DEFAULT_BREAKER_WINDOW_MS, x_BREAKER_WINDOW_MS));
+    if (breakerFailures > 0 && breakerOpen.count() < 1) {
+        throw XMLToolingException("DynamoDB Storage breakerOpenMS must be positive.");
+    }
+    if (breakerFailures > 0 && (breakerFailureRate < 1 || breakerFailureRate > 100)) {
+        throw XMLToolingException("DynamoDB Storage breakerFailureRate must be between 1 and 100.");
+    }
+    if (breakerFailures > 0 && breakerWindow.count() < 1) {
+        throw XMLToolingException("DynamoDB Storage breakerWindowMS must be positive.");
+    }
+
+    // endpoint or region, and whether it is the primary
+    vector<tuple<string, string, bool>> endpointConfigs;
+    auto addEndpoint = [&](const DOMElement* e, bool primary) {
+        const string endpoint = XMLHelper::getAttrString(e, "", x_ENDPOINT);
+        const string region = XMLHelper::getAttrString(e, "", x_REGION);
+
+        if (endpoint.empty() && region.empty()) {
+            throw XMLToolingException("DynamoDB Storage requires either endpoint or region in configuration.");
+        }
+
+        endpointConfigs.push_back(make_tuple(endpoint, region, primary));
+    };
+
+    auto makeEndpoints = [&](const Aws::Client::ClientConfiguration &baseConfig) {
+        vector<shared_ptr<DynamoDBEndpoint>> endpoints;
+        for (const auto &endpointConfig : endpointConfigs) {
+            const string &endpoint = get<0>(endpointConfig);
+            const string &region = get<1>(endpointConfig);
+
+            Aws::Client::ClientConfiguration clientConfig = baseConfig;
+            clientConfig.endpointOverride = endpoint;
+            clientConfig.region = region;
+
+            shared_ptr<DynamoDBClient> client;
+            if (credentials) {
+                client = Aws::MakeShared<DynamoDBClient>(ALLOCATION_TAG, *credentials, clientConfig);
+            } else if (credentialsProvider) {
+                client = Aws::MakeShared<DynamoDBClient>(ALLOCATION_TAG, credentialsProvider, clientConfig);
+            } else {
+                client = Aws::MakeShared<DynamoDBClient>(ALLOCATION_TAG, clientConfig);
+            }
+
+            const string name = endpoint.empty() ? region : endpoint;
+            shared_ptr<CircuitBreaker> breaker;
+            if (breakerFailures > 0) {
+                breaker = make_shared<CircuitBreaker>(
+                    name,
+                    breakerFailures,
+                    breakerFailureRate,
+                    breakerWindow,
+                    breakerLatency,
+                    breakerOpen
+                );
+            }
+
+            endpoints.push_back(make_shared<DynamoDBEndpoint>(
+                name,
+                client,
+                get<2>(endpointConfig),
+                breaker
+            ));
+        }
+        return endpoints;
+    };
+
+    // Either a list of Endpoint elements, each with its own region or
+    // endpoint, or the region or endpoint on the root element.
+    const DOMElement* eEndpoint = XMLHelper::getFirstChildElement(eRoot, x_ENDPOINT_ELEMENT);
+    if (eEndpoint) {
+        bool hasPrimary = false;
+        for (; eEndpoint; eEndpoint = XMLHelper::getNextSiblingElement(eEndpoint, x_ENDPOINT_ELEMENT)) {
+            bool primary = XMLHelper::getAttrBool(eEndpoint, false, x_PRIMARY);
+            if (primary && hasPrimary) {
+                throw XMLToolingException("DynamoDB Storage allows only one primary Endpoint in configuration.");
+            }
+            hasPrimary = hasPrimary || primary;
+
+            addEndpoint(eEndpoint, primary);
+        }
+
+        if (!hasPrimary) {
+            throw XMLToolingException("DynamoDB Storage requires one primary Endpoint in configuration.");
+        }
+    } else {
+        addEndpoint(eRoot, true);
+
+        m_clientConfig.endpointOverride = XMLHelper::getAttrString(eRoot, "", x_ENDPOINT);
+        m_clientConfig.region = XMLHelper::getAttrString(eRoot, "", x_REGION);
+    }
+    m_endpoints = makeEndpoints(m_clientConfig);
+
+    // Contexts that start with a Route prefix go to their own table, and
+    // with any client settings on the Route, to their own clients and
+    // connection pools so they cannot tie up the shared ones.
+    for (
+        const DOMElement* eRoute = XMLHelper::getFirstChildElement(eRoot, x_ROUTE);
+        eRoute;
+        eRoute = XMLHelper::getNextSiblingElement(eRoute, x_ROUTE)
+    ) {
+        Route route;
+        route.prefix = XMLHelper::getAttrString(eRoute, "", x_ROUTE_PREFIX);
+        route.tableName = XMLHelper::getAttrString(eRoute, m_tableName.c_str(), x_TABLE_NAME);
+
+        if (route.prefix.empty()) {
+            throw XMLToolingException("DynamoDB Storage requires a prefix for each Route in configuration.");
+        }
+
+        if (
+            eRoute->hasAttributeNS(nullptr, x_MAX_CONNECTIONS)
+            || eRoute->hasAttributeNS(nullptr, x_CONNECT_TIMEOUT_MS)
+            || eRoute->hasAttributeNS(nullptr, x_REQUEST_TIMEOUT_MS)
+            || eRoute->hasAttributeNS(nullptr, x_MAX_RETRIES)
+        ) {
+            Aws::Client::ClientConfiguration routeConfig = m_clientConfig;
+            routeConfig.maxConnections = XMLHelper::getAttrInt(eRoute, m_clientConfig.maxConnections, x_MAX_CONNECTIONS);
+            routeConfig.connectTimeoutMs = XMLHelper::getAttrInt(eRoute, m_clientConfig.connectTimeoutMs, x_CONNECT_TIMEOUT_MS);
+            routeConfig.requestTimeoutMs = XMLHelper::getAttrInt(eRoute, m_clientConfig.requestTimeoutMs, x_REQUEST_TIMEOUT_MS);
+            if (eRoute->hasAttributeNS(nullptr, x_MAX_RETRIES)) {
+                routeConfig.retryStrategy = Aws::MakeShared<DeadlineRetryStrategy>(ALLOCATION_TAG,
+                    Aws::MakeShared<Aws::Client::DefaultRetryStrategy>(ALLOCATION_TAG,
+                        XMLHelper::getAttrInt(eRoute, DEFAULT_MAX_RETRIES, x_MAX_RETRIES)
+                    )
+                );
+            }
+
+            route.endpoints = makeEndpoints(routeConfig);
+            route.warmupConnections = min(m_warmupConnections, static_cast<int>(routeConfig.maxConnections));
+        } else {
+            route.warmupConnections = 0;
+        }
+
+        m_log.info("routing contexts to their own %s (prefix=%s; table=%s)",
+            route.endpoints.empty() ? "table" : "table and clients",
+            route.prefix.c_str(),
+            route.tableName.c_str()
         );
+        m_routes.push_back(route);
+    }
+
+    if (XMLHelper::getAttrBool(eRoot, DEFAULT_WARMUP, x_WARMUP)) {
+        // open the connections, resolve the credentials, and make sure
+        // the tables are usable before we start taking requests
+        warmEndpoints(true);
+    }
+
+    if (m_keepAliveInterval.count() > 0) {
+        m_keepAliveThread = thread(&DynamoDBStorageService::keepAlive, this);
+    }
+
+    if (XMLHelper::getAttrBool(eRoot, DEFAULT_ASYNC_CONTEXT_UPDATES, x_ASYNC_CONTEXT_UPDATES)) {
+        m_mutations.reset(new ContextMutationQueue(
+            [this](const string &context, bool remove, time_t expiration) {
+                if (remove) {
+                    applyDeleteContext(context.c_str());
+                } else {
+                    applyUpdateContext(context.c_str(), expiration);
+                }
+            },
+            XMLHelper::getAttrInt(eRoot, DEFAULT_ASYNC_QUEUE_SIZE, x_ASYNC_QUEUE_SIZE),
+            XMLHelper::getAttrInt(eRoot, DEFAULT_ASYNC_WORKERS, x_ASYNC_WORKERS),
+            XMLHelper::getAttrInt(eRoot, DEFAULT_ASYNC_ATTEMPTS, x_ASYNC_ATTEMPTS),
+            chrono::milliseconds(DEFAULT_ASYNC_BACKOFF_MS)
+        ));
+    }
+}
+
+
+DynamoDBStorageService::~DynamoDBStorageService()
+{
+    // async calls use this object until they finish, and might queue
+    // context changes of their own
+    {
+        unique_lock<mutex> lock(m_asyncMutex);
+        m_asyncCond.wait(lock, [this] { return m_asyncPending == 0; });
+    }
+
+    // apply anything still queued while the clients are still around
+    m_mutations.reset();
+
+    m_executor->logStats();
+
+    {
+        lock_guard<mutex> lock(m_keepAliveMutex);
+        m_shutdown = true;
+    }
+    m_keepAliveCond.notify_all();
+
+    if (m_keepAliveThread.joinable()) {
+        m_keepAliveThread.join();
+    }
+}
+
+
+// Either "legacy" (the original long names), "compact" (one character
+// each), or the context, key, value, expires, version and chunks names
+// separated by commas.
+DynamoDBStorageService::AttributeNames DynamoDBStorageService::parseAttributeNames(const string &names)
+{
+    vector<string> parts;
+    if (names == "legacy") {
+        parts = { "Context", "Key", "Value", "Expires", "Version", "Chunks" };
+    } else if (names == "compact") {
+        parts = { "C", "K", "V", "E", "N", "P" };
     } else {
-        m_client = Aws::MakeShared<DynamoDBClient>(ALLOCATION_TAG, m_clientConfig);
+        boost::split(parts, names, boost::is_any_of(","));
+        for (auto &part : parts) {
+            boost::trim(part);
+        }
+    }
+
+    set<string> unique(parts.begin(), parts.end());
+    if (parts.size() != 6 || unique.size() != 6 || unique.count("")) {
+        throw XMLToolingException("DynamoDB Storage attributeNames must be legacy, compact, or six different names.");
     }
+
+    AttributeNames result;
+    result.context = parts[0];
+    result.key = parts[1];
+    result.value = parts[2];
+    result.expires = parts[3];
+    result.version = parts[4];
+    result.chunks = parts[5];
+    return result;
 }
 
 
@@ -180,48 +782,88 @@ bool DynamoDBStorageService::createString(
     const char* value,
     time_t expiration
 )
+{
+    TraceRecorder::Scope trace(m_tracer.get(), TraceRecorder::CREATE_STRING, context, key, strlen(value), expiration);
+
+    bool created = createStringItem(context, key, value, expiration);
+    invalidatePrefetch(context);
+    if (m_stale && created) {
+        m_stale->store(context, key, value, expiration, 1);
+    }
+    trace.finish(created ? TraceRecorder::SUCCESS : TraceRecorder::CONFLICT);
+    return created;
+}
+
+
+bool DynamoDBStorageService::createStringItem(
+    const char* context,
+    const char* key,
+    const char* value,
+    time_t expiration
+)
 {
     #ifdef _DEBUG
     NDC ndc("createString")
     #endif
 
+    checkKey(context, key);
+
+    // the new key must not be removed by a delete queued before it
+    if (m_mutations && m_mutations->isDeletePending(context)) {
+        m_mutations->settle(context);
+    }
+
+    if (m_maxChunks > 1 && strlen(value) > m_chunkSize) {
+        // the key cache does not track chunk items
+        if (m_keyCache) {
+            m_keyCache->invalidate(context);
+        }
+        return createChunkedString(context, key, splitChunks(value), expiration);
+    }
+
     time_t now = time(nullptr);
+    const string partition = getPartition(context, key);
 
     PutItemRequest request;
-    request.SetTableName(m_tableName);
+    request.SetTableName(getTableName(context));
 
-    request.AddItem(CONTEXT, AttributeValue(context));
-    request.AddItem(KEY, AttributeValue(key));
-    request.AddItem(VALUE, AttributeValue(value));
+    request.AddItem(m_names.context, AttributeValue(partition));
+    request.AddItem(m_names.key, AttributeValue(key));
+    request.AddItem(m_names.value, AttributeValue(value));
 
-    request.AddItem(EXPIRES, AttributeValue().SetN(lexical_cast<string>(expiration)));
-    request.AddItem(VERSION, AttributeValue().SetN("1"));
+    request.AddItem(m_names.expires, AttributeValue().SetN(lexical_cast<string>(expiration)));
+    request.AddItem(m_names.version, AttributeValue().SetN("1"));
 
     // Make sure the new item doesn't already exist
-    request.AddExpressionAttributeNames("#C", CONTEXT);
-    request.AddExpressionAttributeNames("#K", KEY);
-    request.AddExpressionAttributeNames("#E", EXPIRES);
+    request.AddExpressionAttributeNames("#C", m_names.context);
+    request.AddExpressionAttributeNames("#K", m_names.key);
+    request.AddExpressionAttributeNames("#E", m_names.expires);
 
     request.AddExpressionAttributeValues(":now", AttributeValue().SetN(lexical_cast<string>(now)));
 
     request.SetConditionExpression("attribute_not_exists(#C) OR (attribute_exists(#C) AND attribute_not_exists(#K)) OR (attribute_exists(#C) AND attribute_exists(#K) AND #E <= :now)");
 
-    logRequest(request);
+    prepareRequest(request);
 
-    PutItemOutcome outcome = m_client->PutItem(request);
+    PutItemOutcome outcome = invoke<PutItemOutcome>(true, context, [&](const DynamoDBClient &client) {
+        return client.PutItem(request);
+    });
     if (!outcome.IsSuccess()) {
         const auto &error = outcome.GetError();
 
         if (error.GetErrorType() == DynamoDBErrors::CONDITIONAL_CHECK_FAILED) {
             m_log.error("create string failed because conditional check failed (table=%s; context=%s; key=%s)",
-                m_tableName.c_str(),
+                getTableName(context).c_str(),
                 context,
                 key
             );
+            if (m_keyCache) {
+                m_keyCache->checkKey(context, key);
+            }
             return false;
         } else {
             m_log.error("create string failed (table=%s; context=%s; key=%s)",
-                m_tableName.c_str(),
+                getTableName(context).c_str(),
                 context,
                 key
             );
@@ -230,6 +872,10 @@ bool DynamoDBStorageService::createString(
         }
     }
 
+    if (m_keyCache) {
+        m_keyCache->addKey(context, partition, key, expiration);
+    }
+
     return true;
 }
 
@@ -242,111 +888,316 @@ int DynamoDBStorageService::readString(
     int version
 )
 {
-    #ifdef _DEBUG
-    NDC ndc("readString")
-    #endif
+    TraceRecorder::Scope trace(m_tracer.get(), TraceRecorder::READ_STRING, context, key, 0, 0, version);
 
-    time_t now = time(nullptr);
-
-    if (pexpiration) {
-        *pexpiration = 0;
+    if (!m_stale) {
+        int itemVersion = readStringItem(context, key, pvalue, pexpiration, version);
+        trace.finish(itemVersion > 0 ? TraceRecorder::SUCCESS : TraceRecorder::NOT_FOUND, pvalue ? pvalue->size() : 0);
+        return itemVersion;
     }
-    if (pvalue) {
-        pvalue->erase();
-    }
-
-    GetItemRequest request;
-    request.SetTableName(m_tableName);
-    request.SetConsistentRead(true);
 
-    request.AddKey(CONTEXT, AttributeValue(context));
-    request.AddKey(KEY, AttributeValue(key));
-
-    logRequest(request);
+    // The expiration is always read so that it can be kept with the value.
+    time_t expiration = 0;
+    int itemVersion = 0;
+    try {
+        itemVersion = readStringItem(context, key, pvalue, &expiration, version);
+    } catch (const IOException&) {
+        // DynamoDB failed, timed out, or has its circuit open. Serve what
+        // this node last saw of the item if that is recent enough.
+        StaleItemCache::Item item;
+        if (!m_stale->lookup(context, key, item)) {
+            throw;
+        }
 
-    GetItemOutcome outcome = m_client->GetItem(request);
-    if (!outcome.IsSuccess()) {
-        m_log.error("read string failed for (table=%s; context=%s; key=%s)",
-            m_tableName.c_str(),
+        m_log.warn("read failed; serving a stale item (table=%s; context=%s; key=%s; age=%lldms; staleServes=%lu)",
+            getTableName(context).c_str(),
             context,
-            key
+            key,
+            static_cast<long long>(chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - item.storedAt).count()),
+            m_stale->getServed()
         );
-        logError(outcome.GetError());
-        throw IOException("DynamoDB Storage read string failed.");
-    }
 
-    const Item &item = outcome.GetResult().GetItem();
-    if (item.empty()) {
-        if (m_log.isDebugEnabled()) {
-            m_log.debug("read string returned no data (table=%s; context=%s; key=%s)",
-                m_tableName.c_str(),
-                context,
-                key
-            );
+        if (pvalue && item.version != version) {
+            *pvalue = item.value;
         }
-        return 0;
-    }
-
-    time_t itemExpires = getItemN<time_t>(context, key, item, EXPIRES);
-    if (itemExpires && itemExpires <= now) {
-        if (m_log.isDebugEnabled()) {
-            m_log.debug("read string returned expired item (table=%s; context=%s; key=%s)",
-                m_tableName.c_str(),
-                context,
-                key
-            );
+        if (pexpiration) {
+            *pexpiration = item.expiration;
         }
-        return 0;
-    } else if (pexpiration) {
-        *pexpiration = itemExpires;
+        trace.finish(TraceRecorder::SUCCESS, pvalue ? pvalue->size() : 0);
+        return item.version;
     }
 
-    int itemVersion = getItemN<int>(context, key, item, VERSION);
-    if (version && itemVersion && itemVersion == version) {
-        if (m_log.isDebugEnabled()) {
-            m_log.debug("read string detected no version change (table=%s; context=%s; key=%s)",
-                m_tableName.c_str(),
-                context,
-                key
-            );
-        }
-    } else if (pvalue) {
-        pvalue->append(getItemS(context, key, item, VALUE));
+    if (itemVersion == 0) {
+        m_stale->erase(context, key);
+    } else if (pvalue && itemVersion != version) {
+        m_stale->store(context, key, *pvalue, expiration, itemVersion);
+    } else {
+        m_stale->touch(context, key, itemVersion);
     }
 
+    if (pexpiration) {
+        *pexpiration = expiration;
+    }
+    trace.finish(itemVersion > 0 ? TraceRecorder::SUCCESS : TraceRecorder::NOT_FOUND, pvalue ? pvalue->size() : 0);
     return itemVersion;
 }
 
 
-int DynamoDBStorageService::updateString(
+int DynamoDBStorageService::readStringItem(
     const char* context,
     const char* key,
-    const char* value,
-    time_t expiration,
+    string* pvalue,
+    time_t* pexpiration,
     int version
 )
 {
     #ifdef _DEBUG
-    NDC ndc("updateString")
+    NDC ndc("readString")
     #endif
 
-    time_t now = time(nullptr);
+    checkKey(context, key);
 
-    UpdateItemRequest request;
-    request.SetTableName(m_tableName);
-    request.SetReturnValues(ReturnValue::UPDATED_NEW);
+    // a context queued for deletion is already gone as far as the
+    // caller is concerned
+    if (m_mutations && m_mutations->isDeletePending(context)) {
+        return 0;
+    }
 
-    request.AddKey(CONTEXT, AttributeValue(context));
-    request.AddKey(KEY, AttributeValue(key));
+    time_t now = time(nullptr);
 
-    request.AddExpressionAttributeNames("#C", CONTEXT);
-    request.AddExpressionAttributeNames("#K", KEY);
-    request.AddExpressionAttributeNames("#E", EXPIRES);
-    request.AddExpressionAttributeNames("#V", VERSION);
-    request.AddExpressionAttributeNames("#VALUE", VALUE);
+    if (pexpiration) {
+        *pexpiration = 0;
+    }
+    if (pvalue) {
+        pvalue->erase();
+    }
 
-    {
-        string conditionExpr = "attribute_exists(#C) AND attribute_exists(#K) AND #E > :now";
+    if (m_prefetch && m_prefetch->matches(context)) {
+        int itemVersion = 0;
+        if (readPrefetched(context, key, pvalue, pexpiration, version, itemVersion)) {
+            return itemVersion;
+        }
+    }
+
+    // every attempt comes out of the same read budget
+    Deadline readDeadline(m_readTimeout);
+    const Deadline* deadline = Deadline::getCurrent() ? Deadline::getCurrent() : &readDeadline;
+    Deadline::Scope deadlineScope(deadline);
+
+    int failedVersion = 0;
+    for (int attempt = 0; ; ++attempt) {
+        GetItemRequest request;
+        request.SetTableName(getTableName(context));
+        request.SetConsistentRead(true);
+
+        request.AddKey(m_names.context, AttributeValue(getPartition(context, key)));
+        request.AddKey(m_names.key, AttributeValue(key));
+
+        if (!pvalue) {
+            // don't transfer and parse a value nobody asked for
+            request.AddExpressionAttributeNames("#E", m_names.expires);
+            request.AddExpressionAttributeNames("#V", m_names.version);
+            request.SetProjectionExpression("#E, #V");
+        }
+
+        prepareRequest(request);
+
+        GetItemOutcome outcome = invoke<GetItemOutcome>(false, context, [&](const DynamoDBClient &client) {
+            return client.GetItem(request);
+        });
+        if (!outcome.IsSuccess()) {
+            m_log.error("read string failed for (table=%s; context=%s; key=%s)",
+                getTableName(context).c_str(),
+                context,
+                key
+            );
+            logError(outcome.GetError());
+            throw IOException("DynamoDB Storage read string failed.");
+        }
+
+        const Item &item = outcome.GetResult().GetItem();
+        if (item.empty()) {
+            if (m_log.isDebugEnabled()) {
+                m_log.debug("read string returned no data (table=%s; context=%s; key=%s)",
+                    getTableName(context).c_str(),
+                    context,
+                    key
+                );
+            }
+            return 0;
+        }
+
+        time_t itemExpires = getItemN<time_t>(context, key, item, m_names.expires);
+        if (itemExpires && itemExpires <= now) {
+            if (m_log.isDebugEnabled()) {
+                m_log.debug("read string returned expired item (table=%s; context=%s; key=%s)",
+                    getTableName(context).c_str(),
+                    context,
+                    key
+                );
+            }
+            return 0;
+        } else if (pexpiration) {
+            *pexpiration = itemExpires;
+        }
+
+        if (m_keyCache) {
+            m_keyCache->checkKey(context, key);
+        }
+
+        int itemVersion = getItemN<int>(context, key, item, m_names.version);
+        if (version && itemVersion && itemVersion == version) {
+            if (m_log.isDebugEnabled()) {
+                m_log.debug("read string detected no version change (table=%s; context=%s; key=%s)",
+                    getTableName(context).c_str(),
+                    context,
+                    key
+                );
+            }
+        } else if (pvalue) {
+            pvalue->append(getItemS(context, key, item, m_names.value));
+
+            int itemChunks = getChunks(item);
+            if (itemChunks > 1 && !readChunks(context, key, itemChunks, itemVersion, *pvalue)) {
+                // Chunks still missing or mismatched on a version that
+                // didn't change were lost to a failed write or expired
+                // on their own. The value can never be read again.
+                if (itemVersion == failedVersion) {
+                    m_log.error("read string chunks are missing; deleting the item (table=%s; context=%s; key=%s; version=%d)",
+                        getTableName(context).c_str(),
+                        context,
+                        key,
+                        itemVersion
+                    );
+                    deleteStringItem(context, key, itemVersion);
+                    invalidatePrefetch(context);
+                    if (pexpiration) {
+                        *pexpiration = 0;
+                    }
+                    pvalue->erase();
+                    return 0;
+                }
+                failedVersion = itemVersion;
+
+                // the item was updated between reading the first chunk and
+                // the rest of them, so start over while there is time
+                if (attempt + 1 >= CHUNK_READ_ATTEMPTS || deadline->hasExpired()) {
+                    m_log.error("read string chunks kept changing while reading (table=%s; context=%s; key=%s; attempts=%d)",
+                        getTableName(context).c_str(),
+                        context,
+                        key,
+                        attempt + 1
+                    );
+                    throw IOException("DynamoDB Storage read string failed.");
+                }
+
+                m_log.info("read string chunks changed while reading (table=%s; context=%s; key=%s)",
+                    getTableName(context).c_str(),
+                    context,
+                    key
+                );
+                if (pexpiration) {
+                    *pexpiration = 0;
+                }
+                pvalue->erase();
+                continue;
+            }
+        }
+
+        return itemVersion;
+    }
+}
+
+
+int DynamoDBStorageService::updateString(
+    const char* context,
+    const char* key,
+    const char* value,
+    time_t expiration,
+    int version
+)
+{
+    TraceRecorder::Scope trace(m_tracer.get(), TraceRecorder::UPDATE_STRING, context, key, value ? strlen(value) : 0, expiration, version, value != nullptr);
+
+    int itemVersion = updateStringItem(context, key, value, expiration, version);
+    invalidatePrefetch(context);
+    if (m_stale) {
+        // without a new value and expiration the stored copy is incomplete
+        if (itemVersion > 0 && value && expiration > 0) {
+            m_stale->store(context, key, value, expiration, itemVersion);
+        } else {
+            m_stale->erase(context, key);
+        }
+    }
+    if (itemVersion > 0) {
+        trace.finish(TraceRecorder::SUCCESS);
+    } else {
+        trace.finish(itemVersion == 0 ? TraceRecorder::NOT_FOUND : TraceRecorder::CONFLICT);
+    }
+    return itemVersion;
+}
+
+
+int DynamoDBStorageService::updateStringItem(
+    const char* context,
+    const char* key,
+    const char* value,
+    time_t expiration,
+    int version
+)
+{
+    #ifdef _DEBUG
+    NDC ndc("updateString")
+    #endif
+
+    checkKey(context, key);
+
+    if (m_mutations && m_mutations->isDeletePending(context)) {
+        return 0;
+    }
+
+    if (m_maxChunks > 1 && value && strlen(value) > m_chunkSize) {
+        if (m_keyCache) {
+            m_keyCache->invalidate(context);
+        }
+        const vector<string> chunks = splitChunks(value);
+        return updateChunkedString(context, key, &chunks, expiration, version);
+    } else if (m_maxChunks > 1 && !value) {
+        // the value might be in chunks, whose version and expiration
+        // have to move with the first item's
+        int itemVersion = updateChunkedString(context, key, nullptr, expiration, version);
+        if (itemVersion > 0 && m_keyCache && expiration > 0) {
+            m_keyCache->addKey(context, getPartition(context, key), key, expiration);
+        }
+        return itemVersion;
+    }
+
+    time_t now = time(nullptr);
+
+    // when the condition pins the version we already know the new one,
+    // and can skip reading back the (possibly large) updated value
+    const bool knownVersion = version > 0 && m_maxChunks <= 1;
+
+    UpdateItemRequest request;
+    request.SetTableName(getTableName(context));
+    // with chunking we need the old attributes to clean up the chunks
+    // of a larger value
+    if (m_maxChunks > 1) {
+        request.SetReturnValues(ReturnValue::ALL_OLD);
+    } else {
+        request.SetReturnValues(knownVersion ? ReturnValue::NONE : ReturnValue::UPDATED_NEW);
+    }
+
+    request.AddKey(m_names.context, AttributeValue(getPartition(context, key)));
+    request.AddKey(m_names.key, AttributeValue(key));
+
+    request.AddExpressionAttributeNames("#C", m_names.context);
+    request.AddExpressionAttributeNames("#K", m_names.key);
+    request.AddExpressionAttributeNames("#E", m_names.expires);
+    request.AddExpressionAttributeNames("#V", m_names.version);
+
+    {
+        string conditionExpr = "attribute_exists(#C) AND attribute_exists(#K) AND #E > :now";
         request.AddExpressionAttributeValues(":now", AttributeValue().SetN(lexical_cast<string>(now)));
 
         if (version > 0) {
@@ -358,34 +1209,49 @@ int DynamoDBStorageService::updateString(
     }
 
     {
-        string updateExpr = "SET #VALUE = :value, #V = #V + :one";
-        request.AddExpressionAttributeValues(":value", AttributeValue(value));
+        // without a value only the version and expiration change
+        string updateExpr = "SET #V = #V + :one";
         request.AddExpressionAttributeValues(":one", AttributeValue().SetN("1"));
 
+        if (value) {
+            updateExpr += ", #VALUE = :value";
+            request.AddExpressionAttributeNames("#VALUE", m_names.value);
+            request.AddExpressionAttributeValues(":value", AttributeValue(value));
+        }
+
         if (expiration > 0) {
             updateExpr += ", #E = :expires";
             request.AddExpressionAttributeValues(":expires", AttributeValue().SetN(lexical_cast<string>(expiration)));
         }
 
+        if (m_maxChunks > 1) {
+            updateExpr += " REMOVE #CH";
+            request.AddExpressionAttributeNames("#CH", m_names.chunks);
+        }
+
         request.SetUpdateExpression(updateExpr);
     }
 
-    logRequest(request);
+    prepareRequest(request);
 
-    UpdateItemOutcome outcome = m_client->UpdateItem(request);
+    UpdateItemOutcome outcome = invoke<UpdateItemOutcome>(true, context, [&](const DynamoDBClient &client) {
+        return client.UpdateItem(request);
+    });
     if (!outcome.IsSuccess()) {
         const auto &error = outcome.GetError();
 
         if (error.GetErrorType() == DynamoDBErrors::CONDITIONAL_CHECK_FAILED) {
             m_log.info("update string failed with condition check failure (table=%s; context=%s; key=%s)",
-                m_tableName.c_str(),
+                getTableName(context).c_str(),
                 context,
                 key
             );
 
             // see why the condition expression failed. Version
-            // mismatch or value doesn't exist?
-            int currVersion = this->readString(
+            // mismatch or value doesn't exist? Whatever was prefetched
+            // is out of date.
+            invalidatePrefetch(context);
+            int currVersion = readStringItem(
                 context,
                 key,
                 nullptr,
@@ -395,7 +1261,7 @@ int DynamoDBStorageService::updateString(
             return currVersion == 0 ? 0 : -1;
         } else {
             m_log.error("update string failed (table=%s; context=%s; key=%s)",
-                m_tableName.c_str(),
+                getTableName(context).c_str(),
                 context,
                 key
             );
@@ -404,11 +1270,18 @@ int DynamoDBStorageService::updateString(
         }
     }
 
+    if (knownVersion) {
+        if (m_keyCache && expiration > 0) {
+            m_keyCache->addKey(context, getPartition(context, key), key, expiration);
+        }
+        return version + 1;
+    }
+
     const Item &attrs = outcome.GetResult().GetAttributes();
     if (attrs.empty()) {
         if (m_log.isDebugEnabled()) {
             m_log.debug("update string returned no data (table=%s; context=%s; key=%s)",
-                m_tableName.c_str(),
+                getTableName(context).c_str(),
                 context,
                 key
             );
@@ -416,16 +1289,26 @@ int DynamoDBStorageService::updateString(
         return 0;
     }
 
-    int itemVersion = getItemN<int>(context, key, attrs, VERSION);
+    int itemVersion = getItemN<int>(context, key, attrs, m_names.version);
     if (itemVersion == 0) {
         m_log.error("update string returned attributes with invalid version (table=%s; context=%s; key=%s)",
-            m_tableName.c_str(),
+            getTableName(context).c_str(),
             context,
             key
         );
         return 0;
     }
 
+    if (m_keyCache && expiration > 0) {
+        m_keyCache->addKey(context, getPartition(context, key), key, expiration);
+    }
+
+    if (m_maxChunks > 1) {
+        // these are the old attributes
+        deleteChunks(context, key, 1, getChunks(attrs));
+        ++itemVersion;
+    }
+
     return itemVersion;
 }
 
@@ -434,23 +1317,61 @@ bool DynamoDBStorageService::deleteString(
     const char* context,
     const char* key
 )
+{
+    TraceRecorder::Scope trace(m_tracer.get(), TraceRecorder::DELETE_STRING, context, key);
+
+    bool deleted = deleteStringItem(context, key);
+    invalidatePrefetch(context);
+    if (m_stale) {
+        m_stale->erase(context, key);
+    }
+    trace.finish(deleted ? TraceRecorder::SUCCESS : TraceRecorder::NOT_FOUND);
+    return deleted;
+}
+
+
+// With a version, the item is only deleted if it still has that version.
+bool DynamoDBStorageService::deleteStringItem(
+    const char* context,
+    const char* key,
+    int version
+)
 {
     #ifdef _DEBUG
     NDC ndc("deleteString")
     #endif
 
+    checkKey(context, key);
+
+    if (m_mutations && m_mutations->isDeletePending(context)) {
+        return false;
+    }
+
     DeleteItemRequest request;
-    request.SetTableName(m_tableName);
+    request.SetTableName(getTableName(context));
+    if (m_maxChunks > 1) {
+        request.SetReturnValues(ReturnValue::ALL_OLD);
+    }
 
-    request.AddKey(CONTEXT, AttributeValue(context));
-    request.AddKey(KEY, AttributeValue(key));
+    request.AddKey(m_names.context, AttributeValue(getPartition(context, key)));
+    request.AddKey(m_names.key, AttributeValue(key));
 
-    logRequest(request);
+    if (version > 0) {
+        request.AddExpressionAttributeNames("#V", m_names.version);
+        request.AddExpressionAttributeValues(":ver", AttributeValue().SetN(lexical_cast<string>(version)));
+        request.SetConditionExpression("#V = :ver");
+    }
 
-    DeleteItemOutcome outcome = m_client->DeleteItem(request);
-    if (!outcome.IsSuccess()) {
+    prepareRequest(request);
+
+    DeleteItemOutcome outcome = invoke<DeleteItemOutcome>(true, context, [&](const DynamoDBClient &client) {
+        return client.DeleteItem(request);
+    });
+    if (!outcome.IsSuccess() && version > 0 && outcome.GetError().GetErrorType() == DynamoDBErrors::CONDITIONAL_CHECK_FAILED) {
+        return false;
+    } else if (!outcome.IsSuccess()) {
         m_log.error("delete string failed (table=%s; context=%s; key=%s)",
-            m_tableName.c_str(),
+            getTableName(context).c_str(),
             context,
             key
         );
@@ -458,16 +1379,305 @@ bool DynamoDBStorageService::deleteString(
         throw IOException("DynamoDB Storage delete string failed.");
     }
 
+    if (m_keyCache) {
+        m_keyCache->removeKey(context, key);
+    }
+
+    if (m_maxChunks > 1) {
+        deleteChunks(context, key, 1, getChunks(outcome.GetResult().GetAttributes()));
+    }
+
     return true;
 }
 
 
+// Runs fn on the executor. Nothing is turned away; when the queue is
+// full this waits for room. Wait for the result with the executor's
+// wait, which keeps a worker busy with queued tasks meanwhile.
+template <typename T>
+future<T> DynamoDBStorageService::fanOut(function<T ()> fn) const
+{
+    auto task = make_shared<packaged_task<T ()>>(std::move(fn));
+    future<T> result = task->get_future();
+
+    m_executor->Submit([task]() { (*task)(); });
+    return result;
+}
+
+
+// Like fanOut, but counts fn as pending until it is done so that the
+// destructor can wait for it.
+template <typename T>
+future<T> DynamoDBStorageService::submit(function<T ()> fn)
+{
+    struct Finished {
+        DynamoDBStorageService* service;
+
+        ~Finished() {
+            lock_guard<mutex> lock(service->m_asyncMutex);
+            if (--service->m_asyncPending == 0) {
+                service->m_asyncCond.notify_all();
+            }
+        }
+    };
+
+    {
+        lock_guard<mutex> lock(m_asyncMutex);
+        ++m_asyncPending;
+    }
+
+    return fanOut<T>([this, fn]() {
+        Finished finished = { this };
+        return fn();
+    });
+}
+
+
+// The async calls run the same code as the StorageService methods, so
+// they get the same tracing, caching, failover and deadlines. Arguments
+// are copied so that callers don't have to keep them alive.
+future<bool> DynamoDBStorageService::createStringAsync(
+    const string &context,
+    const string &key,
+    const string &value,
+    time_t expiration
+)
+{
+    return submit<bool>([this, context, key, value, expiration]() {
+        return createString(context.c_str(), key.c_str(), value.c_str(), expiration);
+    });
+}
+
+
+future<DynamoDBStorageService::ReadResult> DynamoDBStorageService::readStringAsync(
+    const string &context,
+    const string &key,
+    int version
+)
+{
+    return submit<ReadResult>([this, context, key, version]() {
+        ReadResult result;
+        result.expiration = 0;
+        result.version = readString(context.c_str(), key.c_str(), &result.value, &result.expiration, version);
+        return result;
+    });
+}
+
+
+// An empty value only updates the expiration, like a null one does for
+// updateString.
+future<int> DynamoDBStorageService::updateStringAsync(
+    const string &context,
+    const string &key,
+    const string &value,
+    time_t expiration,
+    int version
+)
+{
+    return submit<int>([this, context, key, value, expiration, version]() {
+        return updateString(context.c_str(), key.c_str(), value.empty() ? nullptr : value.c_str(), expiration, version);
+    });
+}
+
+
+future<bool> DynamoDBStorageService::deleteStringAsync(
+    const string &context,
+    const string &key
+)
+{
+    return submit<bool>([this, context, key]() {
+        return deleteString(context.c_str(), key.c_str());
+    });
+}
+
+
+future<void> DynamoDBStorageService::updateContextAsync(const string &context, time_t expiration)
+{
+    return submit<void>([this, context, expiration]() {
+        updateContext(context.c_str(), expiration);
+    });
+}
+
+
+future<void> DynamoDBStorageService::deleteContextAsync(const string &context)
+{
+    return submit<void>([this, context]() {
+        deleteContext(context.c_str());
+    });
+}
+
+
+vector<DynamoDBStorageService::ReadResult> DynamoDBStorageService::readStrings(
+    const vector<ReadRequest> &requests,
+    bool values
+)
+{
+    #ifdef _DEBUG
+    NDC ndc("readStrings")
+    #endif
+
+    time_t now = time(nullptr);
+
+    ReadResult notFound;
+    notFound.version = 0;
+    notFound.expiration = 0;
+    vector<ReadResult> results(requests.size(), notFound);
+
+    // Each route has its own table and clients, so the keys are fetched
+    // a route at a time.
+    map<const Route*, vector<size_t>> groups;
+    for (size_t i = 0; i < requests.size(); ++i) {
+        const char* context = requests[i].context.c_str();
+        checkKey(context, requests[i].key.c_str());
+        if (m_mutations && m_mutations->isDeletePending(context)) {
+            continue;
+        }
+        groups[getRoute(context)].push_back(i);
+    }
+
+    vector<size_t> chunked;
+    int backoffLevel = 0;
+    for (const auto &group : groups) {
+        const char* context = requests[group.second.front()].context.c_str();
+        const string &tableName = getTableName(context);
+
+        // BatchGetItem rejects duplicate keys, so each partition and key
+        // is asked for once no matter how many requests want it
+        map<pair<string, string>, vector<size_t>> wanted;
+        for (size_t i : group.second) {
+            const ReadRequest &req = requests[i];
+            wanted[make_pair(getPartition(req.context.c_str(), req.key.c_str()), req.key)].push_back(i);
+        }
+
+        auto next = wanted.cbegin();
+        while (next != wanted.cend()) {
+            KeysAndAttributes keys;
+            keys.SetConsistentRead(true);
+            if (!values) {
+                keys.AddExpressionAttributeNames("#C", m_names.context);
+                keys.AddExpressionAttributeNames("#K", m_names.key);
+                keys.AddExpressionAttributeNames("#E", m_names.expires);
+                keys.AddExpressionAttributeNames("#V", m_names.version);
+                keys.WithProjectionExpression("#C, #K, #E, #V");
+            }
+            for (unsigned int n = 0; n < MAX_BATCH_GET_SIZE && next != wanted.cend(); ++n, ++next) {
+                Item itemKey;
+                itemKey[m_names.context] = AttributeValue(next->first.first);
+                itemKey[m_names.key] = AttributeValue(next->first.second);
+                keys.AddKeys(itemKey);
+            }
+
+            BatchGetItemRequest request;
+            request.AddRequestItems(tableName, keys);
+            while (!request.GetRequestItems().empty()) {
+                prepareRequest(request);
+
+                BatchGetItemOutcome outcome = invoke<BatchGetItemOutcome>(false, context, [&](const DynamoDBClient &client) {
+                    return client.BatchGetItem(request);
+                });
+                if (!outcome.IsSuccess()) {
+                    m_log.error("read strings failed (table=%s; context=%s; keys=%d)",
+                        tableName.c_str(),
+                        context,
+                        static_cast<int>(wanted.size())
+                    );
+                    logError(outcome.GetError());
+                    throw IOException("DynamoDB Storage read strings failed.");
+                }
+
+                const BatchGetItemResult &result = outcome.GetResult();
+                auto responses = result.GetResponses().find(tableName);
+                if (responses != result.GetResponses().cend()) {
+                    for (const Item &item : responses->second) {
+                        auto itemPartition = item.find(m_names.context);
+                        auto itemKey = item.find(m_names.key);
+                        if (itemPartition == item.cend() || itemKey == item.cend()) {
+                            continue;
+                        }
+
+                        auto found = wanted.find(make_pair(itemPartition->second.GetS(), itemKey->second.GetS()));
+                        if (found == wanted.cend()) {
+                            continue;
+                        }
+
+                        for (size_t i : found->second) {
+                            const ReadRequest &req = requests[i];
+                            const char* reqContext = req.context.c_str();
+                            const char* reqKey = req.key.c_str();
+
+                            // the same expiration and version rules as
+                            // readString
+                            time_t itemExpires = getItemN<time_t>(reqContext, reqKey, item, m_names.expires);
+                            if (itemExpires && itemExpires <= now) {
+                                continue;
+                            }
+
+                            if (m_keyCache) {
+                                m_keyCache->checkKey(reqContext, reqKey);
+                            }
+
+                            ReadResult &readResult = results[i];
+                            readResult.version = getItemN<int>(reqContext, reqKey, item, m_names.version);
+                            readResult.expiration = itemExpires;
+                            if (values && !(req.version && readResult.version == req.version)) {
+                                if (getChunks(item) > 1) {
+                                    chunked.push_back(i);
+                                } else {
+                                    readResult.value = getItemS(reqContext, reqKey, item, m_names.value);
+                                }
+                            }
+                        }
+                    }
+                }
+
+                // back off while DynamoDB leaves keys unprocessed, and
+                // ease off again once whole batches get through
+                request = BatchGetItemRequest();
+                request.SetRequestItems(result.GetUnprocessedKeys());
+                if (request.GetRequestItems().empty()) {
+                    if (backoffLevel > 0) {
+                        --backoffLevel;
+                    }
+                } else {
+                    auto sleepTime = min((1 << backoffLevel) * m_batchBackoffScaleFactor, m_batchBackoffMax);
+                    if (sleepTime < m_batchBackoffMax) {
+                        ++backoffLevel;
+                    }
+                    m_log.warn("read strings has unprocessed keys (table=%s; context=%s; backoffLevel=%d)",
+                        tableName.c_str(),
+                        context,
+                        backoffLevel
+                    );
+                    Deadline::sleep(sleepTime);
+                }
+            }
+        }
+    }
+
+    // values split into chunks need the chunks read with the item's version
+    for (size_t i : chunked) {
+        ReadResult &readResult = results[i];
+        readResult.version = readStringItem(
+            requests[i].context.c_str(),
+            requests[i].key.c_str(),
+            &readResult.value,
+            &readResult.expiration,
+            requests[i].version
+        );
+    }
+
+    return results;
+}
+
+
 void DynamoDBStorageService::updateContext(const char* context, time_t expiration)
 {
     #ifdef _DEBUG
     NDC ndc("updateContext")
     #endif
 
+    TraceRecorder::Scope trace(m_tracer.get(), TraceRecorder::UPDATE_CONTEXT, context, nullptr, 0, expiration);
+
     {
         lock_guard<mutex> lock(m_updateContextExpirationsMutex);
         unordered_map<string, time_t>::iterator lastExp = m_updateContextExpirations.find(context);
@@ -482,43 +1692,70 @@ void DynamoDBStorageService::updateContext(const char* context, time_t expiratio
                 expiration,
                 lastExp->second
             );
+            trace.finish(TraceRecorder::SUCCESS);
             return;
         }
     }
 
-    forEachContextKey(
-        context,
-        [=](const AttributeValue& key) -> bool {
+    if (!m_mutations || !m_mutations->enqueue(context, false, expiration)) {
+        applyUpdateContext(context, expiration);
+    }
+    trace.finish(TraceRecorder::SUCCESS);
+}
+
+
+void DynamoDBStorageService::applyUpdateContext(const char* context, time_t expiration)
+{
+    Deadline deadline(m_contextTimeout);
+    Deadline::Scope deadlineScope(&deadline);
+
+    ContextKeyCache::Keys keys;
+    unsigned long generation = 0;
+    const bool cached = m_keyCache && m_keyCache->getKeys(context, keys, generation);
+    mutex keysMutex;
+
+    forEachPartition(context, [&](const string &partition) {
+        forEachPartitionKey(partition, context, [&](const AttributeValue& key) -> bool {
+            if (m_keyCache && !cached) {
+                lock_guard<mutex> lock(keysMutex);
+                keys.push_back(make_pair(partition, key.GetS()));
+            }
+
             UpdateItemRequest request;
-            request.SetTableName(m_tableName);
+            request.SetTableName(getTableName(context));
 
-            request.AddKey(CONTEXT, AttributeValue(context));
-            request.AddKey(KEY, key);
+            request.AddKey(m_names.context, AttributeValue(partition));
+            request.AddKey(m_names.key, key);
 
-            request.AddExpressionAttributeNames("#C", CONTEXT);
-            request.AddExpressionAttributeNames("#K", KEY);
-            request.AddExpressionAttributeNames("#E", EXPIRES);
+            request.AddExpressionAttributeNames("#C", m_names.context);
+            request.AddExpressionAttributeNames("#K", m_names.key);
+            request.AddExpressionAttributeNames("#E", m_names.expires);
 
             request.AddExpressionAttributeValues(":expires", AttributeValue().SetN(lexical_cast<string>(expiration)));
 
             request.SetConditionExpression("attribute_exists(#C) AND attribute_exists(#K)");
             request.SetUpdateExpression("SET #E = :expires");
 
-            logRequest(request);
+            prepareRequest(request);
 
-            UpdateItemOutcome outcome = m_client->UpdateItem(request);
+            UpdateItemOutcome outcome = invoke<UpdateItemOutcome>(true, context, [&](const DynamoDBClient &client) {
+                return client.UpdateItem(request);
+            });
             if (!outcome.IsSuccess()) {
                 const auto &error = outcome.GetError();
 
                 if (error.GetErrorType() == DynamoDBErrors::CONDITIONAL_CHECK_FAILED) {
                     m_log.info("update context failed with condition check failure (table=%s; context=%s; key=%s)",
-                        m_tableName.c_str(),
+                        getTableName(context).c_str(),
                         context,
                         key.GetS().c_str()
                     );
+                    if (m_keyCache) {
+                        m_keyCache->invalidate(context);
+                    }
                 } else {
                     m_log.error("update context failed (table=%s; context=%s; key=%s)",
-                        m_tableName.c_str(),
+                        getTableName(context).c_str(),
                         context,
                         key.GetS().c_str()
                     );
@@ -527,13 +1764,24 @@ void DynamoDBStorageService::updateContext(const char* context, time_t expiratio
             }
 
             return false;
-        }
-    );
+        }, cached ? &keys : nullptr, true);
+    });
+
+    // a listing from the keys index might be missing new keys, and
+    // deleteContext trusts whatever list the cache holds
+    if (m_keyCache && (cached || m_keysIndexName.empty())) {
+        m_keyCache->setKeys(context, keys, expiration, generation, !cached);
+    }
 
     {
         lock_guard<mutex> lock(m_updateContextExpirationsMutex);
         m_updateContextExpirations[context] = expiration;
     }
+
+    invalidatePrefetch(context);
+    if (m_stale) {
+        m_stale->updateExpiration(context, expiration);
+    }
 }
 
 
@@ -543,74 +1791,274 @@ void DynamoDBStorageService::deleteContext(const char* context)
     NDC ndc("deleteContext")
     #endif
 
-    list<WriteRequest> writeRequests;
-    forEachContextKey(
-        context,
-        [=,&writeRequests](const AttributeValue& key) -> bool {
-            writeRequests.push_back(WriteRequest().WithDeleteRequest(
-                DeleteRequest().AddKey(CONTEXT, AttributeValue(context)).AddKey(KEY, key)
-            ));
+    TraceRecorder::Scope trace(m_tracer.get(), TraceRecorder::DELETE_CONTEXT, context);
 
-            return false;
-        }
-    );
+    if (!m_mutations || !m_mutations->enqueue(context, true, 0)) {
+        applyDeleteContext(context);
+    }
+    trace.finish(TraceRecorder::SUCCESS);
+}
 
-    int backoffLevel = 0;
 
-    Aws::Map<Aws::String, Aws::Vector<WriteRequest>> requestItems;
-    auto it = writeRequests.cbegin();
-    while (it != writeRequests.cend()) {
-        auto &items = requestItems[m_tableName];
-        for (; items.size() < m_batchSize && it != writeRequests.cend(); ++it) {
-            items.push_back(*it);
-        }
+void DynamoDBStorageService::applyDeleteContext(const char* context)
+{
+    Deadline deadline(m_contextTimeout);
+    Deadline::Scope deadlineScope(&deadline);
+
+    ContextKeyCache::Keys keys;
+    unsigned long generation = 0;
+    const bool cached = m_keyCache && m_keyCache->getKeys(context, keys, generation);
+
+
+    forEachPartition(context, [&](const string &partition) {
+        // Keys are sent in batches as the query pages arrive, with up to
+        // m_batchConcurrency batches in flight. Unprocessed items go back
+        // in the queue for a later batch, which is sent after a backoff
+        // delay without holding up the others.
+        deque<WriteRequest> pending;
+        deque<future<BatchWriteItemOutcome>> inflight;
+        int backoffLevel = 0;
+
+        auto sendBatch = [&]() {
+            Aws::Vector<WriteRequest> items;
+            while (items.size() < m_batchSize && !pending.empty()) {
+                items.push_back(std::move(pending.front()));
+                pending.pop_front();
+            }
 
-        BatchWriteItemRequest request;
-        request.SetRequestItems(requestItems);
+            chrono::milliseconds delay(0);
+            if (backoffLevel > 0) {
+                delay = min((1 << (backoffLevel - 1)) * m_batchBackoffScaleFactor, m_batchBackoffMax);
+            }
 
-        logRequest(request);
+            BatchWriteItemRequest request;
+            request.AddRequestItems(getTableName(context), items);
 
-        BatchWriteItemOutcome outcome = m_client->BatchWriteItem(request);
-        if (!outcome.IsSuccess()) {
-            m_log.error("delete context batch write failed (table=%s; context=%s)",
-                m_tableName.c_str(),
-                context
-            );
-            logError(outcome.GetError());
-            throw IOException("DynamoDB Storage delete context failed.");
-        }
+            prepareRequest(request);
 
-        const BatchWriteItemResult &result = outcome.GetResult();
-        requestItems = result.GetUnprocessedItems();
+            // the batch gets its own copies, and doesn't depend on the
+            // caller's stack
+            const string batchContext(context);
+            inflight.push_back(fanOut<BatchWriteItemOutcome>([this, batchContext, request, delay, deadline]() {
+                Deadline::Scope deadlineScope(&deadline);
+                Deadline::sleep(delay);
 
-        // check if we had unprocessed items, and modify the backoff
-        // strategy in response
-        if (requestItems.empty()) {
-            if (backoffLevel > 0) {
-                // successfully processed all the elemnts last round,
-                // so decrease the backoff level
-                --backoffLevel;
-                m_log.warn("no unprocessed items; decreased backoff level to %d", backoffLevel);
-            }
-        } else {
-            auto sleepTime = (1 << backoffLevel) * m_batchBackoffScaleFactor;
+                return invoke<BatchWriteItemOutcome>(true, batchContext.c_str(), [&](const DynamoDBClient &client) {
+                    return client.BatchWriteItem(request);
+                });
+            }));
+        };
 
-            if (sleepTime < m_batchBackoffMax) {
-                // increase the backoff level for the next round
-                backoffLevel++;
-            } else {
-                sleepTime = m_batchBackoffMax;
+        auto finishBatch = [&]() {
+            m_executor->wait(inflight.front());
+            BatchWriteItemOutcome outcome = inflight.front().get();
+            inflight.pop_front();
+
+            if (!outcome.IsSuccess()) {
+                m_log.error("delete context batch write failed (table=%s; context=%s)",
+                    getTableName(context).c_str(),
+                    context
+                );
+                logError(outcome.GetError());
+                throw IOException("DynamoDB Storage delete context failed.");
+            }
+
+            // check if we had unprocessed items, and modify the backoff
+            // strategy in response
+            const auto &unprocessedItems = outcome.GetResult().GetUnprocessedItems();
+            auto unprocessed = unprocessedItems.find(getTableName(context));
+            if (unprocessed == unprocessedItems.end() || unprocessed->second.empty()) {
+                if (backoffLevel > 0) {
+                    --backoffLevel;
+                }
+            } else {
+                if ((1 << backoffLevel) * m_batchBackoffScaleFactor < m_batchBackoffMax) {
+                    ++backoffLevel;
+                }
+
+                m_log.warn("%d unprocessed items requeued (table=%s; context=%s; backoffLevel=%d)",
+                    static_cast<int>(unprocessed->second.size()),
+                    getTableName(context).c_str(),
+                    context,
+                    backoffLevel
+                );
+                pending.insert(pending.end(), unprocessed->second.begin(), unprocessed->second.end());
             }
+        };
+
+        try {
+            forEachPartitionKey(partition, context, [&](const AttributeValue& key) -> bool {
+                pending.push_back(WriteRequest().WithDeleteRequest(
+                    DeleteRequest().AddKey(m_names.context, AttributeValue(partition)).AddKey(m_names.key, key)
+                ));
+
+                while (pending.size() >= m_batchSize) {
+                    if (inflight.size() >= m_batchConcurrency) {
+                        finishBatch();
+                    }
+                    sendBatch();
+                }
+
+                return false;
+            }, cached ? &keys : nullptr);
 
-            m_log.warnStream() << requestItems[m_tableName].size() << " unprocessed items; sleeping for " << sleepTime.count() << "; backoffLevel = " << backoffLevel;
-            this_thread::sleep_for(sleepTime);
+            while (!pending.empty() || !inflight.empty()) {
+                if (!pending.empty() && inflight.size() < m_batchConcurrency) {
+                    sendBatch();
+                } else {
+                    finishBatch();
+                }
+            }
+        } catch (...) {
+            // wait for the batches still in flight before reporting the
+            // failure, like forEachPartition does for the partitions
+            for (auto &batch : inflight) {
+                m_executor->wait(batch);
+            }
+            throw;
         }
+    });
+
+    if (m_keyCache) {
+        m_keyCache->erase(context);
     }
 
     {
         lock_guard<mutex> lock(m_updateContextExpirationsMutex);
         m_updateContextExpirations.erase(context);
     }
+
+    invalidatePrefetch(context);
+    if (m_stale) {
+        m_stale->erase(context);
+    }
+}
+
+
+// Copies the unexpired items of a table that uses other attribute names
+// into this one, renaming the attributes on the way. DynamoDB can't
+// rename attributes in place, and the context and key are the table's
+// key schema, so moving to new names means moving to a new table. An
+// item that is already in this table and hasn't expired is newer than
+// the copy, so it is left alone.
+unsigned long DynamoDBStorageService::copyTable(
+    const string &sourceTable,
+    const AttributeNames &sourceNames,
+    unsigned long* pskipped
+)
+{
+    #ifdef _DEBUG
+    NDC ndc("copyTable")
+    #endif
+
+    const map<string, string> renames = {
+        { sourceNames.context, m_names.context },
+        { sourceNames.key, m_names.key },
+        { sourceNames.value, m_names.value },
+        { sourceNames.expires, m_names.expires },
+        { sourceNames.version, m_names.version },
+        { sourceNames.chunks, m_names.chunks },
+    };
+    const string now = lexical_cast<string>(time(nullptr));
+
+    ScanRequest request;
+    request.SetTableName(sourceTable);
+
+    request.AddExpressionAttributeNames("#E", sourceNames.expires);
+    request.AddExpressionAttributeValues(":now", AttributeValue().SetN(now));
+    request.SetFilterExpression("attribute_not_exists(#E) OR #E > :now");
+
+    // BatchWriteItem can't be conditional, so each item is its own
+    // PutItem, with as many in flight as a context delete would have
+    const size_t maxInflight = m_batchConcurrency * m_batchSize;
+    deque<future<PutItemOutcome>> inflight;
+    unsigned long copied = 0;
+    unsigned long skipped = 0;
+
+    auto finishPut = [&]() {
+        m_executor->wait(inflight.front());
+        PutItemOutcome outcome = inflight.front().get();
+        inflight.pop_front();
+
+        if (outcome.IsSuccess()) {
+            ++copied;
+        } else if (outcome.GetError().GetErrorType() == DynamoDBErrors::CONDITIONAL_CHECK_FAILED) {
+            ++skipped;
+        } else {
+            m_log.error("copy table put failed (table=%s; source=%s)",
+                m_tableName.c_str(),
+                sourceTable.c_str()
+            );
+            logError(outcome.GetError());
+            throw IOException("DynamoDB Storage copy table failed.");
+        }
+    };
+
+    try {
+        do {
+            prepareRequest(request);
+
+            ScanOutcome outcome = invoke<ScanOutcome>(false, "", [&](const DynamoDBClient &client) {
+                return client.Scan(request);
+            });
+            if (!outcome.IsSuccess()) {
+                m_log.error("copy table scan failed (table=%s; source=%s)",
+                    m_tableName.c_str(),
+                    sourceTable.c_str()
+                );
+                logError(outcome.GetError());
+                throw IOException("DynamoDB Storage copy table failed.");
+            }
+
+            const ScanResult &result = outcome.GetResult();
+            for (const Item &item : result.GetItems()) {
+                PutItemRequest put;
+                put.SetTableName(m_tableName);
+                for (const auto &attr : item) {
+                    auto rename = renames.find(attr.first);
+                    put.AddItem(rename == renames.end() ? attr.first : rename->second, attr.second);
+                }
+
+                put.AddExpressionAttributeNames("#K", m_names.key);
+                put.AddExpressionAttributeNames("#E", m_names.expires);
+                put.AddExpressionAttributeValues(":now", AttributeValue().SetN(now));
+                put.SetConditionExpression("attribute_not_exists(#K) OR #E <= :now");
+
+                prepareRequest(put);
+
+                if (inflight.size() >= maxInflight) {
+                    finishPut();
+                }
+                inflight.push_back(fanOut<PutItemOutcome>([this, put]() {
+                    return invoke<PutItemOutcome>(true, "", [&](const DynamoDBClient &client) {
+                        return client.PutItem(put);
+                    });
+                }));
+            }
+
+            request.SetExclusiveStartKey(result.GetLastEvaluatedKey());
+        } while (!request.GetExclusiveStartKey().empty());
+
+        while (!inflight.empty()) {
+            finishPut();
+        }
+    } catch (...) {
+        for (auto &put : inflight) {
+            m_executor->wait(put);
+        }
+        throw;
+    }
+
+    m_log.info("copied %lu items and skipped %lu newer ones (table=%s; source=%s)",
+        copied,
+        skipped,
+        m_tableName.c_str(),
+        sourceTable.c_str()
+    );
+    if (pskipped) {
+        *pskipped = skipped;
+    }
+    return copied;
 }
 
 
@@ -618,22 +2066,74 @@ void DynamoDBStorageService::forEachContextKey(
     const char* context,
     function<bool (const AttributeValue&)> callback
 )
+{
+    Deadline deadline(m_contextTimeout);
+    Deadline::Scope deadlineScope(&deadline);
+
+    // partitions are listed in parallel, but the callback is only ever
+    // called by one of them at a time
+    mutex callbackMutex;
+    bool stopLoop = false;
+
+    forEachPartition(context, [&](const string &partition) {
+        forEachPartitionKey(partition, context, [&](const AttributeValue& key) -> bool {
+            // chunk items are part of another key's value
+            if (key.GetS().find(CHUNK_KEY_SEPARATOR) != string::npos) {
+                return false;
+            }
+
+            lock_guard<mutex> lock(callbackMutex);
+            if (!stopLoop) {
+                stopLoop = callback(key);
+            }
+
+            return stopLoop;
+        });
+    });
+}
+
+
+void DynamoDBStorageService::forEachPartitionKey(
+    const string &partition,
+    const char* context,
+    function<bool (const AttributeValue&)> callback,
+    const ContextKeyCache::Keys *keys,
+    bool useIndex
+)
 {
     #ifdef _DEBUG
     NDC ndc("_listContextKeys")
     #endif
 
+    if (keys) {
+        for (const auto &key : *keys) {
+            if (key.first == partition && callback(AttributeValue(key.second))) {
+                break;
+            }
+        }
+        return;
+    }
+
     time_t now = time(nullptr);
 
     QueryRequest request;
-    request.SetTableName(m_tableName);
-    request.SetConsistentRead(true);
+    request.SetTableName(getTableName(context));
+    if (!useIndex || m_keysIndexName.empty()) {
+        request.SetConsistentRead(true);
+    } else {
+        // The index only holds the key and expiration of each item, so
+        // the Query is charged for those bytes instead of the values.
+        // Global indexes can't be read consistently; a key written a
+        // moment ago might not be listed yet, which only updateContext
+        // can live with.
+        request.SetIndexName(m_keysIndexName);
+    }
 
-    request.AddExpressionAttributeNames("#C", CONTEXT);
-    request.AddExpressionAttributeNames("#K", KEY);
-    request.AddExpressionAttributeNames("#E", EXPIRES);
+    request.AddExpressionAttributeNames("#C", m_names.context);
+    request.AddExpressionAttributeNames("#K", m_names.key);
+    request.AddExpressionAttributeNames("#E", m_names.expires);
 
-    request.AddExpressionAttributeValues(":context", AttributeValue(context));
+    request.AddExpressionAttributeValues(":context", AttributeValue(partition));
     request.AddExpressionAttributeValues(":now", AttributeValue().SetN(lexical_cast<string>(now)));
 
     request.SetKeyConditionExpression("#C = :context");
@@ -644,12 +2144,14 @@ void DynamoDBStorageService::forEachContextKey(
 
     bool stopLoop = false;
     do {
-        logRequest(request);
+        prepareRequest(request);
 
-        QueryOutcome outcome = m_client->Query(request);
+        QueryOutcome outcome = invoke<QueryOutcome>(false, context, [&](const DynamoDBClient &client) {
+            return client.Query(request);
+        });
         if (!outcome.IsSuccess()) {
             m_log.error("list context keys failed (table=%s; context=%s)",
-                m_tableName.c_str(),
+                getTableName(context).c_str(),
                 context
             );
             logError(outcome.GetError());
@@ -659,10 +2161,10 @@ void DynamoDBStorageService::forEachContextKey(
         const QueryResult &result = outcome.GetResult();
 
         for (const Item &item : result.GetItems()) {
-            Item::const_iterator it = item.find(KEY);
+            Item::const_iterator it = item.find(m_names.key);
             if (it == item.cend()) {
                 m_log.warn("list context keys got item without a key value (table=%s; context=%s)",
-                    m_tableName.c_str(),
+                    getTableName(context).c_str(),
                     context
                 );
                 continue;
@@ -679,6 +2181,1051 @@ void DynamoDBStorageService::forEachContextKey(
 }
 
 
+// Answers a read from the context's prefetched items, fetching them all
+// with one Query first if needed. Returns false when the key has to be
+// read with GetItem instead.
+bool DynamoDBStorageService::readPrefetched(
+    const char* context,
+    const char* key,
+    string* pvalue,
+    time_t* pexpiration,
+    int version,
+    int &itemVersion
+)
+{
+    ContextPrefetchCache::Item item;
+    unsigned long generation = 0;
+
+    ContextPrefetchCache::Lookup found = m_prefetch->lookup(context, key, item, generation);
+    if (found == ContextPrefetchCache::NOT_CACHED) {
+        if (!prefetchContext(context, generation)) {
+            return false;
+        }
+        found = m_prefetch->lookup(context, key, item, generation);
+    }
+
+    if (found == ContextPrefetchCache::ABSENT) {
+        itemVersion = 0;
+        return true;
+    } else if (found != ContextPrefetchCache::FOUND) {
+        return false;
+    }
+
+    // the same expiration and version rules as a GetItem
+    if (item.expiration && item.expiration <= time(nullptr)) {
+        itemVersion = 0;
+        return true;
+    }
+
+    if (pexpiration) {
+        *pexpiration = item.expiration;
+    }
+    if (pvalue && !(version && item.version == version)) {
+        pvalue->append(item.value);
+    }
+
+    itemVersion = item.version;
+    return true;
+}
+
+
+bool DynamoDBStorageService::prefetchContext(const char* context, unsigned long generation)
+{
+    #ifdef _DEBUG
+    NDC ndc("prefetchContext")
+    #endif
+
+    time_t now = time(nullptr);
+    ContextPrefetchCache::Items items;
+
+    for (const string &partition : getPartitions(context)) {
+        QueryRequest request;
+        request.SetTableName(getTableName(context));
+        request.SetConsistentRead(true);
+
+        request.AddExpressionAttributeNames("#C", m_names.context);
+        request.AddExpressionAttributeNames("#K", m_names.key);
+        request.AddExpressionAttributeNames("#E", m_names.expires);
+        request.AddExpressionAttributeNames("#V", m_names.version);
+        request.AddExpressionAttributeNames("#VALUE", m_names.value);
+        request.AddExpressionAttributeNames("#CH", m_names.chunks);
+
+        request.AddExpressionAttributeValues(":context", AttributeValue(partition));
+        request.AddExpressionAttributeValues(":now", AttributeValue().SetN(lexical_cast<string>(now)));
+
+        request.SetKeyConditionExpression("#C = :context");
+        request.SetFilterExpression("attribute_not_exists(#E) OR #E > :now");
+
+        request.SetSelect(Select::SPECIFIC_ATTRIBUTES);
+        request.SetProjectionExpression("#K, #E, #V, #VALUE, #CH");
+
+        do {
+            prepareRequest(request);
+
+            QueryOutcome outcome = invoke<QueryOutcome>(false, context, [&](const DynamoDBClient &client) {
+                return client.Query(request);
+            });
+            if (!outcome.IsSuccess()) {
+                m_log.error("prefetch context failed (table=%s; context=%s)",
+                    getTableName(context).c_str(),
+                    context
+                );
+                logError(outcome.GetError());
+                throw IOException("DynamoDB Storage prefetch context failed.");
+            }
+
+            const QueryResult &result = outcome.GetResult();
+            for (const Item &item : result.GetItems()) {
+                const string &key = getItemS(context, "", item, m_names.key);
+                if (key.empty()) {
+                    continue;
+                }
+
+                ContextPrefetchCache::Item &cached = items[key];
+                cached.expiration = getItemN<time_t>(context, key.c_str(), item, m_names.expires);
+                cached.version = getItemN<int>(context, key.c_str(), item, m_names.version);
+                // chunks, and values made of them, are read the usual way
+                cached.complete = getChunks(item) <= 1;
+                if (cached.complete) {
+                    cached.value = getItemS(context, key.c_str(), item, m_names.value);
+                }
+            }
+
+            if (items.size() > m_prefetch->getMaxItems()) {
+                if (m_log.isDebugEnabled()) {
+                    m_log.debug("context too large to prefetch (table=%s; context=%s)",
+                        getTableName(context).c_str(),
+                        context
+                    );
+                }
+                m_prefetch->storeTooLarge(context, generation);
+                return false;
+            }
+
+            request.SetExclusiveStartKey(result.GetLastEvaluatedKey());
+        } while (!request.GetExclusiveStartKey().empty());
+    }
+
+    m_prefetch->store(context, items, generation);
+    return true;
+}
+
+
+void DynamoDBStorageService::invalidatePrefetch(const char* context)
+{
+    if (m_prefetch && m_prefetch->matches(context)) {
+        m_prefetch->invalidate(context);
+    }
+}
+
+
+vector<string> DynamoDBStorageService::splitChunks(const char* value) const
+{
+    vector<string> chunks;
+
+    const size_t length = strlen(value);
+    size_t pos = 0;
+    while (pos < length) {
+        size_t end = min(pos + m_chunkSize, length);
+
+        // DynamoDB requires valid UTF-8, so never split a multibyte
+        // character between chunks
+        while (end < length && end > pos + 1 && (static_cast<unsigned char>(value[end]) & 0xC0) == 0x80) {
+            --end;
+        }
+
+        chunks.push_back(string(value + pos, end - pos));
+        pos = end;
+    }
+
+    return chunks;
+}
+
+
+void DynamoDBStorageService::checkContext(const char* context) const
+{
+    if (strstr(context, SHARD_SEPARATOR)) {
+        m_log.error("context contains a reserved character (table=%s; context=%s)",
+            getTableName(context).c_str(),
+            context
+        );
+        throw IOException("DynamoDB Storage context contains a reserved character.");
+    }
+}
+
+
+void DynamoDBStorageService::checkKey(const char* context, const char* key) const
+{
+    checkContext(context);
+
+    if (strstr(key, CHUNK_KEY_SEPARATOR)) {
+        m_log.error("key contains a reserved character (table=%s; context=%s)",
+            getTableName(context).c_str(),
+            context
+        );
+        throw IOException("DynamoDB Storage key contains a reserved character.");
+    }
+}
+
+
+const string DynamoDBStorageService::getChunkKey(const char* key, int chunk) const
+{
+    return string(key) + CHUNK_KEY_SEPARATOR + lexical_cast<string>(chunk);
+}
+
+
+int DynamoDBStorageService::getChunks(const Item &item) const
+{
+    Item::const_iterator it = item.find(m_names.chunks);
+    if (it == item.cend() || it->second.GetN().empty()) {
+        return 1;
+    }
+
+    try {
+        return lexical_cast<int>(it->second.GetN());
+    } catch (const bad_lexical_cast &) {
+        return 1;
+    }
+}
+
+
+bool DynamoDBStorageService::createChunkedString(
+    const char* context,
+    const char* key,
+    const vector<string> &chunks,
+    time_t expiration
+)
+{
+    #ifdef _DEBUG
+    NDC ndc("createChunkedString")
+    #endif
+
+    if (chunks.size() > static_cast<size_t>(m_maxChunks)) {
+        m_log.error("create string value is too large (table=%s; context=%s; key=%s; chunks=%d)",
+            getTableName(context).c_str(),
+            context,
+            key,
+            static_cast<int>(chunks.size())
+        );
+        throw IOException("DynamoDB Storage create string value is too large.");
+    }
+
+    time_t now = time(nullptr);
+    const string partition = getPartition(context, key);
+    const AttributeValue expires = AttributeValue().SetN(lexical_cast<string>(expiration));
+
+    TransactWriteItemsRequest request;
+
+    // Make sure the new item doesn't already exist; the chunks are
+    // only written if the first item is
+    request.AddTransactItems(TransactWriteItem().WithPut(Put()
+        .WithTableName(getTableName(context))
+        .AddItem(m_names.context, AttributeValue(partition))
+        .AddItem(m_names.key, AttributeValue(key))
+        .AddItem(m_names.value, AttributeValue(chunks.front()))
+        .AddItem(m_names.expires, expires)
+        .AddItem(m_names.version, AttributeValue().SetN("1"))
+        .AddItem(m_names.chunks, AttributeValue().SetN(lexical_cast<string>(chunks.size())))
+        .AddExpressionAttributeNames("#C", m_names.context)
+        .AddExpressionAttributeNames("#K", m_names.key)
+        .AddExpressionAttributeNames("#E", m_names.expires)
+        .AddExpressionAttributeValues(":now", AttributeValue().SetN(lexical_cast<string>(now)))
+        .WithConditionExpression("attribute_not_exists(#C) OR (attribute_exists(#C) AND attribute_not_exists(#K)) OR (attribute_exists(#C) AND attribute_exists(#K) AND #E <= :now)")
+    ));
+
+    for (size_t i = 1; i < chunks.size(); ++i) {
+        request.AddTransactItems(TransactWriteItem().WithPut(Put()
+            .WithTableName(getTableName(context))
+            .AddItem(m_names.context, AttributeValue(partition))
+            .AddItem(m_names.key, AttributeValue(getChunkKey(key, i)))
+            .AddItem(m_names.value, AttributeValue(chunks[i]))
+            .AddItem(m_names.expires, expires)
+            .AddItem(m_names.version, AttributeValue().SetN("1"))
+        ));
+    }
+
+    prepareRequest(request);
+
+    TransactWriteItemsOutcome outcome = invoke<TransactWriteItemsOutcome>(true, context, [&](const DynamoDBClient &client) {
+        return client.TransactWriteItems(request);
+    });
+    if (!outcome.IsSuccess()) {
+        const auto &error = outcome.GetError();
+
+        if (error.GetErrorType() == DynamoDBErrors::TRANSACTION_CANCELED && error.GetMessage().find("ConditionalCheckFailed") != string::npos) {
+            m_log.error("create string failed because conditional check failed (table=%s; context=%s; key=%s)",
+                getTableName(context).c_str(),
+                context,
+                key
+            );
+            return false;
+        } else {
+            m_log.error("create string failed (table=%s; context=%s; key=%s)",
+                getTableName(context).c_str(),
+                context,
+                key
+            );
+            logError(error);
+            throw IOException("DynamoDB Storage create string failed.");
+        }
+    }
+
+    return true;
+}
+
+
+// Without chunks the value is kept, and only the version and expiration
+// of the first item and its chunks are updated.
+int DynamoDBStorageService::updateChunkedString(
+    const char* context,
+    const char* key,
+    const vector<string>* chunks,
+    time_t expiration,
+    int version
+)
+{
+    #ifdef _DEBUG
+    NDC ndc("updateChunkedString")
+    #endif
+
+    if (chunks && chunks->size() > static_cast<size_t>(m_maxChunks)) {
+        m_log.error("update string value is too large (table=%s; context=%s; key=%s; chunks=%d)",
+            getTableName(context).c_str(),
+            context,
+            key,
+            static_cast<int>(chunks->size())
+        );
+        throw IOException("DynamoDB Storage update string value is too large.");
+    }
+
+    const string partition = getPartition(context, key);
+
+    for (int attempt = 0; attempt < CHUNK_UPDATE_ATTEMPTS; ++attempt) {
+        time_t now = time(nullptr);
+
+        // The chunk items are written with the new version, so we need
+        // to know the current one. This also tells us how many chunks
+        // the old value had.
+        GetItemRequest currRequest;
+        currRequest.SetTableName(getTableName(context));
+        currRequest.SetConsistentRead(true);
+
+        currRequest.AddKey(m_names.context, AttributeValue(partition));
+        currRequest.AddKey(m_names.key, AttributeValue(key));
+
+        currRequest.AddExpressionAttributeNames("#E", m_names.expires);
+        currRequest.AddExpressionAttributeNames("#V", m_names.version);
+        currRequest.AddExpressionAttributeNames("#CH", m_names.chunks);
+        currRequest.SetProjectionExpression("#E, #V, #CH");
+
+        prepareRequest(currRequest);
+
+        GetItemOutcome currOutcome = invoke<GetItemOutcome>(false, context, [&](const DynamoDBClient &client) {
+            return client.GetItem(currRequest);
+        });
+        if (!currOutcome.IsSuccess()) {
+            m_log.error("update string failed to read current version (table=%s; context=%s; key=%s)",
+                getTableName(context).c_str(),
+                context,
+                key
+            );
+            logError(currOutcome.GetError());
+            throw IOException("DynamoDB Storage update string failed.");
+        }
+
+        const Item &curr = currOutcome.GetResult().GetItem();
+        if (curr.empty()) {
+            return 0;
+        }
+
+        time_t currExpires = getItemN<time_t>(context, key, curr, m_names.expires);
+        if (currExpires <= now) {
+            return 0;
+        }
+
+        int currVersion = getItemN<int>(context, key, curr, m_names.version);
+        if (version > 0 && currVersion != version) {
+            return -1;
+        }
+
+        const int currChunks = getChunks(curr);
+        const string newVersion = lexical_cast<string>(currVersion + 1);
+        const AttributeValue expires = AttributeValue().SetN(lexical_cast<string>(expiration > 0 ? expiration : currExpires));
+
+        TransactWriteItemsRequest request;
+
+        Update first;
+        first.WithTableName(getTableName(context))
+            .AddKey(m_names.context, AttributeValue(partition))
+            .AddKey(m_names.key, AttributeValue(key))
+            .AddExpressionAttributeNames("#C", m_names.context)
+            .AddExpressionAttributeNames("#K", m_names.key)
+            .AddExpressionAttributeNames("#E", m_names.expires)
+            .AddExpressionAttributeNames("#V", m_names.version)
+            .AddExpressionAttributeValues(":now", AttributeValue().SetN(lexical_cast<string>(now)))
+            .AddExpressionAttributeValues(":ver", AttributeValue().SetN(lexical_cast<string>(currVersion)))
+            .AddExpressionAttributeValues(":newver", AttributeValue().SetN(newVersion))
+            .AddExpressionAttributeValues(":expires", expires)
+            .WithConditionExpression("attribute_exists(#C) AND attribute_exists(#K) AND #E > :now AND #V = :ver");
+        if (chunks) {
+            first.AddExpressionAttributeNames("#VALUE", m_names.value)
+                .AddExpressionAttributeNames("#CH", m_names.chunks)
+                .AddExpressionAttributeValues(":value", AttributeValue(chunks->front()))
+                .AddExpressionAttributeValues(":chunks", AttributeValue().SetN(lexical_cast<string>(chunks->size())))
+                .WithUpdateExpression("SET #VALUE = :value, #V = :newver, #E = :expires, #CH = :chunks");
+        } else {
+            first.WithUpdateExpression("SET #V = :newver, #E = :expires");
+        }
+        request.AddTransactItems(TransactWriteItem().WithUpdate(first));
+
+        if (chunks) {
+            for (size_t i = 1; i < chunks->size(); ++i) {
+                request.AddTransactItems(TransactWriteItem().WithPut(Put()
+                    .WithTableName(getTableName(context))
+                    .AddItem(m_names.context, AttributeValue(partition))
+                    .AddItem(m_names.key, AttributeValue(getChunkKey(key, i)))
+                    .AddItem(m_names.value, AttributeValue((*chunks)[i]))
+                    .AddItem(m_names.expires, expires)
+                    .AddItem(m_names.version, AttributeValue().SetN(newVersion))
+                ));
+            }
+            for (int i = chunks->size(); i < currChunks; ++i) {
+                request.AddTransactItems(TransactWriteItem().WithDelete(Delete()
+                    .WithTableName(getTableName(context))
+                    .AddKey(m_names.context, AttributeValue(partition))
+                    .AddKey(m_names.key, AttributeValue(getChunkKey(key, i)))
+                ));
+            }
+        } else {
+            // a missing chunk fails the transaction rather than being
+            // written back without its value
+            for (int i = 1; i < currChunks; ++i) {
+                request.AddTransactItems(TransactWriteItem().WithUpdate(Update()
+                    .WithTableName(getTableName(context))
+                    .AddKey(m_names.context, AttributeValue(partition))
+                    .AddKey(m_names.key, AttributeValue(getChunkKey(key, i)))
+                    .AddExpressionAttributeNames("#K", m_names.key)
+                    .AddExpressionAttributeNames("#E", m_names.expires)
+                    .AddExpressionAttributeNames("#V", m_names.version)
+                    .AddExpressionAttributeValues(":newver", AttributeValue().SetN(newVersion))
+                    .AddExpressionAttributeValues(":expires", expires)
+                    .WithConditionExpression("attribute_exists(#K)")
+                    .WithUpdateExpression("SET #V = :newver, #E = :expires")
+                ));
+            }
+        }
+
+        prepareRequest(request);
+
+        TransactWriteItemsOutcome outcome = invoke<TransactWriteItemsOutcome>(true, context, [&](const DynamoDBClient &client) {
+            return client.TransactWriteItems(request);
+        });
+        if (outcome.IsSuccess()) {
+            // the cached chunk keys still have the old expiration
+            if (!chunks && currChunks > 1 && m_keyCache) {
+                m_keyCache->invalidate(context);
+            }
+            return currVersion + 1;
+        }
+
+        const auto &error = outcome.GetError();
+        if (error.GetErrorType() != DynamoDBErrors::TRANSACTION_CANCELED && error.GetErrorType() != DynamoDBErrors::TRANSACTION_CONFLICT) {
+            m_log.error("update string failed (table=%s; context=%s; key=%s)",
+                getTableName(context).c_str(),
+                context,
+                key
+            );
+            logError(error);
+            throw IOException("DynamoDB Storage update string failed.");
+        }
+
+        // someone else changed the item since we read it; try again,
+        // which also sorts out a version mismatch or missing item
+        m_log.info("update string chunks changed while updating (table=%s; context=%s; key=%s)",
+            getTableName(context).c_str(),
+            context,
+            key
+        );
+    }
+
+    m_log.error("update string chunks kept changing while updating (table=%s; context=%s; key=%s)",
+        getTableName(context).c_str(),
+        context,
+        key
+    );
+    throw IOException("DynamoDB Storage update string failed.");
+}
+
+
+bool DynamoDBStorageService::readChunks(
+    const char* context,
+    const char* key,
+    int chunks,
+    int version,
+    string &value
+)
+{
+    #ifdef _DEBUG
+    NDC ndc("readChunks")
+    #endif
+
+    const string partition = getPartition(context, key);
+    const string versionN = lexical_cast<string>(version);
+
+    KeysAndAttributes keys;
+    keys.SetConsistentRead(true);
+    keys.AddExpressionAttributeNames("#K", m_names.key);
+    keys.AddExpressionAttributeNames("#V", m_names.version);
+    keys.AddExpressionAttributeNames("#VALUE", m_names.value);
+    keys.WithProjectionExpression("#K, #V, #VALUE");
+    for (int i = 1; i < chunks; ++i) {
+        Item chunkKey;
+        chunkKey[m_names.context] = AttributeValue(partition);
+        chunkKey[m_names.key] = AttributeValue(getChunkKey(key, i));
+        keys.AddKeys(chunkKey);
+    }
+
+    vector<string> values(chunks);
+    int found = 0;
+    int backoffLevel = 0;
+
+    BatchGetItemRequest request;
+    request.AddRequestItems(getTableName(context), keys);
+    while (!request.GetRequestItems().empty()) {
+        prepareRequest(request);
+
+        BatchGetItemOutcome outcome = invoke<BatchGetItemOutcome>(false, context, [&](const DynamoDBClient &client) {
+            return client.BatchGetItem(request);
+        });
+        if (!outcome.IsSuccess()) {
+            m_log.error("read string chunks failed (table=%s; context=%s; key=%s)",
+                getTableName(context).c_str(),
+                context,
+                key
+            );
+            logError(outcome.GetError());
+            throw IOException("DynamoDB Storage read string failed.");
+        }
+
+        const BatchGetItemResult &result = outcome.GetResult();
+        auto responses = result.GetResponses().find(getTableName(context));
+        if (responses != result.GetResponses().cend()) {
+            for (const Item &item : responses->second) {
+                Item::const_iterator itemVersion = item.find(m_names.version);
+                if (itemVersion == item.cend() || itemVersion->second.GetN() != versionN) {
+                    return false;
+                }
+
+                const string &chunkKey = getItemS(context, key, item, m_names.key);
+                for (int i = 1; i < chunks; ++i) {
+                    if (chunkKey == getChunkKey(key, i)) {
+                        values[i] = getItemS(context, key, item, m_names.value);
+                        ++found;
+                        break;
+                    }
+                }
+            }
+        }
+
+        request = BatchGetItemRequest();
+        request.SetRequestItems(result.GetUnprocessedKeys());
+        if (!request.GetRequestItems().empty()) {
+            auto sleepTime = (1 << backoffLevel) * m_batchBackoffScaleFactor;
+            if (sleepTime < m_batchBackoffMax) {
+                backoffLevel++;
+            } else {
+                sleepTime = m_batchBackoffMax;
+            }
+            Deadline::sleep(sleepTime);
+        }
+    }
+
+    if (found != chunks - 1) {
+        // a chunk is missing, which happens when a smaller value was
+        // written after we read the first item
+        return false;
+    }
+
+    for (int i = 1; i < chunks; ++i) {
+        value.append(values[i]);
+    }
+    return true;
+}
+
+
+void DynamoDBStorageService::deleteChunks(const char* context, const char* key, int from, int to)
+{
+    #ifdef _DEBUG
+    NDC ndc("deleteChunks")
+    #endif
+
+    if (from >= to) {
+        return;
+    }
+
+    if (m_keyCache) {
+        m_keyCache->invalidate(context);
+    }
+
+    const string partition = getPartition(context, key);
+
+    Aws::Vector<WriteRequest> items;
+    for (int i = from; i < to; ++i) {
+        items.push_back(WriteRequest().WithDeleteRequest(
+            DeleteRequest().AddKey(m_names.context, AttributeValue(partition)).AddKey(m_names.key, AttributeValue(getChunkKey(key, i)))
+        ));
+    }
+
+    BatchWriteItemRequest request;
+    request.AddRequestItems(getTableName(context), items);
+
+    prepareRequest(request);
+
+    // chunks left behind are never read, and expire with the context
+    BatchWriteItemOutcome outcome = invoke<BatchWriteItemOutcome>(true, context, [&](const DynamoDBClient &client) {
+        return client.BatchWriteItem(request);
+    });
+    if (!outcome.IsSuccess()) {
+        m_log.warn("delete string chunks failed (table=%s; context=%s; key=%s)",
+            getTableName(context).c_str(),
+            context,
+            key
+        );
+        logError(outcome.GetError());
+    } else if (!outcome.GetResult().GetUnprocessedItems().empty()) {
+        m_log.warn("delete string chunks left unprocessed items (table=%s; context=%s; key=%s)",
+            getTableName(context).c_str(),
+            context,
+            key
+        );
+    }
+}
+
+
+const string DynamoDBStorageService::getPartition(const char* context, const char* key) const
+{
+    for (const auto &shard : m_shards) {
+        if (!hasPrefix(context, shard.first) || shard.second < 2) {
+            continue;
+        }
+
+        // FNV-1a, which is stable between builds and platforms unlike
+        // std::hash, so that every node picks the same shard
+        uint32_t hash = 2166136261u;
+        for (const char* c = key; *c; ++c) {
+            hash ^= static_cast<unsigned char>(*c);
+            hash *= 16777619u;
+        }
+
+        return string(context) + SHARD_SEPARATOR + lexical_cast<string>(hash % shard.second);
+    }
+
+    return context;
+}
+
+
+vector<string> DynamoDBStorageService::getPartitions(const char* context) const
+{
+    checkContext(context);
+
+    vector<string> partitions;
+    for (const auto &shard : m_shards) {
+        if (!hasPrefix(context, shard.first) || shard.second < 2) {
+            continue;
+        }
+
+        for (int i = 0; i < shard.second; ++i) {
+            partitions.push_back(string(context) + SHARD_SEPARATOR + lexical_cast<string>(i));
+        }
+        return partitions;
+    }
+
+    partitions.push_back(context);
+    return partitions;
+}
+
+
+void DynamoDBStorageService::forEachPartition(const char* context, const function<void (const string&)> &fn) const
+{
+    const vector<string> partitions = getPartitions(context);
+    if (partitions.size() == 1) {
+        fn(partitions.front());
+        return;
+    }
+
+    // the partitions share the caller's deadline
+    const Deadline* deadline = Deadline::getCurrent();
+    vector<future<void>> results;
+    for (const string &partition : partitions) {
+        results.push_back(fanOut<void>([&fn, partition, deadline] {
+            Deadline::Scope deadlineScope(deadline);
+            fn(partition);
+        }));
+    }
+
+    // wait for every partition before reporting the first failure
+    exception_ptr error;
+    for (auto &result : results) {
+        try {
+            m_executor->wait(result);
+            result.get();
+        } catch (...) {
+            if (!error) {
+                error = current_exception();
+            }
+        }
+    }
+    if (error) {
+        rethrow_exception(error);
+    }
+}
+
+
+template <typename O>
+O DynamoDBStorageService::invoke(bool write, const char* context, const function<O (const DynamoDBClient&)> &call)
+{
+    const auto &endpoints = getEndpoints(context);
+
+    // Requests that are part of a context wide operation get whatever is
+    // left of its deadline; others get the point read or write budget.
+    Deadline pointDeadline(write ? m_writeTimeout : m_readTimeout);
+    const Deadline* deadline = Deadline::getCurrent();
+    if (!deadline) {
+        deadline = &pointDeadline;
+    }
+    Deadline::Scope deadlineScope(deadline);
+    if (deadline->hasExpired()) {
+        m_log.error("operation ran out of time (table=%s; context=%s)",
+            getTableName(context).c_str(),
+            context
+        );
+        throw IOException("DynamoDB Storage operation ran out of time.");
+    }
+
+    O outcome;
+    bool attempted = false;
+    for (const auto &endpoint : orderEndpoints(endpoints)) {
+        if (attempted && deadline->hasExpired()) {
+            m_log.warn("request ran out of time; not trying the next endpoint (table=%s; endpoint=%s)",
+                getTableName(context).c_str(),
+                endpoint->getName().c_str()
+            );
+            break;
+        }
+
+        CircuitBreaker* breaker = endpoint->getBreaker();
+        bool probe = false;
+        if (breaker && !breaker->allowRequest(probe)) {
+            continue;
+        }
+        attempted = true;
+
+        auto start = chrono::steady_clock::now();
+        outcome = call(endpoint->getClient());
+
+        if (outcome.IsSuccess() || !outcome.GetError().ShouldRetry()) {
+            // the endpoint answered, even if it was to say no
+            auto latency = chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - start);
+            endpoint->recordSuccess(latency);
+            if (breaker) {
+                breaker->recordSuccess(latency, probe);
+            }
+            break;
+        }
+
+        endpoint->recordFailure();
+        if (breaker) {
+            breaker->recordFailure(probe);
+        }
+        if (endpoints.size() > 1) {
+            m_log.warn("request failed; trying the next endpoint (table=%s; endpoint=%s)",
+                getTableName(context).c_str(),
+                endpoint->getName().c_str()
+            );
+            logError(outcome.GetError());
+        }
+    }
+
+    // Rather than wait out the timeouts on a degraded table, fail now
+    // and leave the request threads free for work that doesn't need it.
+    if (!attempted) {
+        m_log.debug("all circuits open; failing fast (table=%s; context=%s)",
+            getTableName(context).c_str(),
+            context
+        );
+        throw IOException("DynamoDB Storage is unavailable (circuit open).");
+    }
+
+    if (m_profiler && outcome.IsSuccess()) {
+        const char* operation = "";
+        double units = getConsumedCapacity(outcome.GetResult(), operation);
+        m_profiler->record(operation, context, write, units);
+    }
+
+    return outcome;
+}
+
+
+template <typename R>
+void DynamoDBStorageService::prepareRequest(R &request) const
+{
+    if (m_profiler) {
+        request.SetReturnConsumedCapacity(ReturnConsumedCapacity::TOTAL);
+    }
+
+    logRequest(request);
+}
+
+
+const DynamoDBStorageService::Route* DynamoDBStorageService::getRoute(const char* context) const
+{
+    for (const auto &route : m_routes) {
+        if (strncmp(context, route.prefix.c_str(), route.prefix.length()) == 0) {
+            return &route;
+        }
+    }
+    return nullptr;
+}
+
+
+const string& DynamoDBStorageService::getTableName(const char* context) const
+{
+    const Route* route = getRoute(context);
+    return route ? route->tableName : m_tableName;
+}
+
+
+const vector<shared_ptr<DynamoDBEndpoint>>& DynamoDBStorageService::getEndpoints(const char* context) const
+{
+    const Route* route = getRoute(context);
+    return route && !route->endpoints.empty() ? route->endpoints : m_endpoints;
+}
+
+
+vector<shared_ptr<DynamoDBEndpoint>> DynamoDBStorageService::orderEndpoints(
+    const vector<shared_ptr<DynamoDBEndpoint>> &endpoints
+) const
+{
+    if (endpoints.size() < 2) {
+        return endpoints;
+    }
+
+    vector<double> scores;
+    for (const auto &endpoint : endpoints) {
+        scores.push_back(endpoint->getScore());
+    }
+
+    // Reads and writes both go to the primary as long as it is healthy,
+    // and then fail over by score. Replication between the regions of a
+    // global table is asynchronous, so reading from another one could
+    // miss a write that was just made.
+    vector<size_t> order;
+    for (size_t i = 0; i < endpoints.size(); ++i) {
+        order.push_back(i);
+    }
+    stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        bool aPrimary = endpoints[a]->isPrimary() && endpoints[a]->isHealthy();
+        bool bPrimary = endpoints[b]->isPrimary() && endpoints[b]->isHealthy();
+        if (aPrimary != bPrimary) {
+            return aPrimary;
+        }
+        return scores[a] < scores[b];
+    });
+
+    vector<shared_ptr<DynamoDBEndpoint>> result;
+    for (size_t i : order) {
+        result.push_back(endpoints[i]);
+    }
+    return result;
+}
+
+
+void DynamoDBStorageService::warmEndpoints(bool validateTable)
+{
+    for (auto &endpoint : m_endpoints) {
+        warmConnections(*endpoint, m_tableName, m_warmupConnections, validateTable);
+    }
+
+    for (const auto &route : m_routes) {
+        if (!route.endpoints.empty()) {
+            for (auto &endpoint : route.endpoints) {
+                warmConnections(*endpoint, route.tableName, route.warmupConnections, validateTable);
+            }
+        } else if (validateTable && route.tableName != m_tableName) {
+            // the shared clients are already warm; only check the table
+            for (auto &endpoint : m_endpoints) {
+                warmConnections(*endpoint, route.tableName, 1, true);
+            }
+        }
+    }
+}
+
+
+void DynamoDBStorageService::validateKeysIndex(const TableDescription &table, const DynamoDBEndpoint &endpoint) const
+{
+    const auto &indexes = table.GetGlobalSecondaryIndexes();
+    const auto index = find_if(indexes.cbegin(), indexes.cend(), [&](const GlobalSecondaryIndexDescription &desc) {
+        return desc.GetIndexName() == m_keysIndexName;
+    });
+    if (index == indexes.cend()) {
+        m_log.error("table has no keys index (table=%s; endpoint=%s; index=%s)",
+            table.GetTableName().c_str(),
+            endpoint.getName().c_str(),
+            m_keysIndexName.c_str()
+        );
+        throw XMLToolingException("DynamoDB Storage table has no keys index.");
+    }
+
+    string hashKey, rangeKey;
+    for (const KeySchemaElement &elem : index->GetKeySchema()) {
+        if (elem.GetKeyType() == KeyType::HASH) {
+            hashKey = elem.GetAttributeName();
+        } else if (elem.GetKeyType() == KeyType::RANGE) {
+            rangeKey = elem.GetAttributeName();
+        }
+    }
+
+    // without the expiration in the index the filter can't drop expired
+    // keys, and they would all be listed until TTL removes them
+    const Projection &projection = index->GetProjection();
+    bool hasExpires = projection.GetProjectionType() == ProjectionType::ALL;
+    if (projection.GetProjectionType() == ProjectionType::INCLUDE) {
+        const auto &attrs = projection.GetNonKeyAttributes();
+        hasExpires = find(attrs.cbegin(), attrs.cend(), m_names.expires) != attrs.cend();
+    }
+
+    if (hashKey != m_names.context || rangeKey != m_names.key || !hasExpires) {
+        m_log.error("keys index has the wrong schema (table=%s; endpoint=%s; index=%s; hash=%s; range=%s; expires=%s)",
+            table.GetTableName().c_str(),
+            endpoint.getName().c_str(),
+            m_keysIndexName.c_str(),
+            hashKey.c_str(),
+            rangeKey.c_str(),
+            hasExpires ? "projected" : "missing"
+        );
+        throw XMLToolingException("DynamoDB Storage keys index has the wrong schema.");
+    }
+}
+
+
+void DynamoDBStorageService::warmConnections(DynamoDBEndpoint &endpoint, const string &tableName, int count, bool validateTable)
+{
+    #ifdef _DEBUG
+    NDC ndc("warmConnections")
+    #endif
+
+    DescribeTableRequest request;
+    request.SetTableName(tableName);
+
+    // the table can't be validated without at least one request
+    if (validateTable && count < 1) {
+        count = 1;
+    }
+
+    // Issue the requests concurrently so that each one needs its own
+    // connection from the client pool. The first one through will also
+    // resolve the credentials for the client. These get their own
+    // threads: the executor may have fewer threads than connections.
+    auto start = chrono::steady_clock::now();
+    vector<future<DescribeTableOutcome>> callables;
+    for (int i = 0; i < count; ++i) {
+        logRequest(request);
+        callables.push_back(async(launch::async, [&endpoint, &request]() {
+            return endpoint.getClient().DescribeTable(request);
+        }));
+    }
+
+    int opened = 0;
+    for (auto &callable : callables) {
+        DescribeTableOutcome outcome = callable.get();
+        if (!outcome.IsSuccess()) {
+            m_log.warn("warm connection failed (table=%s; endpoint=%s)",
+                tableName.c_str(),
+                endpoint.getName().c_str()
+            );
+            logError(outcome.GetError());
+            endpoint.recordFailure();
+            continue;
+        }
+        if (opened == 0) {
+            // keep the health score current for endpoints that do not
+            // see much traffic
+            endpoint.recordSuccess(chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - start));
+        }
+
+        if (validateTable && opened == 0) {
+            const TableDescription &table = outcome.GetResult().GetTable();
+
+            string hashKey, rangeKey;
+            for (const KeySchemaElement &elem : table.GetKeySchema()) {
+                if (elem.GetKeyType() == KeyType::HASH) {
+                    hashKey = elem.GetAttributeName();
+                } else if (elem.GetKeyType() == KeyType::RANGE) {
+                    rangeKey = elem.GetAttributeName();
+                }
+            }
+
+            if (hashKey != m_names.context || rangeKey != m_names.key) {
+                m_log.error("table has the wrong key schema (table=%s; endpoint=%s; hash=%s; range=%s)",
+                    tableName.c_str(),
+                    endpoint.getName().c_str(),
+                    hashKey.c_str(),
+                    rangeKey.c_str()
+                );
+                throw XMLToolingException("DynamoDB Storage table has the wrong key schema.");
+            }
+
+            if (!m_keysIndexName.empty()) {
+                validateKeysIndex(table, endpoint);
+            }
+        }
+
+        ++opened;
+    }
+
+    // Only the primary has to be reachable to start; the others are
+    // there for when it isn't, and are tried again as requests need them.
+    if (validateTable && opened == 0 && endpoint.isPrimary()) {
+        m_log.error("unable to describe the table (table=%s; endpoint=%s)",
+            tableName.c_str(),
+            endpoint.getName().c_str()
+        );
+        throw XMLToolingException("DynamoDB Storage unable to validate the table.");
+    } else if (validateTable && opened == 0) {
+        m_log.warn("unable to describe the table on a secondary endpoint (table=%s; endpoint=%s)",
+            tableName.c_str(),
+            endpoint.getName().c_str()
+        );
+    }
+
+    m_log.info("warmed %d of %d connections (table=%s; endpoint=%s)",
+        opened,
+        count,
+        tableName.c_str(),
+        endpoint.getName().c_str()
+    );
+}
+
+
+void DynamoDBStorageService::keepAlive()
+{
+    #ifdef _DEBUG
+    NDC ndc("keepAlive")
+    #endif
+
+    unique_lock<mutex> lock(m_keepAliveMutex);
+    while (!m_keepAliveCond.wait_for(lock, m_keepAliveInterval, [this] { return m_shutdown; })) {
+        lock.unlock();
+        try {
+            warmEndpoints(false);
+        } catch (const std::exception &ex) {
+            m_log.warn("keep alive failed: %s", ex.what());
+        }
+        lock.lock();
+    }
+}
+
+
 template <typename T>
 T DynamoDBStorageService::getItemN(
     const char* context,
@@ -691,18 +3238,18 @@ T DynamoDBStorageService::getItemN(
     if (it == item.cend()) {
         m_log.warn("item has no %s (table=%s; context=%s; key=%s)",
             itemKey.c_str(),
-            m_tableName.c_str(),
+            getTableName(context).c_str(),
             context,
             key
         );
         return 0;
     }
 
-    const string itemValue = it->second.GetN();
+    const string &itemValue = it->second.GetN();
     if (itemValue.empty()) {
         m_log.warn("item has %s that is not numeric (table=%s; context=%s; key=%s)",
             itemKey.c_str(),
-            m_tableName.c_str(),
+            getTableName(context).c_str(),
             context,
             key
         );
@@ -715,7 +3262,7 @@ T DynamoDBStorageService::getItemN(
         m_log.warn("item has %s that cannot be cast: %s (table=%s; context=%s; key=%s)",
             itemKey.c_str(),
             itemValue.c_str(),
-            m_tableName.c_str(),
+            getTableName(context).c_str(),
             context,
             key
         );
@@ -723,7 +3270,7 @@ T DynamoDBStorageService::getItemN(
     }
 }
 
-const string DynamoDBStorageService::getItemS(
+const string& DynamoDBStorageService::getItemS(
     const char* context,
     const char* key,
     const Item &item,
@@ -734,18 +3281,18 @@ const string DynamoDBStorageService::getItemS(
     if (it == item.cend()) {
         m_log.warn("item has no %s (table=%s; context=%s; key=%s)",
             itemKey.c_str(),
-            m_tableName.c_str(),
+            getTableName(context).c_str(),
             context,
             key
         );
-        return "";
+        return EMPTY_STRING;
     }
 
-    const string itemValue = it->second.GetS();
+    const string &itemValue = it->second.GetS();
     if (itemValue.empty()) {
         m_log.warn("item has %s that is empty (table=%s; context=%s; key=%s)",
             itemKey.c_str(),
-            m_tableName.c_str(),
+            getTableName(context).c_str(),
             context,
             key
         );
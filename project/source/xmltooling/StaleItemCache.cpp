@@ -0,0 +1,264 @@
+/* Copyright (c) 2018 University of Illinois Board of Trustees
+ * All rights reserved.
+ *
+ * Developed by:       Technology Services
+ *                     University of Illinois at Urbana-Champaign
+ *                     https://techservices.illinois.edu/
+ *
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal with the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimers.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimers in the
+ *   documentation and/or other materials provided with the distribution.
+ * - Neither the names of Technology Services, University of Illinois at
+ *   Urbana-Champaign, nor the names of its contributors may be used to
+ *   endorse or promote products derived from this Software without
+ *   specific prior written permission.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS WITH THE SOFTWARE.
+ */
+
+#include <uiuc/xmltooling/StaleItemCache.h>
+
+using namespace std;
+
+
+namespace UIUC {
+
+namespace XMLTooling {
+
+StaleItemCache::StaleItemCache(chrono::milliseconds maxStaleness, size_t size, size_t maxBytes)
+    : m_bytes(0),
+      m_maxBytes(maxBytes),
+      m_maxStaleness(maxStaleness),
+      m_served(0),
+      m_size(size < 1 ? 1 : size)
+{
+}
+
+
+void StaleItemCache::store(
+    const string &context,
+    const string &key,
+    const string &value,
+    time_t expiration,
+    int version
+)
+{
+    lock_guard<mutex> lock(m_mutex);
+
+    Entry &entry = use(context);
+    auto it = entry.items.find(key);
+    if (it == entry.items.end()) {
+        m_items.push_front(make_pair(context, key));
+
+        it = entry.items.emplace(key, Stored()).first;
+        it->second.bytes = 0;
+        it->second.order = m_items.begin();
+    } else {
+        m_items.splice(m_items.begin(), m_items, it->second.order);
+    }
+
+    Stored &stored = it->second;
+    m_bytes -= stored.bytes;
+    stored.bytes = context.size() + key.size() + value.size();
+    m_bytes += stored.bytes;
+
+    stored.item.value = value;
+    stored.item.expiration = expiration;
+    stored.item.version = version;
+    stored.item.storedAt = chrono::steady_clock::now();
+
+    prune();
+}
+
+
+// A read that only confirmed the version still shows the stored value
+// is current, as long as it is the same version.
+void StaleItemCache::touch(const string &context, const string &key, int version)
+{
+    lock_guard<mutex> lock(m_mutex);
+
+    auto entry = m_entries.find(context);
+    if (entry == m_entries.end()) {
+        return;
+    }
+
+    auto it = entry->second.items.find(key);
+    if (it != entry->second.items.end()) {
+        if (it->second.item.version == version) {
+            it->second.item.storedAt = chrono::steady_clock::now();
+            m_items.splice(m_items.begin(), m_items, it->second.order);
+        } else {
+            drop(entry, it);
+        }
+    }
+
+    prune();
+}
+
+
+// Only items stored within the staleness limit and not yet expired are
+// returned, and each one returned is counted.
+bool StaleItemCache::lookup(const string &context, const string &key, Item &item)
+{
+    lock_guard<mutex> lock(m_mutex);
+
+    auto entry = m_entries.find(context);
+    if (entry == m_entries.end()) {
+        return false;
+    }
+
+    auto it = entry->second.items.find(key);
+    if (it == entry->second.items.end()) {
+        return false;
+    }
+
+    if (
+        (chrono::steady_clock::now() - it->second.item.storedAt) > m_maxStaleness
+        || (it->second.item.expiration > 0 && it->second.item.expiration <= time(nullptr))
+    ) {
+        drop(entry, it);
+        return false;
+    }
+
+    item = it->second.item;
+    ++m_served;
+    return true;
+}
+
+
+void StaleItemCache::updateExpiration(const string &context, time_t expiration)
+{
+    lock_guard<mutex> lock(m_mutex);
+
+    auto entry = m_entries.find(context);
+    if (entry != m_entries.end()) {
+        for (auto &it : entry->second.items) {
+            it.second.item.expiration = expiration;
+        }
+    }
+}
+
+
+void StaleItemCache::erase(const string &context, const string &key)
+{
+    lock_guard<mutex> lock(m_mutex);
+
+    auto entry = m_entries.find(context);
+    if (entry != m_entries.end()) {
+        auto it = entry->second.items.find(key);
+        if (it != entry->second.items.end()) {
+            drop(entry, it);
+        }
+    }
+}
+
+
+void StaleItemCache::erase(const string &context)
+{
+    lock_guard<mutex> lock(m_mutex);
+
+    auto entry = m_entries.find(context);
+    if (entry != m_entries.end()) {
+        dropContext(entry);
+    }
+}
+
+
+size_t StaleItemCache::getBytes() const
+{
+    lock_guard<mutex> lock(m_mutex);
+    return m_bytes;
+}
+
+
+unsigned long StaleItemCache::getServed() const
+{
+    lock_guard<mutex> lock(m_mutex);
+    return m_served;
+}
+
+
+StaleItemCache::Entry& StaleItemCache::use(const string &context)
+{
+    auto it = m_entries.find(context);
+    if (it != m_entries.end()) {
+        m_lru.splice(m_lru.begin(), m_lru, it->second.lru);
+        return it->second;
+    }
+
+    while (m_entries.size() >= m_size) {
+        dropContext(m_entries.find(m_lru.back()));
+    }
+
+    m_lru.push_front(context);
+
+    Entry &entry = m_entries[context];
+    entry.lru = m_lru.begin();
+
+    return entry;
+}
+
+
+void StaleItemCache::drop(unordered_map<string, Entry>::iterator entry, unordered_map<string, Stored>::iterator it)
+{
+    m_bytes -= it->second.bytes;
+    m_items.erase(it->second.order);
+    entry->second.items.erase(it);
+
+    if (entry->second.items.empty()) {
+        m_lru.erase(entry->second.lru);
+        m_entries.erase(entry);
+    }
+}
+
+
+void StaleItemCache::dropContext(unordered_map<string, Entry>::iterator entry)
+{
+    for (const auto &it : entry->second.items) {
+        m_bytes -= it.second.bytes;
+        m_items.erase(it.second.order);
+    }
+
+    m_lru.erase(entry->second.lru);
+    m_entries.erase(entry);
+}
+
+
+// Items are kept freshest first, so the oldest are dropped until the
+// cache is within its byte budget and holds nothing too old to serve.
+// Items that only aged out are not left taking up room until read.
+void StaleItemCache::prune()
+{
+    const auto now = chrono::steady_clock::now();
+
+    while (!m_items.empty()) {
+        auto entry = m_entries.find(m_items.back().first);
+        auto it = entry->second.items.find(m_items.back().second);
+
+        if (m_bytes <= m_maxBytes && (now - it->second.item.storedAt) <= m_maxStaleness) {
+            break;
+        }
+        drop(entry, it);
+    }
+}
+
+
+} // namespace XMLTooling
+} // namespace UIUC
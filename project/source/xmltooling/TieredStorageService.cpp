@@ -0,0 +1,426 @@
+/* Copyright (c) 2018 University of Illinois Board of Trustees
+ * All rights reserved.
+ *
+ * Developed by:       Technology Services
+ *                     University of Illinois at Urbana-Champaign
+ *                     https://techservices.illinois.edu/
+ *
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal with the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimers.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimers in the
+ *   documentation and/or other materials provided with the distribution.
+ * - Neither the names of Technology Services, University of Illinois at
+ *   Urbana-Champaign, nor the names of its contributors may be used to
+ *   endorse or promote products derived from this Software without
+ *   specific prior written permission.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS WITH THE SOFTWARE.
+ */
+
+#include <uiuc/xmltooling/TieredStorageService.h>
+
+#include <cstring>
+#include <xercesc/util/XMLUniDefs.hpp>
+#include <xmltooling/unicode.h>
+#include <xmltooling/XMLToolingConfig.h>
+#include <xmltooling/util/NDC.h>
+#include <xmltooling/util/XMLHelper.h>
+
+using namespace xmltooling;
+using namespace xercesc;
+using namespace std;
+
+static const int DEFAULT_CACHE_SIZE = 10000;
+static const int DEFAULT_CACHE_BYTES = 64 * 1024 * 1024;
+static const int DEFAULT_CACHE_TTL = 10;
+static const int DEFAULT_STATS_INTERVAL = 300;
+
+
+namespace UIUC {
+
+namespace XMLTooling {
+
+StorageService* TieredStorageServiceFactory(const DOMElement* const & e, bool)
+{
+    return new TieredStorageService(e);
+}
+
+
+TieredStorageService::TieredStorageService(const DOMElement* eRoot)
+    : m_bytes(0),
+      m_deletes(0),
+      m_evictions(0),
+      m_hits(0),
+      m_log(logging::Category::getInstance("UIUC.XMLTooling.TieredStorageService")),
+      m_misses(0),
+      m_statsLogged(chrono::steady_clock::now())
+{
+    static const XMLCh x_CACHE_BYTES[] = UNICODE_LITERAL_10(c,a,c,h,e,B,y,t,e,s);
+    static const XMLCh x_CACHE_SIZE[] = UNICODE_LITERAL_9(c,a,c,h,e,S,i,z,e);
+    static const XMLCh x_CACHE_TTL[] = UNICODE_LITERAL_8(c,a,c,h,e,T,T,L);
+    static const XMLCh x_STATS_INTERVAL[] = UNICODE_LITERAL_13(s,t,a,t,s,I,n,t,e,r,v,a,l);
+    static const XMLCh x_STORAGE_SERVICE[] = UNICODE_LITERAL_14(S,t,o,r,a,g,e,S,e,r,v,i,c,e);
+    static const XMLCh x_TYPE[] = UNICODE_LITERAL_4(t,y,p,e);
+
+    #ifdef _DEBUG
+    NDC ndc("TieredStorageService")
+    #endif
+
+    m_maxEntries = XMLHelper::getAttrInt(eRoot, DEFAULT_CACHE_SIZE, x_CACHE_SIZE);
+    m_maxBytes = XMLHelper::getAttrInt(eRoot, DEFAULT_CACHE_BYTES, x_CACHE_BYTES);
+    m_ttl = chrono::seconds(XMLHelper::getAttrInt(eRoot, DEFAULT_CACHE_TTL, x_CACHE_TTL));
+    m_statsInterval = chrono::seconds(XMLHelper::getAttrInt(eRoot, DEFAULT_STATS_INTERVAL, x_STATS_INTERVAL));
+
+    const DOMElement* eBackend = XMLHelper::getFirstChildElement(eRoot, x_STORAGE_SERVICE);
+    if (!eBackend) {
+        throw XMLToolingException("Tiered Storage requires a StorageService element in configuration.");
+    }
+
+    const string type = XMLHelper::getAttrString(eBackend, "", x_TYPE);
+    if (type.empty()) {
+        throw XMLToolingException("Tiered Storage requires a type on its StorageService element.");
+    }
+
+    m_log.info("building backend storage service of type %s", type.c_str());
+    m_backend.reset(XMLToolingConfig::getConfig().StorageServiceManager.newPlugin(type, eBackend, true));
+}
+
+
+TieredStorageService::~TieredStorageService()
+{
+    logStats(true);
+}
+
+
+bool TieredStorageService::createString(
+    const char* context,
+    const char* key,
+    const char* value,
+    time_t expiration
+)
+{
+    #ifdef _DEBUG
+    NDC ndc("createString")
+    #endif
+
+    bool created = m_backend->createString(context, key, value, expiration);
+
+    lock_guard<mutex> lock(m_mutex);
+    if (created) {
+        store(context, key, value, 1, expiration);
+    } else {
+        erase(getCacheKey(context, key));
+    }
+
+    return created;
+}
+
+
+int TieredStorageService::readString(
+    const char* context,
+    const char* key,
+    string* pvalue,
+    time_t* pexpiration,
+    int version
+)
+{
+    #ifdef _DEBUG
+    NDC ndc("readString")
+    #endif
+
+    const string cacheKey = getCacheKey(context, key);
+    unsigned long deletes = 0;
+
+    {
+        lock_guard<mutex> lock(m_mutex);
+        logStats();
+        deletes = m_deletes;
+
+        auto it = m_cache.find(cacheKey);
+        if (it != m_cache.end()) {
+            Entry &entry = it->second;
+
+            bool fresh = (chrono::steady_clock::now() - entry.cachedAt) < m_ttl
+                && entry.expiration > time(nullptr);
+            bool versionMatch = version && entry.version == version;
+
+            if (!fresh) {
+                erase(cacheKey);
+            } else if (versionMatch || !pvalue || entry.hasValue) {
+                ++m_hits;
+                m_lru.splice(m_lru.begin(), m_lru, entry.lru);
+
+                if (pexpiration) {
+                    *pexpiration = entry.expiration;
+                }
+                if (pvalue) {
+                    pvalue->erase();
+                    if (!versionMatch) {
+                        pvalue->append(entry.value);
+                    }
+                }
+
+                return entry.version;
+            }
+        }
+
+        ++m_misses;
+    }
+
+    // Always ask for the expiration so that we know how long the item
+    // may be cached, even if the caller didn't want it.
+    string value;
+    time_t expiration = 0;
+    int itemVersion = m_backend->readString(context, key, pvalue ? &value : nullptr, &expiration, version);
+
+    if (pexpiration) {
+        *pexpiration = expiration;
+    }
+    if (pvalue) {
+        pvalue->erase();
+        pvalue->append(value);
+    }
+
+    lock_guard<mutex> lock(m_mutex);
+    if (itemVersion == 0) {
+        erase(cacheKey);
+    } else if (m_deletes != deletes) {
+        // a delete ran while we were reading, and what we read might be
+        // what it deleted
+    } else if (pvalue && !(version && itemVersion == version)) {
+        store(context, key, value.c_str(), itemVersion, expiration);
+    } else {
+        // we know the version but not the value; still useful for
+        // answering version checks
+        store(context, key, nullptr, itemVersion, expiration);
+    }
+
+    return itemVersion;
+}
+
+
+int TieredStorageService::updateString(
+    const char* context,
+    const char* key,
+    const char* value,
+    time_t expiration,
+    int version
+)
+{
+    #ifdef _DEBUG
+    NDC ndc("updateString")
+    #endif
+
+    const string cacheKey = getCacheKey(context, key);
+
+    int itemVersion = m_backend->updateString(context, key, value, expiration, version);
+
+    lock_guard<mutex> lock(m_mutex);
+    auto it = m_cache.find(cacheKey);
+    if (itemVersion > 0 && value && (expiration > 0 || it != m_cache.end())) {
+        store(context, key, value, itemVersion, expiration > 0 ? expiration : it->second.expiration);
+    } else {
+        erase(cacheKey);
+    }
+
+    return itemVersion;
+}
+
+
+bool TieredStorageService::deleteString(
+    const char* context,
+    const char* key
+)
+{
+    #ifdef _DEBUG
+    NDC ndc("deleteString")
+    #endif
+
+    // Cleared after the backend call, so that a read can't put the item
+    // back in between. Reads still in flight when it finishes see the
+    // delete count change and don't cache what they got.
+    bool deleted = m_backend->deleteString(context, key);
+
+    lock_guard<mutex> lock(m_mutex);
+    erase(getCacheKey(context, key));
+    ++m_deletes;
+
+    return deleted;
+}
+
+
+void TieredStorageService::updateContext(const char* context, time_t expiration)
+{
+    #ifdef _DEBUG
+    NDC ndc("updateContext")
+    #endif
+
+    m_backend->updateContext(context, expiration);
+
+    lock_guard<mutex> lock(m_mutex);
+    auto keys = m_contexts.find(context);
+    if (keys != m_contexts.end()) {
+        for (const string &cacheKey : keys->second) {
+            auto it = m_cache.find(cacheKey);
+            if (it != m_cache.end()) {
+                it->second.expiration = expiration;
+            }
+        }
+    }
+}
+
+
+void TieredStorageService::deleteContext(const char* context)
+{
+    #ifdef _DEBUG
+    NDC ndc("deleteContext")
+    #endif
+
+    // cleared after the backend call for the same reasons as deleteString
+    m_backend->deleteContext(context);
+
+    lock_guard<mutex> lock(m_mutex);
+    auto keys = m_contexts.find(context);
+    if (keys != m_contexts.end()) {
+        // erase modifies the set we are walking
+        const unordered_set<string> cacheKeys = keys->second;
+        for (const string &cacheKey : cacheKeys) {
+            erase(cacheKey);
+        }
+    }
+    ++m_deletes;
+}
+
+
+TieredStorageService::Stats TieredStorageService::getStats() const
+{
+    lock_guard<mutex> lock(m_mutex);
+
+    Stats stats;
+    stats.hits = m_hits;
+    stats.misses = m_misses;
+    stats.evictions = m_evictions;
+    stats.entries = m_cache.size();
+    stats.bytes = m_bytes;
+
+    return stats;
+}
+
+
+const string TieredStorageService::getCacheKey(const char* context, const char* key) const
+{
+    string cacheKey(context);
+    cacheKey.push_back('\0');
+    cacheKey.append(key);
+
+    return cacheKey;
+}
+
+
+void TieredStorageService::store(
+    const char* context,
+    const char* key,
+    const char* value,
+    int version,
+    time_t expiration
+)
+{
+    const string cacheKey = getCacheKey(context, key);
+
+    // A read that started before an update can finish after it; never
+    // replace what the update cached with the older version.
+    auto it = m_cache.find(cacheKey);
+    if (it != m_cache.end()) {
+        const Entry &cached = it->second;
+        if (cached.version > version || (cached.version == version && cached.hasValue && !value)) {
+            return;
+        }
+    }
+    erase(cacheKey);
+
+    if (m_maxEntries == 0 || (value && strlen(value) > m_maxBytes)) {
+        return;
+    }
+
+    m_lru.push_front(cacheKey);
+
+    Entry &entry = m_cache[cacheKey];
+    entry.context = context;
+    entry.key = key;
+    entry.hasValue = value != nullptr;
+    if (value) {
+        entry.value = value;
+    }
+    entry.version = version;
+    entry.expiration = expiration;
+    entry.cachedAt = chrono::steady_clock::now();
+    entry.lru = m_lru.begin();
+
+    m_contexts[entry.context].insert(cacheKey);
+    m_bytes += entry.value.size();
+
+    while (m_cache.size() > m_maxEntries || m_bytes > m_maxBytes) {
+        ++m_evictions;
+        erase(m_lru.back());
+    }
+}
+
+
+void TieredStorageService::erase(const string &cacheKey)
+{
+    auto it = m_cache.find(cacheKey);
+    if (it == m_cache.end()) {
+        return;
+    }
+
+    auto keys = m_contexts.find(it->second.context);
+    if (keys != m_contexts.end()) {
+        keys->second.erase(cacheKey);
+        if (keys->second.empty()) {
+            m_contexts.erase(keys);
+        }
+    }
+
+    m_bytes -= it->second.value.size();
+    m_lru.erase(it->second.lru);
+    m_cache.erase(it);
+}
+
+
+void TieredStorageService::logStats(bool force)
+{
+    auto now = chrono::steady_clock::now();
+    if (!force && (m_statsInterval.count() <= 0 || (now - m_statsLogged) < m_statsInterval)) {
+        return;
+    }
+    m_statsLogged = now;
+
+    unsigned long lookups = m_hits + m_misses;
+    m_log.info("cache stats: entries=%lu; bytes=%lu; hits=%lu; misses=%lu; hitRate=%.1f%%; evictions=%lu",
+        static_cast<unsigned long>(m_cache.size()),
+        static_cast<unsigned long>(m_bytes),
+        m_hits,
+        m_misses,
+        lookups ? (100.0 * m_hits / lookups) : 0.0,
+        m_evictions
+    );
+}
+
+} // namespace XMLTooling
+} // namespace UIUC
@@ -0,0 +1,349 @@
+/* Copyright (c) 2018 University of Illinois Board of Trustees
+ * All rights reserved.
+ *
+ * Developed by:       Technology Services
+ *                     University of Illinois at Urbana-Champaign
+ *                     https://techservices.illinois.edu/
+ *
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal with the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimers.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimers in the
+ *   documentation and/or other materials provided with the distribution.
+ * - Neither the names of Technology Services, University of Illinois at
+ *   Urbana-Champaign, nor the names of its contributors may be used to
+ *   endorse or promote products derived from this Software without
+ *   specific prior written permission.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS WITH THE SOFTWARE.
+ */
+
+#include <uiuc/xmltooling/TraceRecorder.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <limits>
+#include <vector>
+
+using namespace xmltooling;
+using namespace std;
+
+// Every trace file starts with this so replay can reject anything else.
+static const char TRACE_MAGIC[8] = { 'U', 'I', 'U', 'C', 'T', 'R', 'C', '1' };
+// The writer drains at most this many records per lock.
+static const size_t WRITE_BATCH = 256;
+
+static const uint64_t FNV_OFFSET = 14695981039346656037ULL;
+static const uint64_t FNV_PRIME = 1099511628211ULL;
+
+
+static void putLE(char* buf, uint64_t value, size_t bytes)
+{
+    for (size_t i = 0; i < bytes; ++i) {
+        buf[i] = static_cast<char>((value >> (8 * i)) & 0xff);
+    }
+}
+
+static uint64_t getLE(const char* buf, size_t bytes)
+{
+    uint64_t value = 0;
+    for (size_t i = 0; i < bytes; ++i) {
+        value |= static_cast<uint64_t>(static_cast<unsigned char>(buf[i])) << (8 * i);
+    }
+    return value;
+}
+
+template <typename T>
+static T clampTo(long long value)
+{
+    if (value < numeric_limits<T>::min()) {
+        return numeric_limits<T>::min();
+    }
+    if (value > numeric_limits<T>::max()) {
+        return numeric_limits<T>::max();
+    }
+    return static_cast<T>(value);
+}
+
+
+namespace UIUC {
+
+namespace XMLTooling {
+
+TraceRecorder::Scope::Scope(
+    TraceRecorder* recorder,
+    Operation operation,
+    const char* context,
+    const char* key,
+    size_t valueSize,
+    time_t expiration,
+    int version,
+    bool hasValue
+)
+    : m_finished(false),
+      m_recorder(recorder)
+{
+    if (!m_recorder) {
+        return;
+    }
+
+    m_start = chrono::steady_clock::now();
+
+    m_record.timestamp = chrono::duration_cast<chrono::microseconds>(
+        chrono::system_clock::now().time_since_epoch()
+    ).count();
+    m_record.contextHash = hash(context);
+    m_record.keyHash = key ? hash(key) : 0;
+    m_record.valueSize = clampTo<uint32_t>(valueSize);
+    // expirations are stored relative to the call so a replay lands in
+    // the future no matter when it is run
+    m_record.expiration = expiration > 0 ? clampTo<int32_t>(expiration - time(nullptr)) : 0;
+    m_record.version = version;
+    m_record.latency = 0;
+    m_record.operation = static_cast<uint8_t>(operation);
+    m_record.outcome = FAILURE;
+    // an update without a value only changes the expiration
+    m_record.flags = hasValue ? 0 : NO_VALUE;
+}
+
+
+TraceRecorder::Scope::~Scope()
+{
+    // anything not finished left through an exception
+    if (m_recorder && !m_finished) {
+        finish(FAILURE);
+    }
+}
+
+
+void TraceRecorder::Scope::finish(Outcome outcome, size_t valueSize)
+{
+    if (!m_recorder || m_finished) {
+        return;
+    }
+    m_finished = true;
+
+    m_record.latency = clampTo<uint32_t>(chrono::duration_cast<chrono::microseconds>(
+        chrono::steady_clock::now() - m_start
+    ).count());
+    m_record.outcome = static_cast<uint8_t>(outcome);
+    if (valueSize > 0) {
+        m_record.valueSize = clampTo<uint32_t>(valueSize);
+    }
+
+    m_recorder->record(m_record);
+}
+
+
+TraceRecorder::TraceRecorder(const string &path, size_t maxSize, unsigned int maxFiles, size_t queueSize)
+    : m_dropped(0),
+      m_fileSize(0),
+      m_log(logging::Category::getInstance("UIUC.XMLTooling.TraceRecorder")),
+      m_maxFiles(maxFiles < 1 ? 1 : maxFiles),
+      m_maxSize(maxSize < sizeof(TRACE_MAGIC) + RECORD_SIZE ? sizeof(TRACE_MAGIC) + RECORD_SIZE : maxSize),
+      m_path(path),
+      m_queueSize(queueSize < 1 ? 1 : queueSize),
+      m_shutdown(false)
+{
+    m_writer = thread(&TraceRecorder::run, this);
+}
+
+
+TraceRecorder::~TraceRecorder()
+{
+    {
+        lock_guard<mutex> lock(m_mutex);
+        m_shutdown = true;
+    }
+    m_cond.notify_all();
+    m_writer.join();
+
+    if (m_dropped > 0) {
+        m_log.warn("dropped %lu trace records because the writer fell behind", m_dropped);
+    }
+}
+
+
+void TraceRecorder::record(const Record &record)
+{
+    {
+        lock_guard<mutex> lock(m_mutex);
+
+        // the request thread never waits on the disk; if the writer is
+        // behind the record is dropped and counted instead
+        if (m_shutdown || m_queue.size() >= m_queueSize) {
+            ++m_dropped;
+            return;
+        }
+        m_queue.push_back(record);
+    }
+    m_cond.notify_one();
+}
+
+
+uint64_t TraceRecorder::hash(const char* value)
+{
+    uint64_t h = FNV_OFFSET;
+    for (const char* c = value; c && *c; ++c) {
+        h ^= static_cast<unsigned char>(*c);
+        h *= FNV_PRIME;
+    }
+    return h;
+}
+
+
+bool TraceRecorder::readHeader(istream &in)
+{
+    char magic[sizeof(TRACE_MAGIC)];
+    if (!in.read(magic, sizeof(magic))) {
+        return false;
+    }
+    return equal(magic, magic + sizeof(magic), TRACE_MAGIC);
+}
+
+
+bool TraceRecorder::readRecord(istream &in, Record &record)
+{
+    char buf[RECORD_SIZE];
+    if (!in.read(buf, sizeof(buf))) {
+        return false;
+    }
+
+    record.timestamp = getLE(buf, 8);
+    record.contextHash = getLE(buf + 8, 8);
+    record.keyHash = getLE(buf + 16, 8);
+    record.valueSize = static_cast<uint32_t>(getLE(buf + 24, 4));
+    record.expiration = static_cast<int32_t>(getLE(buf + 28, 4));
+    record.version = static_cast<int32_t>(getLE(buf + 32, 4));
+    record.latency = static_cast<uint32_t>(getLE(buf + 36, 4));
+    record.operation = static_cast<uint8_t>(buf[40]);
+    record.outcome = static_cast<uint8_t>(buf[41]);
+    record.flags = static_cast<uint8_t>(buf[42]);
+    return true;
+}
+
+
+void TraceRecorder::run()
+{
+    if (!openFile()) {
+        lock_guard<mutex> lock(m_mutex);
+        m_shutdown = true;
+        m_dropped += m_queue.size();
+        m_queue.clear();
+        return;
+    }
+
+    vector<Record> batch;
+    batch.reserve(WRITE_BATCH);
+
+    while (true) {
+        {
+            unique_lock<mutex> lock(m_mutex);
+            m_cond.wait(lock, [this]{ return m_shutdown || !m_queue.empty(); });
+
+            if (m_queue.empty()) {
+                break;
+            }
+            while (!m_queue.empty() && batch.size() < WRITE_BATCH) {
+                batch.push_back(m_queue.front());
+                m_queue.pop_front();
+            }
+        }
+
+        for (const auto &record : batch) {
+            write(record);
+        }
+        batch.clear();
+        m_file.flush();
+    }
+
+    m_file.close();
+}
+
+
+bool TraceRecorder::openFile()
+{
+    m_file.open(m_path, ios::binary | ios::out | ios::app);
+    if (!m_file) {
+        m_log.error("unable to open trace file (path=%s)", m_path.c_str());
+        return false;
+    }
+
+    m_file.seekp(0, ios::end);
+    m_fileSize = static_cast<size_t>(m_file.tellp());
+    if (m_fileSize == 0) {
+        m_file.write(TRACE_MAGIC, sizeof(TRACE_MAGIC));
+        m_fileSize = sizeof(TRACE_MAGIC);
+    }
+
+    return true;
+}
+
+
+void TraceRecorder::rotate()
+{
+    m_file.close();
+
+    // path.(n-1) is dropped, everything else moves up one
+    if (m_maxFiles > 1) {
+        for (unsigned int i = m_maxFiles - 1; i > 1; --i) {
+            string from = m_path + "." + to_string(i - 1);
+            string to = m_path + "." + to_string(i);
+            rename(from.c_str(), to.c_str());
+        }
+        rename(m_path.c_str(), (m_path + ".1").c_str());
+    } else {
+        remove(m_path.c_str());
+    }
+
+    if (!openFile()) {
+        throw ios_base::failure("unable to reopen trace file");
+    }
+}
+
+
+void TraceRecorder::write(const Record &record)
+{
+    if (m_fileSize + RECORD_SIZE > m_maxSize) {
+        try {
+            rotate();
+        } catch (const exception &ex) {
+            m_log.error("unable to rotate trace file (path=%s): %s", m_path.c_str(), ex.what());
+            return;
+        }
+    }
+
+    char buf[RECORD_SIZE] = { 0 };
+    putLE(buf, record.timestamp, 8);
+    putLE(buf + 8, record.contextHash, 8);
+    putLE(buf + 16, record.keyHash, 8);
+    putLE(buf + 24, record.valueSize, 4);
+    putLE(buf + 28, static_cast<uint32_t>(record.expiration), 4);
+    putLE(buf + 32, static_cast<uint32_t>(record.version), 4);
+    putLE(buf + 36, record.latency, 4);
+    buf[40] = static_cast<char>(record.operation);
+    buf[41] = static_cast<char>(record.outcome);
+    buf[42] = static_cast<char>(record.flags);
+
+    m_file.write(buf, sizeof(buf));
+    m_fileSize += sizeof(buf);
+}
+
+
+} // namespace XMLTooling
+} // namespace UIUC
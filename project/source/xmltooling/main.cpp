@@ -39,35 +39,66 @@
 # define UIUC_SHIBPLUGINS_EXPORTS
 #endif
 
+#include <uiuc/aws_sdk/core/http/curl/SharedCurlHttpClient.h>
 #include <uiuc/aws_sdk/core/utils/logging/XMLToolingLogSystem.h>
 #include <uiuc/xmltooling/DynamoDBStorageService.h>
+#include <uiuc/xmltooling/TieredStorageService.h>
 
+#include <chrono>
+#include <xercesc/util/XMLUniDefs.hpp>
+#include <xmltooling/unicode.h>
 #include <xmltooling/XMLToolingConfig.h>
+#include <xmltooling/util/XMLHelper.h>
 
+using namespace UIUC::AWS_SDK::Http;
 using namespace UIUC::AWS_SDK::Utils::Logging;
 using namespace xmltooling;
+using namespace xercesc;
 using namespace std;
 
+static const char* ALLOCATION_TAG = "ShibPlugins";
+
+static const bool DEFAULT_SHARED_HTTP_CLIENT = false;
+static const char* DEFAULT_HTTP_VERSION = "1.1";
+static const int DEFAULT_HTTP_STATS_INTERVAL = 300;
+
 static Aws::SDKOptions sdkOptions;
 
 
-extern "C" int UIUC_SHIBPLUGINS_EXPORTS xmltooling_extension_init(void*)
+extern "C" int UIUC_SHIBPLUGINS_EXPORTS xmltooling_extension_init(void* context)
 {
+    static const XMLCh x_HTTP_STATS_INTERVAL[] = UNICODE_LITERAL_17(h,t,t,p,S,t,a,t,s,I,n,t,e,r,v,a,l);
+    static const XMLCh x_HTTP_VERSION[] = UNICODE_LITERAL_11(h,t,t,p,V,e,r,s,i,o,n);
+    static const XMLCh x_SHARED_HTTP_CLIENT[] = UNICODE_LITERAL_16(s,h,a,r,e,d,H,t,t,p,C,l,i,e,n,t);
+
     shared_ptr<XMLToolingLogSystem> tmpLogger = make_shared<XMLToolingLogSystem>();
 
     sdkOptions.loggingOptions.logLevel = tmpLogger->GetLogLevel();
     sdkOptions.loggingOptions.logger_create_fn = []() {
         return make_shared<XMLToolingLogSystem>();
     };
+
+    // shibd passes the Library element that loaded the plugin
+    const DOMElement* eLibrary = reinterpret_cast<const DOMElement*>(context);
+    if (eLibrary && XMLHelper::getAttrBool(eLibrary, DEFAULT_SHARED_HTTP_CLIENT, x_SHARED_HTTP_CLIENT)) {
+        const bool http2 = XMLHelper::getAttrString(eLibrary, DEFAULT_HTTP_VERSION, x_HTTP_VERSION) != "1.1";
+        const chrono::seconds statsInterval(XMLHelper::getAttrInt(eLibrary, DEFAULT_HTTP_STATS_INTERVAL, x_HTTP_STATS_INTERVAL));
+
+        sdkOptions.httpOptions.httpClientFactory_create_fn = [http2, statsInterval]() -> shared_ptr<Aws::Http::HttpClientFactory> {
+            return Aws::MakeShared<SharedCurlHttpClientFactory>(ALLOCATION_TAG, http2, statsInterval);
+        };
+    }
     Aws::InitAPI(sdkOptions);
 
     // Register this SS type
     XMLToolingConfig::getConfig().StorageServiceManager.registerFactory("UIUC-DynamoDB", UIUC::XMLTooling::DynamoDBStorageServiceFactory);
+    XMLToolingConfig::getConfig().StorageServiceManager.registerFactory("UIUC-Tiered", UIUC::XMLTooling::TieredStorageServiceFactory);
     return 0;
 }
 
 extern "C" void UIUC_SHIBPLUGINS_EXPORTS xmltooling_extension_term()
 {
+    XMLToolingConfig::getConfig().StorageServiceManager.deregisterFactory("UIUC-Tiered");
     XMLToolingConfig::getConfig().StorageServiceManager.deregisterFactory("UIUC-DynamoDB");
 
     Aws::ShutdownAPI(sdkOptions);
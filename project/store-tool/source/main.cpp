@@ -37,13 +37,22 @@
 #include <aws/core/utils/json/JsonSerializer.h>
 #include <boost/format.hpp>
 #include <boost/program_options.hpp>
+#include <chrono>
+#include <ctime>
 #include <fstream>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <uiuc/xmltooling/DynamoDBStorageService.h>
+#include <uiuc/xmltooling/TraceRecorder.h>
+#include <unordered_map>
 #include <xmltooling/XMLToolingConfig.h>
 #include <xmltooling/util/ParserPool.h>
 #include <xmltooling/util/StorageService.h>
 #include <xmltooling/util/XMLHelper.h>
 
 using namespace Aws::Utils::Json;
+using namespace UIUC::XMLTooling;
 using namespace xmltooling;
 using namespace xercesc;
 using namespace boost;
@@ -141,6 +150,7 @@ JsonValue handleCreate(std::shared_ptr<StorageService> store)
     string opt_key;
     string opt_value;
     time_t opt_expiration = 0;
+    bool opt_async = false;
 
     po::options_description desc(opt_command + " options");
     desc.add_options()
@@ -148,6 +158,7 @@ JsonValue handleCreate(std::shared_ptr<StorageService> store)
         ("key", po::value<string>(&opt_key)->required(), "key name")
         ("value", po::value<string>(&opt_value)->required(), "value")
         ("expiration", po::value<time_t>(&opt_expiration)->required(), "expiration time (UTC timestamp)")
+        ("async", po::bool_switch(&opt_async), "use the plugin's async call")
     ;
 
     po::positional_options_description pos;
@@ -170,8 +181,17 @@ JsonValue handleCreate(std::shared_ptr<StorageService> store)
         throw options_error(true);
     }
 
+    auto dynamodb = std::dynamic_pointer_cast<DynamoDBStorageService>(store);
+
     bool success = false;
-    if (opt_command == "createString")
+    if (opt_async && dynamodb)
+        success = dynamodb->createStringAsync(
+            opt_context,
+            opt_key,
+            opt_value,
+            opt_expiration
+        ).get();
+    else if (opt_command == "createString")
         success = store->createString(
             opt_context.c_str(),
             opt_key.c_str(),
@@ -195,11 +215,13 @@ JsonValue handleDelete(std::shared_ptr<StorageService> store)
 {
     string opt_context;
     string opt_key;
+    bool opt_async = false;
 
     po::options_description desc(opt_command + " options");
     desc.add_options()
         ("context", po::value<string>(&opt_context)->required(), "context name")
         ("key", po::value<string>(&opt_key)->required(), "key name")
+        ("async", po::bool_switch(&opt_async), "use the plugin's async call")
     ;
 
     po::positional_options_description pos;
@@ -220,8 +242,15 @@ JsonValue handleDelete(std::shared_ptr<StorageService> store)
         throw options_error(true);
     }
 
+    auto dynamodb = std::dynamic_pointer_cast<DynamoDBStorageService>(store);
+
     bool success = false;
-    if (opt_command == "deleteString")
+    if (opt_async && dynamodb)
+        success = dynamodb->deleteStringAsync(
+            opt_context,
+            opt_key
+        ).get();
+    else if (opt_command == "deleteString")
         success = store->deleteString(
             opt_context.c_str(),
             opt_key.c_str()
@@ -240,15 +269,15 @@ JsonValue handleDelete(std::shared_ptr<StorageService> store)
 
 JsonValue handleDeleteContext(std::shared_ptr<StorageService> store)
 {
-    string opt_context;
+    vector<string> opt_contexts;
 
     po::options_description desc(opt_command + " options");
     desc.add_options()
-        ("context", po::value<string>(&opt_context)->required(), "context name")
+        ("context", po::value<vector<string>>(&opt_contexts)->required(), "context names")
     ;
 
     po::positional_options_description pos;
-    pos.add("context", 1);
+    pos.add("context", -1);
 
     po::variables_map vm;
     po::command_line_parser parser = po::command_line_parser(opt_commandArgs)
@@ -259,17 +288,39 @@ JsonValue handleDeleteContext(std::shared_ptr<StorageService> store)
         po::notify(vm);
     } catch (const std::exception &ex) {
         cerr << "Exception parsing arguments: " << ex.what() << endl << endl;
-        outputHelp(opt_command + " [context]", desc);
+        outputHelp(opt_command + " [context]...", desc);
 
         throw options_error(true);
     }
 
-    store->deleteContext(
-        opt_context.c_str()
-    );
+    // contexts are deleted concurrently when the plugin supports it
+    auto dynamodb = std::dynamic_pointer_cast<DynamoDBStorageService>(store);
+    if (dynamodb) {
+        vector<future<void>> results;
+        for (const auto &context : opt_contexts) {
+            results.push_back(dynamodb->deleteContextAsync(context));
+        }
+        for (auto &result : results) {
+            result.get();
+        }
+    } else {
+        for (const auto &context : opt_contexts) {
+            store->deleteContext(context.c_str());
+        }
+    }
 
+    if (opt_contexts.size() == 1) {
+        return JsonValue()
+            .WithString("context", opt_contexts.front())
+            .WithBool("result", true);
+    }
+
+    Aws::Vector<JsonValue> contexts;
+    for (const auto &context : opt_contexts) {
+        contexts.push_back(JsonValue().AsString(context));
+    }
     return JsonValue()
-        .WithString("context", opt_context)
+        .WithArray("contexts", contexts)
         .WithBool("result", true);
 }
 
@@ -280,6 +331,7 @@ JsonValue handleRead(std::shared_ptr<StorageService> store)
     bool opt_skip_value = false;
     bool opt_skip_expiration = false;
     int opt_version = 0;
+    bool opt_async = false;
 
     po::options_description desc(opt_command + " options");
     desc.add_options()
@@ -288,6 +340,7 @@ JsonValue handleRead(std::shared_ptr<StorageService> store)
         ("version", po::value<int>(&opt_version), "read only if this version")
         ("skip-value", po::bool_switch(&opt_skip_value), "skip returning the value")
         ("skip-expiration", po::bool_switch(&opt_skip_expiration), "skip returning the expiration")
+        ("async", po::bool_switch(&opt_async), "use the plugin's async call")
     ;
 
     po::positional_options_description pos;
@@ -312,7 +365,18 @@ JsonValue handleRead(std::shared_ptr<StorageService> store)
     string value;
     time_t expiration = 0;
 
-    if (opt_command == "readString")
+    auto dynamodb = std::dynamic_pointer_cast<DynamoDBStorageService>(store);
+    if (opt_async && dynamodb) {
+        // the async read always returns the value and expiration
+        DynamoDBStorageService::ReadResult result = dynamodb->readStringAsync(
+            opt_context,
+            opt_key,
+            opt_version
+        ).get();
+        version = result.version;
+        value = result.value;
+        expiration = result.expiration;
+    } else if (opt_command == "readString")
         version = store->readString(
             opt_context.c_str(),
             opt_key.c_str(),
@@ -362,14 +426,16 @@ JsonValue handleUpdate(std::shared_ptr<StorageService> store)
     string opt_value;
     time_t opt_expiration = 0;
     int opt_version = 0;
+    bool opt_async = false;
 
     po::options_description desc(opt_command + " options");
     desc.add_options()
         ("context", po::value<string>(&opt_context)->required(), "context name")
         ("key", po::value<string>(&opt_key)->required(), "key name")
-        ("value", po::value<string>(&opt_value)->required(), "value")
+        ("value", po::value<string>(&opt_value), "value; only updated if specified")
         ("expiration", po::value<time_t>(&opt_expiration), "expiration time (UTC timestamp); only updated if specified")
         ("version", po::value<int>(&opt_version), "only update if the version number matches")
+        ("async", po::bool_switch(&opt_async), "use the plugin's async call")
     ;
 
     po::positional_options_description pos;
@@ -391,12 +457,24 @@ JsonValue handleUpdate(std::shared_ptr<StorageService> store)
         throw options_error(true);
     }
 
+    // without a value only the expiration is updated
+    const char* value = vm.count("value") ? opt_value.c_str() : nullptr;
+    auto dynamodb = std::dynamic_pointer_cast<DynamoDBStorageService>(store);
+
     int version = 0;
-    if (opt_command == "updateString")
+    if (opt_async && dynamodb)
+        version = dynamodb->updateStringAsync(
+            opt_context,
+            opt_key,
+            value ? opt_value : string(),
+            opt_expiration,
+            opt_version
+        ).get();
+    else if (opt_command == "updateString")
         version = store->updateString(
             opt_context.c_str(),
             opt_key.c_str(),
-            opt_value.c_str(),
+            value,
             opt_expiration,
             opt_version
         );
@@ -404,7 +482,7 @@ JsonValue handleUpdate(std::shared_ptr<StorageService> store)
         version = store->updateText(
             opt_context.c_str(),
             opt_key.c_str(),
-            opt_value.c_str(),
+            value,
             opt_expiration,
             opt_version
         );
@@ -417,6 +495,145 @@ JsonValue handleUpdate(std::shared_ptr<StorageService> store)
     return rv;
 }
 
+JsonValue handleReadMany(std::shared_ptr<StorageService> store)
+{
+    vector<string> opt_items;
+    bool opt_skip_value = false;
+    int opt_version = 0;
+
+    po::options_description desc(opt_command + " options");
+    desc.add_options()
+        ("items", po::value<vector<string>>(&opt_items)->required(), "context and key pairs")
+        ("version", po::value<int>(&opt_version), "read only if this version")
+        ("skip-value", po::bool_switch(&opt_skip_value), "skip returning the values")
+    ;
+
+    po::positional_options_description pos;
+    pos.add("items", -1);
+
+    po::variables_map vm;
+    po::command_line_parser parser = po::command_line_parser(opt_commandArgs)
+        .options(desc)
+        .positional(pos);
+    try {
+        po::store(parser.run(), vm);
+        po::notify(vm);
+
+        if (opt_items.size() % 2 != 0)
+            throw runtime_error("each context needs a key");
+    } catch (const std::exception &ex) {
+        cerr << "Exception parsing arguments: " << ex.what() << endl << endl;
+        outputHelp(opt_command + " [context key]... [command options]", desc);
+
+        throw options_error(true);
+    }
+
+    vector<DynamoDBStorageService::ReadRequest> requests;
+    for (size_t i = 0; i < opt_items.size(); i += 2) {
+        DynamoDBStorageService::ReadRequest request;
+        request.context = opt_items[i];
+        request.key = opt_items[i + 1];
+        request.version = opt_version;
+        requests.push_back(request);
+    }
+
+    vector<DynamoDBStorageService::ReadResult> results;
+    auto dynamodb = std::dynamic_pointer_cast<DynamoDBStorageService>(store);
+    if (dynamodb) {
+        results = dynamodb->readStrings(requests, !opt_skip_value);
+    } else {
+        // other plugins get the same answers one read at a time
+        for (const auto &request : requests) {
+            DynamoDBStorageService::ReadResult result;
+            result.expiration = 0;
+            result.version = store->readString(
+                request.context.c_str(),
+                request.key.c_str(),
+                opt_skip_value ? nullptr : &result.value,
+                &result.expiration,
+                request.version
+            );
+            results.push_back(result);
+        }
+    }
+
+    Aws::Vector<JsonValue> items;
+    bool found = false;
+    for (size_t i = 0; i < requests.size(); ++i) {
+        const auto &result = results[i];
+        JsonValue item;
+
+        item.WithString("context", requests[i].context).WithString("key", requests[i].key);
+        item.WithBool("result", result.version > 0);
+        if (result.version > 0) {
+            found = true;
+
+            item.WithInteger("version", result.version);
+            if (!opt_skip_value) {
+                if (opt_version) {
+                    item.WithBool("version_changed", opt_version != result.version);
+                    if (opt_version != result.version)
+                        item.WithString("value", result.value);
+                } else {
+                    item.WithString("value", result.value);
+                }
+            }
+            item.WithInteger("expiration", result.expiration);
+        }
+
+        items.push_back(item);
+    }
+
+    return JsonValue().WithArray("items", items).WithBool("result", found);
+}
+
+JsonValue handleMigrate(std::shared_ptr<StorageService> store)
+{
+    string opt_source_table;
+    string opt_source_names;
+
+    po::options_description desc(opt_command + " options");
+    desc.add_options()
+        ("source-table", po::value<string>(&opt_source_table)->required(), "table to copy the items from")
+        ("source-names", po::value<string>(&opt_source_names)->default_value("legacy"), "attribute names the source table uses")
+    ;
+
+    po::positional_options_description pos;
+    pos.add("source-table", 1);
+
+    po::variables_map vm;
+    po::command_line_parser parser = po::command_line_parser(opt_commandArgs)
+        .options(desc)
+        .positional(pos);
+    try {
+        po::store(parser.run(), vm);
+        po::notify(vm);
+    } catch (const std::exception &ex) {
+        cerr << "Exception parsing arguments: " << ex.what() << endl << endl;
+        outputHelp(opt_command + " [source table] [command options]", desc);
+
+        throw options_error(true);
+    }
+
+    auto dynamodb = std::dynamic_pointer_cast<DynamoDBStorageService>(store);
+    if (!dynamodb)
+        throw runtime_error("migrate only works with the DynamoDB plugin");
+
+    // the configured table and attribute names are the destination
+    unsigned long skipped = 0;
+    unsigned long copied = dynamodb->copyTable(
+        opt_source_table,
+        DynamoDBStorageService::parseAttributeNames(opt_source_names),
+        &skipped
+    );
+
+    return JsonValue()
+        .WithBool("result", true)
+        .WithInt64("copied", copied)
+        .WithInt64("skipped", skipped);
+}
+
+
 JsonValue handleUpdateContext(std::shared_ptr<StorageService> store)
 {
     string opt_context;
@@ -454,6 +671,327 @@ JsonValue handleUpdateContext(std::shared_ptr<StorageService> store)
     return JsonValue().WithString("context", opt_context).WithBool("result", true);
 }
 
+JsonValue handleBench(std::shared_ptr<StorageService> store)
+{
+    string opt_context;
+    string opt_key;
+    int opt_iterations = 100;
+    bool opt_skip_value = false;
+    int opt_version = 0;
+
+    po::options_description desc(opt_command + " options");
+    desc.add_options()
+        ("context", po::value<string>(&opt_context)->required(), "context name")
+        ("key", po::value<string>(&opt_key)->required(), "key name")
+        ("iterations", po::value<int>(&opt_iterations), "number of reads to time")
+        ("version", po::value<int>(&opt_version), "read only if this version")
+        ("skip-value", po::bool_switch(&opt_skip_value), "skip returning the value")
+    ;
+
+    po::positional_options_description pos;
+    pos.add("context", 1)
+        .add("key", 1);
+
+    po::variables_map vm;
+    po::command_line_parser parser = po::command_line_parser(opt_commandArgs)
+        .options(desc)
+        .positional(pos);
+    try {
+        po::store(parser.run(), vm);
+        po::notify(vm);
+    } catch (const std::exception &ex) {
+        cerr << "Exception parsing arguments: " << ex.what() << endl << endl;
+        outputHelp(opt_command + " [context] [key] [command options]", desc);
+
+        throw options_error(true);
+    }
+
+    if (opt_iterations < 1)
+        throw runtime_error("iterations must be positive");
+
+    string value;
+    time_t expiration = 0;
+    int version = 0;
+
+    // one untimed read to open the connection and size the value
+    version = store->readString(
+        opt_context.c_str(),
+        opt_key.c_str(),
+        opt_skip_value ? nullptr : &value,
+        &expiration,
+        opt_version
+    );
+    size_t valueSize = value.size();
+
+    // CPU time is for the whole process, so it includes the SDK's
+    // threads parsing the responses
+    clock_t cpuStart = clock();
+    auto wallStart = chrono::steady_clock::now();
+    for (int i = 0; i < opt_iterations; ++i) {
+        store->readString(
+            opt_context.c_str(),
+            opt_key.c_str(),
+            opt_skip_value ? nullptr : &value,
+            &expiration,
+            opt_version
+        );
+    }
+    auto wallTime = chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - wallStart);
+    double cpuTime = (clock() - cpuStart) * 1000000.0 / CLOCKS_PER_SEC;
+
+    return JsonValue()
+        .WithString("context", opt_context)
+        .WithString("key", opt_key)
+        .WithInteger("version", version)
+        .WithInt64("value_size", valueSize)
+        .WithInteger("iterations", opt_iterations)
+        .WithDouble("wall_us_per_read", static_cast<double>(wallTime.count()) / opt_iterations)
+        .WithDouble("cpu_us_per_read", cpuTime / opt_iterations)
+        .WithBool("result", version > 0);
+}
+
+struct ReplayStats {
+    unsigned long records = 0;
+    unsigned long errors = 0;
+    unsigned long mismatches = 0;
+    unsigned long long latency = 0;
+};
+
+TraceRecorder::Outcome replayRecord(
+    StorageService &store,
+    const TraceRecorder::Record &record,
+    const string &context,
+    const string &value,
+    unordered_map<string, int> &versions
+)
+{
+    const string key = str(format("%016x") % record.keyHash);
+    const string versionKey = context + '\0' + key;
+    const time_t expiration = record.expiration > 0 ? time(nullptr) + record.expiration : 0;
+    // the trace only has the caller's version, so conditional calls use
+    // whatever version this replay last saw for the key
+    const int version = record.version > 0 ? versions[versionKey] : 0;
+
+    switch (record.operation) {
+        case TraceRecorder::CREATE_STRING:
+            if (!store.createString(context.c_str(), key.c_str(), value.c_str(), expiration))
+                return TraceRecorder::CONFLICT;
+            versions[versionKey] = 1;
+            return TraceRecorder::SUCCESS;
+
+        case TraceRecorder::READ_STRING: {
+            string readValue;
+            int rv = store.readString(context.c_str(), key.c_str(), &readValue, nullptr, version);
+            if (rv > 0)
+                versions[versionKey] = rv;
+            return rv > 0 ? TraceRecorder::SUCCESS : TraceRecorder::NOT_FOUND;
+        }
+
+        case TraceRecorder::UPDATE_STRING: {
+            // traces written before the flag existed only have the size
+            const bool hasValue = !(record.flags & TraceRecorder::NO_VALUE) && record.valueSize > 0;
+            int rv = store.updateString(context.c_str(), key.c_str(), hasValue ? value.c_str() : nullptr, expiration, version);
+            if (rv > 0) {
+                versions[versionKey] = rv;
+                return TraceRecorder::SUCCESS;
+            }
+            return rv == 0 ? TraceRecorder::NOT_FOUND : TraceRecorder::CONFLICT;
+        }
+
+        case TraceRecorder::DELETE_STRING:
+            versions.erase(versionKey);
+            return store.deleteString(context.c_str(), key.c_str()) ? TraceRecorder::SUCCESS : TraceRecorder::NOT_FOUND;
+
+        case TraceRecorder::UPDATE_CONTEXT:
+            store.updateContext(context.c_str(), expiration);
+            return TraceRecorder::SUCCESS;
+
+        case TraceRecorder::DELETE_CONTEXT:
+            store.deleteContext(context.c_str());
+            return TraceRecorder::SUCCESS;
+
+        default:
+            throw runtime_error(str(format("unknown trace operation: %d") % static_cast<int>(record.operation)));
+    }
+}
+
+void replayTrace(
+    std::shared_ptr<StorageService> store,
+    const string &fileName,
+    const string &prefix,
+    double speed,
+    ReplayStats &stats,
+    mutex &statsMutex
+)
+{
+    ifstream in(fileName, ios::binary);
+    if (!in || !TraceRecorder::readHeader(in))
+        throw runtime_error("Unable to read trace file: " + fileName);
+
+    const size_t maxValueSize = store->getCapabilities().getStringSize();
+    unordered_map<string, int> versions;
+    ReplayStats local;
+
+    TraceRecorder::Record record;
+    uint64_t firstTimestamp = 0;
+    auto start = chrono::steady_clock::now();
+    while (TraceRecorder::readRecord(in, record)) {
+        if (local.records == 0)
+            firstTimestamp = record.timestamp;
+
+        if (speed > 0 && record.timestamp > firstTimestamp) {
+            this_thread::sleep_until(start + chrono::microseconds(
+                static_cast<long long>((record.timestamp - firstTimestamp) / speed)
+            ));
+        }
+
+        const string context = str(format("%s-%016x") % prefix % record.contextHash);
+        const string value(min(static_cast<size_t>(record.valueSize), maxValueSize), 'x');
+
+        TraceRecorder::Outcome outcome = TraceRecorder::FAILURE;
+        auto opStart = chrono::steady_clock::now();
+        try {
+            outcome = replayRecord(*store, record, context, value, versions);
+        } catch (const std::exception&) {
+            ++local.errors;
+        }
+        local.latency += chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - opStart).count();
+
+        ++local.records;
+        if (outcome != record.outcome)
+            ++local.mismatches;
+    }
+
+    lock_guard<mutex> lock(statsMutex);
+    stats.records += local.records;
+    stats.errors += local.errors;
+    stats.mismatches += local.mismatches;
+    stats.latency += local.latency;
+}
+
+JsonValue handleReplay(std::shared_ptr<StorageService> store)
+{
+    string opt_file;
+    string opt_prefix = "replay";
+    double opt_speed = 1.0;
+    int opt_multiply = 1;
+
+    po::options_description desc(opt_command + " options");
+    desc.add_options()
+        ("file", po::value<string>(&opt_file)->required(), "trace file recorded by the plugin")
+        ("speed", po::value<double>(&opt_speed), "replay rate relative to the recording; 0 for as fast as possible")
+        ("multiply", po::value<int>(&opt_multiply), "number of copies of the trace to replay at once")
+        ("prefix", po::value<string>(&opt_prefix), "prefix for the replayed context names")
+    ;
+
+    po::positional_options_description pos;
+    pos.add("file", 1);
+
+    po::variables_map vm;
+    po::command_line_parser parser = po::command_line_parser(opt_commandArgs)
+        .options(desc)
+        .positional(pos);
+    try {
+        po::store(parser.run(), vm);
+        po::notify(vm);
+    } catch (const std::exception &ex) {
+        cerr << "Exception parsing arguments: " << ex.what() << endl << endl;
+        outputHelp(opt_command + " [file] [command options]", desc);
+
+        throw options_error(true);
+    }
+
+    if (opt_speed < 0)
+        throw runtime_error("speed must not be negative");
+    if (opt_multiply < 1)
+        throw runtime_error("multiply must be positive");
+
+    // each copy gets its own contexts so the copies do not collide
+    ReplayStats stats;
+    mutex statsMutex;
+    vector<thread> copies;
+    vector<string> copyErrors;
+    auto wallStart = chrono::steady_clock::now();
+    for (int i = 0; i < opt_multiply; ++i) {
+        const string prefix = opt_multiply > 1 ? str(format("%s%d") % opt_prefix % i) : opt_prefix;
+        copies.push_back(thread([&, prefix]() {
+            try {
+                replayTrace(store, opt_file, prefix, opt_speed, stats, statsMutex);
+            } catch (const std::exception &ex) {
+                lock_guard<mutex> lock(statsMutex);
+                copyErrors.push_back(ex.what());
+            }
+        }));
+    }
+    for (auto &copy : copies) {
+        copy.join();
+    }
+    auto wallTime = chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - wallStart);
+
+    if (!copyErrors.empty())
+        throw runtime_error(copyErrors.front());
+
+    double wallSeconds = wallTime.count() / 1000000.0;
+    return JsonValue()
+        .WithString("file", opt_file)
+        .WithDouble("speed", opt_speed)
+        .WithInteger("multiply", opt_multiply)
+        .WithInt64("records", stats.records)
+        .WithInt64("errors", stats.errors)
+        .WithInt64("mismatches", stats.mismatches)
+        .WithDouble("wall_seconds", wallSeconds)
+        .WithDouble("ops_per_second", wallSeconds > 0 ? stats.records / wallSeconds : 0)
+        .WithDouble("avg_latency_us", stats.records > 0 ? static_cast<double>(stats.latency) / stats.records : 0)
+        .WithBool("result", stats.errors == 0);
+}
+
+Aws::Vector<JsonValue> capacityUsage(const CapacityProfiler &profiler)
+{
+    Aws::Vector<JsonValue> rv;
+
+    for (const auto &usage : profiler.getUsage()) {
+        rv.push_back(JsonValue()
+            .WithString("operation", usage.operation)
+            .WithString("context", usage.group)
+            .WithInt64("requests", usage.requests)
+            .WithDouble("read_units", usage.readUnits)
+            .WithDouble("write_units", usage.writeUnits)
+        );
+    }
+
+    return rv;
+}
+
+
+JsonValue executorStats(const BoundedExecutor &executor)
+{
+    const BoundedExecutor::Stats stats = executor.getStats();
+    const unsigned long queued = stats.submitted - stats.ranInline;
+
+    return JsonValue()
+        .WithInteger("threads", stats.threads)
+        .WithInt64("queue_size", stats.queueSize)
+        .WithInt64("queue_depth", stats.queueDepth)
+        .WithInt64("max_queue_depth", stats.maxQueueDepth)
+        .WithInt64("submitted", stats.submitted)
+        .WithInt64("completed", stats.completed)
+        .WithInt64("helped", stats.helped)
+        .WithInt64("inline", stats.ranInline)
+        .WithInt64("stolen", stats.stolen)
+        .WithInt64("blocked", stats.blocked)
+        .WithDouble("avg_queue_wait_us", queued > 0 ? static_cast<double>(stats.queueWait.count()) / queued : 0)
+        .WithInt64("max_queue_wait_us", stats.maxQueueWait.count())
+        .WithDouble("avg_run_time_us", stats.completed > 0 ? static_cast<double>(stats.runTime.count()) / stats.completed : 0);
+}
+
+
+JsonValue staleStats(const StaleItemCache &stale)
+{
+    return JsonValue()
+        .WithInt64("served", stale.getServed())
+        .WithInt64("bytes", stale.getBytes());
+}
+
 
 std::shared_ptr<StorageService> newStorageService(const string &configFileName, const string& pluginName = "DYNAMODB")
 {
@@ -535,6 +1073,8 @@ int main(int argc, char* argv[])
 
         if (opt_command == "readString" || opt_command == "readText") {
             rv = handleRead(store);
+        } else if (opt_command == "readMany") {
+            rv = handleReadMany(store);
         } else if (opt_command == "createString" || opt_command == "createText") {
             rv = handleCreate(store);
         } else if (opt_command == "deleteString" || opt_command == "deleteText") {
@@ -545,10 +1085,28 @@ int main(int argc, char* argv[])
             rv = handleUpdateContext(store);
         } else if (opt_command == "deleteContext") {
             rv = handleDeleteContext(store);
+        } else if (opt_command == "bench") {
+            rv = handleBench(store);
+        } else if (opt_command == "replay") {
+            rv = handleReplay(store);
+        } else if (opt_command == "migrate") {
+            rv = handleMigrate(store);
         } else {
             throw runtime_error("unknown command: " + opt_command);
         }
 
+        // only when the tool is linked against the same plugin it loaded
+        auto dynamodb = std::dynamic_pointer_cast<DynamoDBStorageService>(store);
+        if (dynamodb && dynamodb->getCapacityProfiler()) {
+            rv.WithArray("capacity", capacityUsage(*dynamodb->getCapacityProfiler()));
+        }
+        if (dynamodb) {
+            rv.WithObject("executor", executorStats(*dynamodb->getExecutor()));
+        }
+        if (dynamodb && dynamodb->getStaleItemCache()) {
+            rv.WithObject("stale", staleStats(*dynamodb->getStaleItemCache()));
+        }
+
         cout << rv.View().WriteReadable() << endl;
     } catch (const options_error &optsEx) {
         if (!optsEx.isHelpDisplayed()) {
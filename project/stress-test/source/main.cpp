@@ -0,0 +1,365 @@
+/* Copyright (c) 2018 University of Illinois Board of Trustees
+ * All rights reserved.
+ *
+ * Developed by:       Technology Services
+ *                     University of Illinois at Urbana-Champaign
+ *                     https://techservices.illinois.edu/
+ *
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal with the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimers.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimers in the
+ *   documentation and/or other materials provided with the distribution.
+ * - Neither the names of Technology Services, University of Illinois at
+ *   Urbana-Champaign, nor the names of its contributors may be used to
+ *   endorse or promote products derived from this Software without
+ *   specific prior written permission.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS WITH THE SOFTWARE.
+ */
+
+#include <atomic>
+#include <aws/core/Aws.h>
+#include <aws/core/utils/json/JsonSerializer.h>
+#include <boost/algorithm/string.hpp>
+#include <boost/format.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/program_options.hpp>
+#include <chrono>
+#include <ctime>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <xmltooling/XMLToolingConfig.h>
+#include <xmltooling/util/ParserPool.h>
+#include <xmltooling/util/StorageService.h>
+#include <xmltooling/util/XMLHelper.h>
+
+using namespace Aws::Utils::Json;
+using namespace xmltooling;
+using namespace boost;
+using namespace std;
+
+namespace po = boost::program_options;
+
+// Every run uses its own contexts so that runs cannot see each other's
+// items, even against a shared table.
+static const string RUN_ID = lexical_cast<string>(time(nullptr));
+static const time_t EXPIRATION = time(nullptr) + 3600;
+
+
+class ScopedXMLToolingConfig {
+public:
+    ScopedXMLToolingConfig(const char* loggingLevel, const string& libraryFileName) {
+        XMLToolingConfig &c = XMLToolingConfig::getConfig();
+
+        c.log_config(loggingLevel);
+        c.init();
+        c.load_library(libraryFileName.c_str());
+    }
+
+    ~ScopedXMLToolingConfig() {
+        XMLToolingConfig::getConfig().term();
+    }
+};
+
+
+struct StepResult {
+    unsigned long operations = 0;
+    unsigned long conflicts = 0;
+    unsigned long errors = 0;
+    vector<string> failures;
+};
+
+
+std::shared_ptr<StorageService> newStorageService(const string &configFileName, const string& pluginName)
+{
+    ifstream configFile(configFileName);
+    if (!configFile)
+        throw runtime_error("Unable to open config file: " + configFileName);
+
+    xercesc::DOMDocument* doc = XMLToolingConfig::getConfig().getParser().parse(configFile);
+    XercesJanitor<xercesc::DOMDocument> docjanitor(doc);
+
+    return std::shared_ptr<StorageService>(XMLToolingConfig::getConfig().StorageServiceManager.newPlugin(pluginName, doc->getDocumentElement(), true));
+}
+
+
+// Runs fn on each of threads threads until the deadline, adding up what
+// they report.
+StepResult runThreads(int threads, chrono::seconds duration, const std::function<void (int, const chrono::steady_clock::time_point&, StepResult&)> &fn)
+{
+    StepResult total;
+    mutex totalMutex;
+
+    auto deadline = chrono::steady_clock::now() + duration;
+    vector<thread> workers;
+    for (int i = 0; i < threads; ++i) {
+        workers.push_back(thread([&, i]() {
+            StepResult result;
+            try {
+                fn(i, deadline, result);
+            } catch (const std::exception &ex) {
+                ++result.errors;
+                result.failures.push_back(ex.what());
+            }
+
+            lock_guard<mutex> lock(totalMutex);
+            total.operations += result.operations;
+            total.conflicts += result.conflicts;
+            total.errors += result.errors;
+            total.failures.insert(total.failures.end(), result.failures.begin(), result.failures.end());
+        }));
+    }
+    for (auto &worker : workers) {
+        worker.join();
+    }
+
+    return total;
+}
+
+
+// All threads increment one counter with versioned updates. Every
+// successful update must be reflected in the final value and version,
+// and the versions each thread sees must only go up.
+StepResult stressCounter(StorageService &store, int threads, chrono::seconds duration)
+{
+    const string context = "stress-counter-" + RUN_ID + "-" + lexical_cast<string>(threads);
+    const char* key = "counter";
+
+    if (!store.createString(context.c_str(), key, "0", EXPIRATION))
+        throw runtime_error("unable to create the counter in " + context);
+
+    StepResult result = runThreads(threads, duration, [&](int, const chrono::steady_clock::time_point &deadline, StepResult &result) {
+        int lastVersion = 0;
+        while (chrono::steady_clock::now() < deadline) {
+            string value;
+            int version = store.readString(context.c_str(), key, &value);
+            if (version < lastVersion) {
+                result.failures.push_back(str(format("version went backwards from %d to %d") % lastVersion % version));
+            }
+            lastVersion = version;
+
+            const string next = lexical_cast<string>(lexical_cast<long>(value) + 1);
+            int updated = store.updateString(context.c_str(), key, next.c_str(), 0, version);
+            if (updated > 0) {
+                if (updated != version + 1) {
+                    result.failures.push_back(str(format("update of version %d returned %d") % version % updated));
+                }
+                lastVersion = updated;
+                ++result.operations;
+            } else if (updated < 0) {
+                ++result.conflicts;
+            } else {
+                result.failures.push_back("counter disappeared");
+                return;
+            }
+        }
+    });
+
+    string value;
+    int version = store.readString(context.c_str(), key, &value);
+    if (lexical_cast<unsigned long>(value) != result.operations) {
+        result.failures.push_back(str(format("lost updates: counter is %s after %lu updates") % value % result.operations));
+    }
+    if (version != static_cast<int>(result.operations) + 1) {
+        result.failures.push_back(str(format("counter version is %d after %lu updates") % version % result.operations));
+    }
+
+    store.deleteContext(context.c_str());
+    return result;
+}
+
+
+// Each thread works on its own keys, so this measures how throughput
+// scales when nothing is contended.
+StepResult stressIndependent(StorageService &store, int threads, chrono::seconds duration)
+{
+    const string context = "stress-independent-" + RUN_ID + "-" + lexical_cast<string>(threads);
+
+    StepResult result = runThreads(threads, duration, [&](int thread, const chrono::steady_clock::time_point &deadline, StepResult &result) {
+        for (unsigned long i = 0; chrono::steady_clock::now() < deadline; ++i) {
+            const string key = str(format("t%d-%lu") % thread % i);
+
+            if (!store.createString(context.c_str(), key.c_str(), "stress value", EXPIRATION)) {
+                result.failures.push_back("create failed for new key " + key);
+                continue;
+            }
+
+            string value;
+            if (store.readString(context.c_str(), key.c_str(), &value) != 1 || value != "stress value") {
+                result.failures.push_back("read did not return the created value for " + key);
+            }
+            if (store.updateString(context.c_str(), key.c_str(), "updated value", 0, 1) != 2) {
+                result.failures.push_back("update of version 1 failed for " + key);
+            }
+            if (!store.deleteString(context.c_str(), key.c_str())) {
+                result.failures.push_back("delete failed for " + key);
+            }
+
+            result.operations += 4;
+        }
+    });
+
+    return result;
+}
+
+
+// Threads update the expiration of a few shared contexts at once, which
+// all go through the plugin's record of recent context updates.
+StepResult stressUpdateContext(StorageService &store, int threads, chrono::seconds duration)
+{
+    const int contexts = 4;
+    vector<string> names;
+    for (int i = 0; i < contexts; ++i) {
+        names.push_back(str(format("stress-context-%s-%d-%d") % RUN_ID % threads % i));
+        store.createString(names.back().c_str(), "key", "stress value", EXPIRATION);
+    }
+
+    StepResult result = runThreads(threads, duration, [&](int thread, const chrono::steady_clock::time_point &deadline, StepResult &result) {
+        for (unsigned long i = 0; chrono::steady_clock::now() < deadline; ++i) {
+            const string &context = names[(thread + i) % contexts];
+            store.updateContext(context.c_str(), EXPIRATION + static_cast<time_t>((i % 2) * 3600));
+            ++result.operations;
+        }
+    });
+
+    for (const auto &context : names) {
+        time_t expiration = 0;
+        if (store.readString(context.c_str(), "key", nullptr, &expiration) != 1) {
+            result.failures.push_back("context key lost by updateContext in " + context);
+        } else if (expiration != EXPIRATION && expiration != EXPIRATION + 3600) {
+            result.failures.push_back("context key has an unexpected expiration in " + context);
+        }
+        store.deleteContext(context.c_str());
+    }
+
+    return result;
+}
+
+
+int main(int argc, char* argv[])
+{
+    string opt_library;
+    string opt_plugin;
+    string opt_config;
+    string opt_threads;
+    int opt_duration = 5;
+    bool opt_debug = false;
+
+    po::options_description desc("Options");
+    desc.add_options()
+        ("help,h", "show this help message")
+        ("debug,d", po::bool_switch(&opt_debug), "turn on debug logging")
+        ("library,l", po::value<string>(&opt_library)->default_value(DYNAMODB_LIB_NAME), "choose the name of the storage library to load")
+        ("plugin,p", po::value<string>(&opt_plugin)->default_value("UIUC-DynamoDB"), "name the plugin registers with XMLTooling")
+        ("config,c", po::value<string>(&opt_config)->required(), "filename to load for the storage service configuration")
+        ("threads,t", po::value<string>(&opt_threads)->default_value("1,2,4,8,16,32,64"), "comma separated thread counts to run")
+        ("duration", po::value<int>(&opt_duration), "seconds to run each workload at each thread count")
+    ;
+
+    vector<int> threadCounts;
+    try {
+        po::variables_map vm;
+        po::store(po::parse_command_line(argc, argv, desc), vm);
+
+        if (vm.count("help")) {
+            cerr << "Usage: " << argv[0] << " [options]" << endl << desc << endl;
+            return 1;
+        }
+        po::notify(vm);
+
+        vector<string> counts;
+        split(counts, opt_threads, is_any_of(","));
+        for (const auto &count : counts) {
+            threadCounts.push_back(lexical_cast<int>(trim_copy(count)));
+            if (threadCounts.back() < 1)
+                throw runtime_error("thread counts must be positive");
+        }
+        if (opt_duration < 1)
+            throw runtime_error("duration must be positive");
+    } catch (const std::exception &ex) {
+        cerr << "Exception parsing arguments: " << ex.what() << endl << endl;
+        cerr << "Usage: " << argv[0] << " [options]" << endl << desc << endl;
+        return 1;
+    }
+
+    Aws::SDKOptions options;
+    Aws::InitAPI(options);
+
+    bool passed = true;
+    {
+        ScopedXMLToolingConfig scopedConfig(opt_debug ? "DEBUG" : "WARN", opt_library);
+
+        try {
+            std::shared_ptr<StorageService> store = newStorageService(opt_config, opt_plugin);
+
+            const vector<pair<string, std::function<StepResult (StorageService&, int, chrono::seconds)>>> workloads = {
+                { "counter", stressCounter },
+                { "independent", stressIndependent },
+                { "updateContext", stressUpdateContext },
+            };
+
+            Aws::Vector<JsonValue> steps;
+            for (const auto &workload : workloads) {
+                double baseline = 0;
+                for (int threads : threadCounts) {
+                    StepResult result = workload.second(*store, threads, chrono::seconds(opt_duration));
+                    double throughput = static_cast<double>(result.operations) / opt_duration;
+                    if (baseline == 0) {
+                        baseline = throughput / threads;
+                    }
+
+                    Aws::Vector<JsonValue> failures;
+                    for (const auto &failure : result.failures) {
+                        failures.push_back(JsonValue().AsString(failure));
+                    }
+                    passed = passed && result.failures.empty() && result.errors == 0;
+
+                    steps.push_back(JsonValue()
+                        .WithString("workload", workload.first)
+                        .WithInteger("threads", threads)
+                        .WithInt64("operations", result.operations)
+                        .WithInt64("conflicts", result.conflicts)
+                        .WithInt64("errors", result.errors)
+                        .WithDouble("ops_per_second", throughput)
+                        // throughput relative to perfect scaling of the
+                        // first thread count
+                        .WithDouble("scaling", baseline > 0 ? throughput / (baseline * threads) : 0)
+                        .WithArray("failures", failures)
+                    );
+
+                    cerr << workload.first << " threads=" << threads << " ops/s=" << throughput << endl;
+                }
+            }
+
+            cout << JsonValue().WithArray("steps", steps).WithBool("result", passed).View().WriteReadable() << endl;
+        } catch (const std::exception &ex) {
+            cerr << "Exception: " << ex.what() << endl;
+            passed = false;
+        }
+    }
+
+    Aws::ShutdownAPI(options);
+    return passed ? 0 : 1;
+}
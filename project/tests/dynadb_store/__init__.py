@@ -46,6 +46,7 @@ class ToolTestCase(TestCase):
     TOOL_TABLE = os.environ.get('UIUC_SHIBPLUGINS_STORE_TABLE', None)
     TOOL_REGION = os.environ.get('UIUC_SHIBPLUGINS_STORE_REGION', os.environ.get('AWS_DEFAULT_REGION', None))
     TOOL_LIB = os.environ.get('UIUC_SHIBPLUGINS_STORE_LIB', None)
+    TOOL_PLUGIN = None
 
     def setUp(self):
         self.dyndb_clnt = boto3.client('dynamodb')
@@ -66,7 +67,7 @@ class ToolTestCase(TestCase):
             suffix='.xml',
             delete=False
         )
-        self.tool_cfg.write(f"<Storage tableName='{self.TOOL_TABLE}' region='{self.TOOL_REGION}'/>\n")
+        self.tool_cfg.write(self.tool_config() + "\n")
         self.tool_cfg.flush()
 
         b_items = list(getattr(self, 'SETUP_BATCH_WRITES', []))
@@ -82,6 +83,10 @@ class ToolTestCase(TestCase):
                 time.sleep(1)
 
 
+    def tool_config(self):
+        return f"<Storage tableName='{self.TOOL_TABLE}' region='{self.TOOL_REGION}'/>"
+
+
     def tearDown(self):
         b_items = list(getattr(self, 'TEARDOWN_BATCH_WRITES', []))
         r_items = []
@@ -99,11 +104,16 @@ class ToolTestCase(TestCase):
         self.dyndb_clnt = None
 
 
+    def tool_env(self):
+        return None
+
+
     def tool(self, command, *args, **kwargs):
         tool_cmd = [
             self.TOOL_BIN,
             '-l', self.TOOL_LIB,
             '-c', self.tool_cfg.name,
+            *(['-p', self.TOOL_PLUGIN] if self.TOOL_PLUGIN else []),
             command,
             *[str(i) for i in args],
         ]
@@ -116,6 +126,7 @@ class ToolTestCase(TestCase):
             stderr=subprocess.PIPE,
             encoding='utf-8',
             timeout=10,
+            env=self.tool_env(),
         )
 
         if result.returncode == 0:
@@ -0,0 +1,157 @@
+# Copyright (c) 2018 University of Illinois Board of Trustees
+# All rights reserved.
+#
+# Developed by:       Technology Services
+#                     University of Illinois at Urbana-Champaign
+#                     https://techservices.illinois.edu/
+#
+#
+# Permission is hereby granted, free of charge, to any person obtaining
+# a copy of this software and associated documentation files (the
+# "Software"), to deal with the Software without restriction, including
+# without limitation the rights to use, copy, modify, merge, publish,
+# distribute, sublicense, and/or sell copies of the Software, and to
+# permit persons to whom the Software is furnished to do so, subject to
+# the following conditions:
+#
+# - Redistributions of source code must retain the above copyright
+#   notice, this list of conditions and the following disclaimers.
+# - Redistributions in binary form must reproduce the above copyright
+#   notice, this list of conditions and the following disclaimers in the
+#   documentation and/or other materials provided with the distribution.
+# - Neither the names of Technology Services, University of Illinois at
+#   Urbana-Champaign, nor the names of its contributors may be used to
+#   endorse or promote products derived from this Software without
+#   specific prior written permission.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+# EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+# MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+# IN NO EVENT SHALL THE CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+# ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+# CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+# WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS WITH THE SOFTWARE.
+from datetime import datetime, timezone, timedelta
+
+from . import ToolTestCase
+
+class AsyncTestCase(ToolTestCase):
+    SETUP_BATCH_WRITES = [
+        {'PutRequest': {'Item': {
+            'Context': {'S': 'asyncContext'},
+            'Key': {'S': 'testKey'},
+            'Expires': {'N': '2147483647'},
+            'Value': {'S': 'this is a test string'},
+            'Version': {'N': '1'},
+        }}},
+    ]
+    TEARDOWN_BATCH_WRITES = [
+        {'DeleteRequest': {'Key': {
+            'Context': {'S': 'asyncContext'},
+            'Key': {'S': 'testKey'},
+        }}},
+        {'DeleteRequest': {'Key': {
+            'Context': {'S': 'asyncContext'},
+            'Key': {'S': 'newKey'},
+        }}},
+    ]
+
+
+    def get_item(self, key):
+        result = self.dyndb_clnt.get_item(
+            TableName=self.TOOL_TABLE,
+            Key={'Context': {'S': 'asyncContext'}, 'Key': {'S': key}},
+            ConsistentRead=True
+        )
+        return result.get('Item', {})
+
+
+    def test_createString(self):
+        expires = int((datetime.now(timezone.utc) + timedelta(days=365)).timestamp())
+
+        result = self.tool(
+            'createString',
+            'asyncContext',
+            'newKey',
+            'this is a new value',
+            expires,
+            '--async'
+        )
+        self.assertTrue(result['result'])
+
+        self.assertEqual(self.get_item('newKey'), {
+            'Context': {'S': 'asyncContext'},
+            'Key': {'S': 'newKey'},
+            'Expires': {'N': str(expires)},
+            'Value': {'S': 'this is a new value'},
+            'Version': {'N': '1'},
+        })
+
+    def test_readString(self):
+        result = self.tool(
+            'readString',
+            'asyncContext',
+            'testKey',
+            '--async'
+        )
+
+        self.assertTrue(result['result'])
+        self.assertEqual(result['version'], 1)
+        self.assertEqual(result['value'], 'this is a test string')
+        self.assertEqual(result['expiration'], 2147483647)
+
+    def test_readStringMissing(self):
+        result = self.tool(
+            'readString',
+            'asyncContext',
+            'missingKey',
+            '--async'
+        )
+
+        self.assertFalse(result['result'])
+
+    def test_updateString(self):
+        result = self.tool(
+            'updateString',
+            'asyncContext',
+            'testKey',
+            'this is an updated value',
+            '--async'
+        )
+
+        self.assertTrue(result['result'])
+        self.assertEqual(result['version'], 2)
+        self.assertEqual(self.get_item('testKey')['Value'], {'S': 'this is an updated value'})
+
+    def test_updateStringExpiration(self):
+        # no value, so only the expiration changes
+        expires = int((datetime.now(timezone.utc) + timedelta(days=365)).timestamp())
+
+        result = self.tool(
+            'updateString',
+            'asyncContext',
+            'testKey',
+            '--async',
+            expiration=expires
+        )
+
+        self.assertTrue(result['result'])
+        self.assertEqual(result['version'], 2)
+        self.assertEqual(self.get_item('testKey'), {
+            'Context': {'S': 'asyncContext'},
+            'Key': {'S': 'testKey'},
+            'Expires': {'N': str(expires)},
+            'Value': {'S': 'this is a test string'},
+            'Version': {'N': '2'},
+        })
+
+    def test_deleteString(self):
+        result = self.tool(
+            'deleteString',
+            'asyncContext',
+            'testKey',
+            '--async'
+        )
+
+        self.assertTrue(result['result'])
+        self.assertEqual(self.get_item('testKey'), {})
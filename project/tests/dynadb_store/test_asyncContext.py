@@ -0,0 +1,103 @@
+# Copyright (c) 2018 University of Illinois Board of Trustees
+# All rights reserved.
+#
+# Developed by:       Technology Services
+#                     University of Illinois at Urbana-Champaign
+#                     https://techservices.illinois.edu/
+#
+#
+# Permission is hereby granted, free of charge, to any person obtaining
+# a copy of this software and associated documentation files (the
+# "Software"), to deal with the Software without restriction, including
+# without limitation the rights to use, copy, modify, merge, publish,
+# distribute, sublicense, and/or sell copies of the Software, and to
+# permit persons to whom the Software is furnished to do so, subject to
+# the following conditions:
+#
+# - Redistributions of source code must retain the above copyright
+#   notice, this list of conditions and the following disclaimers.
+# - Redistributions in binary form must reproduce the above copyright
+#   notice, this list of conditions and the following disclaimers in the
+#   documentation and/or other materials provided with the distribution.
+# - Neither the names of Technology Services, University of Illinois at
+#   Urbana-Champaign, nor the names of its contributors may be used to
+#   endorse or promote products derived from this Software without
+#   specific prior written permission.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+# EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+# MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+# IN NO EVENT SHALL THE CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+# ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+# CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+# WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS WITH THE SOFTWARE.
+from datetime import datetime, timezone, timedelta
+
+from . import ToolTestCase
+
+class AsyncContextTestCase(ToolTestCase):
+    SETUP_BATCH_WRITES = [
+        {'PutRequest': {'Item': {
+            'Context': {'S': 'testContext'},
+            'Key': {'S': 'testKey1'},
+            'Expires': {'N': '2147483647'},
+            'Value': {'S': 'this is a test string'},
+            'Version': {'N': '1'},
+        }}},
+        {'PutRequest': {'Item': {
+            'Context': {'S': 'testContext'},
+            'Key': {'S': 'testKey2'},
+            'Expires': {'N': '2147483647'},
+            'Value': {'S': 'this is a test string'},
+            'Version': {'N': '1'},
+        }}},
+    ]
+    TEARDOWN_BATCH_WRITES = [
+        {'DeleteRequest': {'Key': {
+            'Context': {'S': 'testContext'},
+            'Key': {'S': 'testKey1'},
+        }}},
+        {'DeleteRequest': {'Key': {
+            'Context': {'S': 'testContext'},
+            'Key': {'S': 'testKey2'},
+        }}},
+    ]
+
+    def tool_config(self):
+        return f"<Storage tableName='{self.TOOL_TABLE}' region='{self.TOOL_REGION}' asyncContextUpdates='true'/>"
+
+    def test_updateContext(self):
+        # the queue is flushed when the tool exits
+        expires = int((datetime.now(timezone.utc) + timedelta(days=365)).timestamp())
+
+        result = self.tool(
+            'updateContext',
+            'testContext',
+            expires
+        )
+
+        self.assertTrue(result['result'])
+
+        for k in ('testKey1', 'testKey2'):
+            result = self.dyndb_clnt.get_item(
+                TableName=self.TOOL_TABLE,
+                Key={'Context': {'S': 'testContext'}, 'Key': {'S': k}},
+                ConsistentRead=True
+            )
+            self.assertEqual(result['Item']['Expires'], {'N': str(expires)})
+
+    def test_deleteContext(self):
+        result = self.tool(
+            'deleteContext',
+            'testContext'
+        )
+
+        self.assertTrue(result['result'])
+
+        for k in ('testKey1', 'testKey2'):
+            result = self.dyndb_clnt.get_item(
+                TableName=self.TOOL_TABLE,
+                Key={'Context': {'S': 'testContext'}, 'Key': {'S': k}},
+                ConsistentRead=True
+            )
+            self.assertEqual(result.get('Item', {}), {})
@@ -0,0 +1,116 @@
+# Copyright (c) 2018 University of Illinois Board of Trustees
+# All rights reserved.
+#
+# Developed by:       Technology Services
+#                     University of Illinois at Urbana-Champaign
+#                     https://techservices.illinois.edu/
+#
+#
+# Permission is hereby granted, free of charge, to any person obtaining
+# a copy of this software and associated documentation files (the
+# "Software"), to deal with the Software without restriction, including
+# without limitation the rights to use, copy, modify, merge, publish,
+# distribute, sublicense, and/or sell copies of the Software, and to
+# permit persons to whom the Software is furnished to do so, subject to
+# the following conditions:
+#
+# - Redistributions of source code must retain the above copyright
+#   notice, this list of conditions and the following disclaimers.
+# - Redistributions in binary form must reproduce the above copyright
+#   notice, this list of conditions and the following disclaimers in the
+#   documentation and/or other materials provided with the distribution.
+# - Neither the names of Technology Services, University of Illinois at
+#   Urbana-Champaign, nor the names of its contributors may be used to
+#   endorse or promote products derived from this Software without
+#   specific prior written permission.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+# EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+# MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+# IN NO EVENT SHALL THE CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+# ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+# CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+# WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS WITH THE SOFTWARE.
+from datetime import datetime, timezone, timedelta
+
+from . import ToolTestCase
+
+# The context and key keep the table's key schema names; the rest are
+# renamed, which is enough to tell the names are used everywhere.
+CUSTOM_NAMES = 'Context,Key,Val,Exp,Ver,Chk'
+
+class AttributeNamesTestCase(ToolTestCase):
+    SETUP_BATCH_WRITES = [
+        {'PutRequest': {'Item': {
+            'Context': {'S': 'namesContext'},
+            'Key': {'S': 'testKey'},
+            'Exp': {'N': '2147483647'},
+            'Val': {'S': 'this is a test string'},
+            'Ver': {'N': '1'},
+        }}},
+    ]
+    TEARDOWN_BATCH_WRITES = [
+        {'DeleteRequest': {'Key': {
+            'Context': {'S': 'namesContext'},
+            'Key': {'S': k},
+        }}}
+        for k in ('testKey', 'newKey')
+    ]
+
+    def tool_config(self):
+        return f"<Storage tableName='{self.TOOL_TABLE}' region='{self.TOOL_REGION}' attributeNames='{CUSTOM_NAMES}'/>"
+
+    def get_item(self, key):
+        return self.dyndb_clnt.get_item(
+            TableName=self.TOOL_TABLE,
+            Key={'Context': {'S': 'namesContext'}, 'Key': {'S': key}},
+            ConsistentRead=True
+        ).get('Item', {})
+
+    def test_readString(self):
+        result = self.tool(
+            'readString',
+            'namesContext',
+            'testKey'
+        )
+
+        self.assertTrue(result['result'])
+        self.assertEqual(result['value'], 'this is a test string')
+        self.assertEqual(result['version'], 1)
+        self.assertEqual(result['expiration'], 2147483647)
+
+    def test_createString(self):
+        expires = int((datetime.now(timezone.utc) + timedelta(hours=1)).timestamp())
+        result = self.tool(
+            'createString',
+            'namesContext',
+            'newKey',
+            'this is a new string',
+            expires
+        )
+
+        self.assertTrue(result['result'])
+
+        item = self.get_item('newKey')
+        self.assertEqual(item['Val']['S'], 'this is a new string')
+        self.assertEqual(item['Exp']['N'], str(expires))
+        self.assertEqual(item['Ver']['N'], '1')
+        self.assertNotIn('Value', item)
+        self.assertNotIn('Expires', item)
+        self.assertNotIn('Version', item)
+
+    def test_updateString(self):
+        result = self.tool(
+            'updateString',
+            'namesContext',
+            'testKey',
+            'this is an updated string'
+        )
+
+        self.assertTrue(result['result'])
+        self.assertEqual(result['version'], 2)
+
+        item = self.get_item('testKey')
+        self.assertEqual(item['Val']['S'], 'this is an updated string')
+        self.assertEqual(item['Ver']['N'], '2')
+        self.assertNotIn('Value', item)
@@ -0,0 +1,92 @@
+# Copyright (c) 2018 University of Illinois Board of Trustees
+# All rights reserved.
+#
+# Developed by:       Technology Services
+#                     University of Illinois at Urbana-Champaign
+#                     https://techservices.illinois.edu/
+#
+#
+# Permission is hereby granted, free of charge, to any person obtaining
+# a copy of this software and associated documentation files (the
+# "Software"), to deal with the Software without restriction, including
+# without limitation the rights to use, copy, modify, merge, publish,
+# distribute, sublicense, and/or sell copies of the Software, and to
+# permit persons to whom the Software is furnished to do so, subject to
+# the following conditions:
+#
+# - Redistributions of source code must retain the above copyright
+#   notice, this list of conditions and the following disclaimers.
+# - Redistributions in binary form must reproduce the above copyright
+#   notice, this list of conditions and the following disclaimers in the
+#   documentation and/or other materials provided with the distribution.
+# - Neither the names of Technology Services, University of Illinois at
+#   Urbana-Champaign, nor the names of its contributors may be used to
+#   endorse or promote products derived from this Software without
+#   specific prior written permission.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+# EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+# MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+# IN NO EVENT SHALL THE CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+# ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+# CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+# WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS WITH THE SOFTWARE.
+import socket
+
+from . import ToolTestCase
+
+class BreakerTestCase(ToolTestCase):
+    SETUP_BATCH_WRITES = [
+        {'PutRequest': {'Item': {
+            'Context': {'S': 'testContext'},
+            'Key': {'S': 'testKey'},
+            'Expires': {'N': '2147483647'},
+            'Value': {'S': 'this is a test string'},
+            'Version': {'N': '1'},
+        }}},
+    ]
+    TEARDOWN_BATCH_WRITES = [
+        {'DeleteRequest': {'Key': {
+            'Context': {'S': 'testContext'},
+            'Key': {'S': 'testKey'},
+        }}},
+    ]
+
+    def setUp(self):
+        # The primary endpoint accepts connections but never answers, so
+        # each request to it waits out the whole requestTimeoutMS.
+        self.stalled = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+        self.stalled.bind(('127.0.0.1', 0))
+        self.stalled.listen(16)
+
+        super().setUp()
+
+    def tearDown(self):
+        super().tearDown()
+
+        self.stalled.close()
+
+    def tool_config(self):
+        port = self.stalled.getsockname()[1]
+        return (
+            f"<Storage tableName='{self.TOOL_TABLE}' maxRetries='0' requestTimeoutMS='2000'"
+            f" breakerFailures='1' breakerOpenMS='60000'>"
+            f"<Endpoint endpoint='http://127.0.0.1:{port}' region='{self.TOOL_REGION}' primary='true'/>"
+            f"<Endpoint region='{self.TOOL_REGION}'/>"
+            f"</Storage>"
+        )
+
+    def test_failFast(self):
+        # The untimed first read opens the circuit. Without the breaker
+        # the endpoint is only skipped after 3 failures, so two of the
+        # timed reads would also wait 2 seconds on it.
+        result = self.tool(
+            'bench',
+            'testContext',
+            'testKey',
+            iterations=10
+        )
+
+        self.assertTrue(result['result'])
+        self.assertEqual(result['version'], 1)
+        self.assertLess(result['wall_us_per_read'], 200000)
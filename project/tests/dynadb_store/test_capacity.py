@@ -0,0 +1,76 @@
+# Copyright (c) 2018 University of Illinois Board of Trustees
+# All rights reserved.
+#
+# Developed by:       Technology Services
+#                     University of Illinois at Urbana-Champaign
+#                     https://techservices.illinois.edu/
+#
+#
+# Permission is hereby granted, free of charge, to any person obtaining
+# a copy of this software and associated documentation files (the
+# "Software"), to deal with the Software without restriction, including
+# without limitation the rights to use, copy, modify, merge, publish,
+# distribute, sublicense, and/or sell copies of the Software, and to
+# permit persons to whom the Software is furnished to do so, subject to
+# the following conditions:
+#
+# - Redistributions of source code must retain the above copyright
+#   notice, this list of conditions and the following disclaimers.
+# - Redistributions in binary form must reproduce the above copyright
+#   notice, this list of conditions and the following disclaimers in the
+#   documentation and/or other materials provided with the distribution.
+# - Neither the names of Technology Services, University of Illinois at
+#   Urbana-Champaign, nor the names of its contributors may be used to
+#   endorse or promote products derived from this Software without
+#   specific prior written permission.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+# EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+# MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+# IN NO EVENT SHALL THE CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+# ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+# CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+# WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS WITH THE SOFTWARE.
+from . import ToolTestCase
+
+class CapacityProfileTestCase(ToolTestCase):
+    SESSION_CONTEXT = '_0123456789abcdef0123456789abcdef'
+
+    SETUP_BATCH_WRITES = [
+        {'PutRequest': {'Item': {
+            'Context': {'S': SESSION_CONTEXT},
+            'Key': {'S': 'testKey'},
+            'Expires': {'N': '2147483647'},
+            'Value': {'S': 'this is a test string'},
+            'Version': {'N': '1'},
+        }}},
+    ]
+    TEARDOWN_BATCH_WRITES = [
+        {'DeleteRequest': {'Key': {
+            'Context': {'S': SESSION_CONTEXT},
+            'Key': {'S': 'testKey'},
+        }}},
+    ]
+
+    def tool_config(self):
+        return f"<Storage tableName='{self.TOOL_TABLE}' region='{self.TOOL_REGION}' capacityProfile='true'/>"
+
+    def test_readString(self):
+        result = self.tool(
+            'readString',
+            self.SESSION_CONTEXT,
+            'testKey'
+        )
+
+        self.assertTrue(result['result'])
+
+        capacity = result.get('capacity')
+        if capacity is None:
+            self.skipTest('store-tool is not linked against the loaded plugin')
+
+        self.assertEqual(len(capacity), 1)
+        self.assertEqual(capacity[0]['operation'], 'GetItem')
+        self.assertEqual(capacity[0]['context'], '_*')
+        self.assertEqual(capacity[0]['requests'], 1)
+        self.assertGreater(capacity[0]['read_units'], 0)
+        self.assertEqual(capacity[0]['write_units'], 0)
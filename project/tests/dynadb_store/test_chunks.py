@@ -0,0 +1,143 @@
+# Copyright (c) 2018 University of Illinois Board of Trustees
+# All rights reserved.
+#
+# Developed by:       Technology Services
+#                     University of Illinois at Urbana-Champaign
+#                     https://techservices.illinois.edu/
+#
+#
+# Permission is hereby granted, free of charge, to any person obtaining
+# a copy of this software and associated documentation files (the
+# "Software"), to deal with the Software without restriction, including
+# without limitation the rights to use, copy, modify, merge, publish,
+# distribute, sublicense, and/or sell copies of the Software, and to
+# permit persons to whom the Software is furnished to do so, subject to
+# the following conditions:
+#
+# - Redistributions of source code must retain the above copyright
+#   notice, this list of conditions and the following disclaimers.
+# - Redistributions in binary form must reproduce the above copyright
+#   notice, this list of conditions and the following disclaimers in the
+#   documentation and/or other materials provided with the distribution.
+# - Neither the names of Technology Services, University of Illinois at
+#   Urbana-Champaign, nor the names of its contributors may be used to
+#   endorse or promote products derived from this Software without
+#   specific prior written permission.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+# EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+# MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+# IN NO EVENT SHALL THE CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+# ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+# CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+# WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS WITH THE SOFTWARE.
+from datetime import datetime, timezone, timedelta
+
+from . import ToolTestCase
+
+CHUNK_SEPARATOR = '\x1f'
+
+def chunked_item(key, parts, version=1, missing=()):
+    items = [{'PutRequest': {'Item': {
+        'Context': {'S': 'chunkContext'},
+        'Key': {'S': key},
+        'Expires': {'N': '2147483647'},
+        'Value': {'S': parts[0]},
+        'Version': {'N': str(version)},
+        'Chunks': {'N': str(len(parts))},
+    }}}]
+    for i, part in enumerate(parts[1:], 1):
+        if i in missing:
+            continue
+        items.append({'PutRequest': {'Item': {
+            'Context': {'S': 'chunkContext'},
+            'Key': {'S': f'{key}{CHUNK_SEPARATOR}{i}'},
+            'Expires': {'N': '2147483647'},
+            'Value': {'S': part},
+            'Version': {'N': str(version)},
+        }}})
+    return items
+
+def chunked_keys(key, count):
+    return [
+        {'DeleteRequest': {'Key': {
+            'Context': {'S': 'chunkContext'},
+            'Key': {'S': k},
+        }}}
+        for k in [key] + [f'{key}{CHUNK_SEPARATOR}{i}' for i in range(1, count)]
+    ]
+
+
+class ChunksTestCase(ToolTestCase):
+    SETUP_BATCH_WRITES = [
+        *chunked_item('chunkedKey', ['first part; ', 'second part; ', 'third part']),
+        *chunked_item('brokenKey', ['first part; ', 'second part; ', 'third part'], missing=(2,)),
+    ]
+    TEARDOWN_BATCH_WRITES = [
+        *chunked_keys('chunkedKey', 3),
+        *chunked_keys('brokenKey', 3),
+    ]
+
+
+    def tool_config(self):
+        return f"<Storage tableName='{self.TOOL_TABLE}' region='{self.TOOL_REGION}' maxChunks='3'/>"
+
+    def get_item(self, key):
+        result = self.dyndb_clnt.get_item(
+            TableName=self.TOOL_TABLE,
+            Key={'Context': {'S': 'chunkContext'}, 'Key': {'S': key}},
+            ConsistentRead=True
+        )
+        return result.get('Item', {})
+
+
+    def test_readString(self):
+        result = self.tool(
+            'readString',
+            'chunkContext',
+            'chunkedKey'
+        )
+
+        self.assertTrue(result['result'])
+        self.assertEqual(result['version'], 1)
+        self.assertEqual(result['value'], 'first part; second part; third part')
+
+    def test_readStringMissingChunk(self):
+        # a chunk that is gone for good makes the item unreadable, so it
+        # is deleted instead of failing every read
+        result = self.tool(
+            'readString',
+            'chunkContext',
+            'brokenKey'
+        )
+
+        self.assertFalse(result['result'])
+        self.assertEqual(self.get_item('brokenKey'), {})
+        self.assertEqual(self.get_item(f'brokenKey{CHUNK_SEPARATOR}1'), {})
+
+    def test_updateStringExpiration(self):
+        expires = int((datetime.now(timezone.utc) + timedelta(days=365)).timestamp())
+
+        result = self.tool(
+            'updateString',
+            'chunkContext',
+            'chunkedKey',
+            expiration=expires
+        )
+
+        self.assertTrue(result['result'])
+        self.assertEqual(result['version'], 2)
+
+        for key in ['chunkedKey'] + [f'chunkedKey{CHUNK_SEPARATOR}{i}' for i in (1, 2)]:
+            item = self.get_item(key)
+            self.assertEqual(item['Expires'], {'N': str(expires)})
+            self.assertEqual(item['Version'], {'N': '2'})
+
+        result = self.tool(
+            'readString',
+            'chunkContext',
+            'chunkedKey'
+        )
+
+        self.assertTrue(result['result'])
+        self.assertEqual(result['value'], 'first part; second part; third part')
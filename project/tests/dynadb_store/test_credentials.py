@@ -0,0 +1,124 @@
+# Copyright (c) 2018 University of Illinois Board of Trustees
+# All rights reserved.
+#
+# Developed by:       Technology Services
+#                     University of Illinois at Urbana-Champaign
+#                     https://techservices.illinois.edu/
+#
+#
+# Permission is hereby granted, free of charge, to any person obtaining
+# a copy of this software and associated documentation files (the
+# "Software"), to deal with the Software without restriction, including
+# without limitation the rights to use, copy, modify, merge, publish,
+# distribute, sublicense, and/or sell copies of the Software, and to
+# permit persons to whom the Software is furnished to do so, subject to
+# the following conditions:
+#
+# - Redistributions of source code must retain the above copyright
+#   notice, this list of conditions and the following disclaimers.
+# - Redistributions in binary form must reproduce the above copyright
+#   notice, this list of conditions and the following disclaimers in the
+#   documentation and/or other materials provided with the distribution.
+# - Neither the names of Technology Services, University of Illinois at
+#   Urbana-Champaign, nor the names of its contributors may be used to
+#   endorse or promote products derived from this Software without
+#   specific prior written permission.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+# EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+# MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+# IN NO EVENT SHALL THE CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+# ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+# CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+# WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS WITH THE SOFTWARE.
+from datetime import datetime, timezone, timedelta
+from http.server import BaseHTTPRequestHandler, HTTPServer
+import json
+import os
+import threading
+
+import boto3
+
+from . import ToolTestCase
+
+
+class CredentialsHandler(BaseHTTPRequestHandler):
+    """ Stand-in for the ECS container credentials endpoint. """
+    def do_GET(self):
+        self.server.requests += 1
+
+        creds = self.server.credentials
+        body = json.dumps({
+            'AccessKeyId': creds.access_key,
+            'SecretAccessKey': creds.secret_key,
+            'Token': creds.token or '',
+            'Expiration': (datetime.now(timezone.utc) + timedelta(minutes=10)).strftime('%Y-%m-%dT%H:%M:%SZ'),
+        }).encode('utf-8')
+
+        self.send_response(200)
+        self.send_header('Content-Type', 'application/json')
+        self.send_header('Content-Length', str(len(body)))
+        self.end_headers()
+        self.wfile.write(body)
+
+    def log_message(self, format, *args):
+        pass
+
+
+class CredentialsRefreshTestCase(ToolTestCase):
+    SETUP_BATCH_WRITES = [
+        {'PutRequest': {'Item': {
+            'Context': {'S': 'testContext'},
+            'Key': {'S': 'testKey'},
+            'Expires': {'N': '2147483647'},
+            'Value': {'S': 'this is a test string'},
+            'Version': {'N': '1'},
+        }}},
+    ]
+    TEARDOWN_BATCH_WRITES = [
+        {'DeleteRequest': {'Key': {
+            'Context': {'S': 'testContext'},
+            'Key': {'S': 'testKey'},
+        }}},
+    ]
+
+    def setUp(self):
+        super().setUp()
+
+        self.creds_server = HTTPServer(('127.0.0.1', 0), CredentialsHandler)
+        self.creds_server.requests = 0
+        self.creds_server.credentials = boto3.Session().get_credentials().get_frozen_credentials()
+        self.creds_thread = threading.Thread(target=self.creds_server.serve_forever, daemon=True)
+        self.creds_thread.start()
+
+    def tearDown(self):
+        self.creds_server.shutdown()
+        self.creds_server.server_close()
+        super().tearDown()
+
+    def tool_config(self):
+        return f"<Storage tableName='{self.TOOL_TABLE}' region='{self.TOOL_REGION}' credentialsRefreshInterval='1'/>"
+
+    def tool_env(self):
+        # only the stand-in can supply credentials
+        env = {
+            k: v for k, v in os.environ.items()
+            if k not in ('AWS_ACCESS_KEY_ID', 'AWS_SECRET_ACCESS_KEY', 'AWS_SESSION_TOKEN', 'AWS_PROFILE')
+        }
+        env['AWS_SHARED_CREDENTIALS_FILE'] = os.devnull
+        env['AWS_CONFIG_FILE'] = os.devnull
+        env['AWS_EC2_METADATA_DISABLED'] = 'true'
+        env['AWS_CONTAINER_CREDENTIALS_FULL_URI'] = f'http://127.0.0.1:{self.creds_server.server_port}/credentials'
+        env.pop('AWS_CONTAINER_CREDENTIALS_RELATIVE_URI', None)
+        return env
+
+    def test_readString(self):
+        result = self.tool(
+            'readString',
+            'testContext',
+            'testKey'
+        )
+
+        self.assertTrue(result['result'])
+        self.assertEqual(result['value'], 'this is a test string')
+        self.assertGreaterEqual(self.creds_server.requests, 1)
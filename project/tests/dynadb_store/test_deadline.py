@@ -0,0 +1,70 @@
+# Copyright (c) 2018 University of Illinois Board of Trustees
+# All rights reserved.
+#
+# Developed by:       Technology Services
+#                     University of Illinois at Urbana-Champaign
+#                     https://techservices.illinois.edu/
+#
+#
+# Permission is hereby granted, free of charge, to any person obtaining
+# a copy of this software and associated documentation files (the
+# "Software"), to deal with the Software without restriction, including
+# without limitation the rights to use, copy, modify, merge, publish,
+# distribute, sublicense, and/or sell copies of the Software, and to
+# permit persons to whom the Software is furnished to do so, subject to
+# the following conditions:
+#
+# - Redistributions of source code must retain the above copyright
+#   notice, this list of conditions and the following disclaimers.
+# - Redistributions in binary form must reproduce the above copyright
+#   notice, this list of conditions and the following disclaimers in the
+#   documentation and/or other materials provided with the distribution.
+# - Neither the names of Technology Services, University of Illinois at
+#   Urbana-Champaign, nor the names of its contributors may be used to
+#   endorse or promote products derived from this Software without
+#   specific prior written permission.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+# EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+# MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+# IN NO EVENT SHALL THE CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+# ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+# CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+# WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS WITH THE SOFTWARE.
+import socket
+import time
+
+from . import ToolTestCase
+
+class DeadlineTestCase(ToolTestCase):
+    def setUp(self):
+        # The endpoint accepts connections but never answers, so every
+        # request waits out the whole requestTimeoutMS.
+        self.stalled = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+        self.stalled.bind(('127.0.0.1', 0))
+        self.stalled.listen(16)
+
+        super().setUp()
+
+    def tearDown(self):
+        super().tearDown()
+
+        self.stalled.close()
+
+    def tool_config(self):
+        port = self.stalled.getsockname()[1]
+        return (
+            f"<Storage tableName='{self.TOOL_TABLE}' endpoint='http://127.0.0.1:{port}' region='{self.TOOL_REGION}'"
+            f" requestTimeoutMS='3000' maxRetries='3' breakerFailures='0' contextTimeoutMS='1000'/>"
+        )
+
+    def test_contextDeadline(self):
+        # Without the deadline the client would retry the Query three
+        # more times and the tool would be killed after 10 seconds.
+        start = time.monotonic()
+        with self.assertRaises(AssertionError):
+            self.tool(
+                'deleteContext',
+                'testContext'
+            )
+        self.assertLess(time.monotonic() - start, 8)
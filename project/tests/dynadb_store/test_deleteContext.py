@@ -86,6 +86,40 @@ class DeleteContextTestCase(ToolTestCase):
     ]
 
 
+    def test_deleteContextLarge(self):
+        # enough keys for several full batches plus a partial one
+        keys = [f'largeKey{i}' for i in range(130)]
+        items = [
+            {'PutRequest': {'Item': {
+                'Context': {'S': 'largeContext'},
+                'Key': {'S': k},
+                'Expires': {'N': '2147483647'},
+                'Value': {'S': 'this is a test string'},
+                'Version': {'N': '1'},
+            }}}
+            for k in keys
+        ]
+        while items:
+            result = self.dyndb_clnt.batch_write_item(RequestItems={self.TOOL_TABLE: items[:25]})
+            items = items[25:] + result.get('UnprocessedItems', {}).get(self.TOOL_TABLE, [])
+
+        result = self.tool(
+            'deleteContext',
+            'largeContext'
+        )
+
+        self.assertTrue(result['result'])
+
+        result = self.dyndb_clnt.query(
+            TableName=self.TOOL_TABLE,
+            KeyConditionExpression='#C = :context',
+            ExpressionAttributeNames={'#C': 'Context'},
+            ExpressionAttributeValues={':context': {'S': 'largeContext'}},
+            ConsistentRead=True
+        )
+        self.assertEqual(result['Count'], 0)
+
+
     def test_deleteContext(self):
         result = self.tool(
             'deleteContext',
@@ -0,0 +1,147 @@
+# Copyright (c) 2018 University of Illinois Board of Trustees
+# All rights reserved.
+#
+# Developed by:       Technology Services
+#                     University of Illinois at Urbana-Champaign
+#                     https://techservices.illinois.edu/
+#
+#
+# Permission is hereby granted, free of charge, to any person obtaining
+# a copy of this software and associated documentation files (the
+# "Software"), to deal with the Software without restriction, including
+# without limitation the rights to use, copy, modify, merge, publish,
+# distribute, sublicense, and/or sell copies of the Software, and to
+# permit persons to whom the Software is furnished to do so, subject to
+# the following conditions:
+#
+# - Redistributions of source code must retain the above copyright
+#   notice, this list of conditions and the following disclaimers.
+# - Redistributions in binary form must reproduce the above copyright
+#   notice, this list of conditions and the following disclaimers in the
+#   documentation and/or other materials provided with the distribution.
+# - Neither the names of Technology Services, University of Illinois at
+#   Urbana-Champaign, nor the names of its contributors may be used to
+#   endorse or promote products derived from this Software without
+#   specific prior written permission.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+# EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+# MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+# IN NO EVENT SHALL THE CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+# ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+# CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+# WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS WITH THE SOFTWARE.
+from datetime import datetime, timezone, timedelta
+
+from . import ToolTestCase
+
+class EndpointsTestCase(ToolTestCase):
+    # The primary endpoint refuses connections, so every request has to
+    # fail over to the region endpoint.
+    DEAD_ENDPOINT = 'http://127.0.0.1:9'
+
+    SETUP_BATCH_WRITES = [
+        {'PutRequest': {'Item': {
+            'Context': {'S': 'testContext'},
+            'Key': {'S': 'testKey'},
+            'Expires': {'N': '2147483647'},
+            'Value': {'S': 'this is a test string'},
+            'Version': {'N': '1'},
+        }}},
+    ]
+    TEARDOWN_BATCH_WRITES = [
+        {'DeleteRequest': {'Key': {
+            'Context': {'S': 'testContext'},
+            'Key': {'S': 'testKey'},
+        }}},
+        {'DeleteRequest': {'Key': {
+            'Context': {'S': 'testContext'},
+            'Key': {'S': 'testKey2'},
+        }}},
+    ]
+
+    def tool_config(self):
+        return (
+            f"<Storage tableName='{self.TOOL_TABLE}' maxRetries='0' connectTimeoutMS='200'>"
+            f"<Endpoint endpoint='{self.DEAD_ENDPOINT}' region='{self.TOOL_REGION}' primary='true'/>"
+            f"<Endpoint region='{self.TOOL_REGION}'/>"
+            f"</Storage>"
+        )
+
+    def test_readFailover(self):
+        result = self.tool(
+            'readString',
+            'testContext',
+            'testKey'
+        )
+
+        self.assertTrue(result['result'])
+        self.assertEqual(result['value'], 'this is a test string')
+        self.assertEqual(result['version'], 1)
+
+    def test_writeFailover(self):
+        expires = int((datetime.now(timezone.utc) + timedelta(days=365)).timestamp())
+
+        result = self.tool(
+            'createString',
+            'testContext',
+            'testKey2',
+            'this is a test value',
+            expires
+        )
+        self.assertTrue(result['result'])
+
+        result = self.dyndb_clnt.get_item(
+            TableName=self.TOOL_TABLE,
+            Key={'Context': {'S': 'testContext'}, 'Key': {'S': 'testKey2'}},
+            ConsistentRead=True
+        )
+        self.assertEqual(result.get('Item', {}).get('Value'), {'S': 'this is a test value'})
+
+
+class EndpointsWarmupTestCase(ToolTestCase):
+    # An unreachable secondary must not stop the plugin from loading.
+    DEAD_ENDPOINT = 'http://127.0.0.1:9'
+
+    SETUP_BATCH_WRITES = EndpointsTestCase.SETUP_BATCH_WRITES
+    TEARDOWN_BATCH_WRITES = EndpointsTestCase.TEARDOWN_BATCH_WRITES
+
+    def tool_config(self):
+        return (
+            f"<Storage tableName='{self.TOOL_TABLE}' maxRetries='0' connectTimeoutMS='200' warmup='true'>"
+            f"<Endpoint region='{self.TOOL_REGION}' primary='true'/>"
+            f"<Endpoint endpoint='{self.DEAD_ENDPOINT}' region='{self.TOOL_REGION}'/>"
+            f"</Storage>"
+        )
+
+    def test_readString(self):
+        result = self.tool(
+            'readString',
+            'testContext',
+            'testKey'
+        )
+
+        self.assertTrue(result['result'])
+        self.assertEqual(result['value'], 'this is a test string')
+
+
+class WarmupNoConnectionsTestCase(ToolTestCase):
+    # Validating the table still takes one request.
+    SETUP_BATCH_WRITES = EndpointsTestCase.SETUP_BATCH_WRITES
+    TEARDOWN_BATCH_WRITES = EndpointsTestCase.TEARDOWN_BATCH_WRITES
+
+    def tool_config(self):
+        return (
+            f"<Storage tableName='{self.TOOL_TABLE}' region='{self.TOOL_REGION}'"
+            f" warmup='true' warmupConnections='0'/>"
+        )
+
+    def test_readString(self):
+        result = self.tool(
+            'readString',
+            'testContext',
+            'testKey'
+        )
+
+        self.assertTrue(result['result'])
+        self.assertEqual(result['value'], 'this is a test string')
@@ -0,0 +1,95 @@
+# Copyright (c) 2018 University of Illinois Board of Trustees
+# All rights reserved.
+#
+# Developed by:       Technology Services
+#                     University of Illinois at Urbana-Champaign
+#                     https://techservices.illinois.edu/
+#
+#
+# Permission is hereby granted, free of charge, to any person obtaining
+# a copy of this software and associated documentation files (the
+# "Software"), to deal with the Software without restriction, including
+# without limitation the rights to use, copy, modify, merge, publish,
+# distribute, sublicense, and/or sell copies of the Software, and to
+# permit persons to whom the Software is furnished to do so, subject to
+# the following conditions:
+#
+# - Redistributions of source code must retain the above copyright
+#   notice, this list of conditions and the following disclaimers.
+# - Redistributions in binary form must reproduce the above copyright
+#   notice, this list of conditions and the following disclaimers in the
+#   documentation and/or other materials provided with the distribution.
+# - Neither the names of Technology Services, University of Illinois at
+#   Urbana-Champaign, nor the names of its contributors may be used to
+#   endorse or promote products derived from this Software without
+#   specific prior written permission.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+# EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+# MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+# IN NO EVENT SHALL THE CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+# ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+# CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+# WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS WITH THE SOFTWARE.
+from . import ToolTestCase
+
+class ExecutorTestCase(ToolTestCase):
+    SETUP_BATCH_WRITES = [
+        {'PutRequest': {'Item': {
+            'Context': {'S': f'executorContext{c}'},
+            'Key': {'S': f'testKey{i}'},
+            'Expires': {'N': '2147483647'},
+            'Value': {'S': 'this is a test string'},
+            'Version': {'N': '1'},
+        }}}
+        for c in range(4)
+        for i in range(30)
+    ]
+    TEARDOWN_BATCH_WRITES = [
+        {'DeleteRequest': {'Key': {
+            'Context': {'S': f'executorContext{c}'},
+            'Key': {'S': f'testKey{i}'},
+        }}}
+        for c in range(4)
+        for i in range(30)
+    ]
+
+
+    def tool_config(self):
+        # a queue this small makes callers wait for room
+        return f"<Storage tableName='{self.TOOL_TABLE}' region='{self.TOOL_REGION}' executorThreads='2' executorQueueSize='1' batchSize='5'/>"
+
+
+    def test_deleteContexts(self):
+        contexts = [f'executorContext{c}' for c in range(4)]
+
+        result = self.tool(
+            'deleteContext',
+            *contexts
+        )
+
+        self.assertTrue(result['result'])
+        self.assertEqual(result['contexts'], contexts)
+
+        for context in contexts:
+            result_q = self.dyndb_clnt.query(
+                TableName=self.TOOL_TABLE,
+                KeyConditionExpression='#C = :context',
+                ExpressionAttributeNames={'#C': 'Context'},
+                ExpressionAttributeValues={':context': {'S': context}},
+                ConsistentRead=True
+            )
+            self.assertEqual(result_q['Count'], 0)
+
+        executor = result.get('executor')
+        if executor is None:
+            self.skipTest('store-tool is not linked against the loaded plugin')
+
+        self.assertEqual(executor['threads'], 2)
+        self.assertEqual(executor['queue_depth'], 0)
+        self.assertLessEqual(executor['max_queue_depth'], 1)
+        self.assertEqual(executor['completed'], executor['submitted'])
+        # each context is deleted on a worker, and its batches are queued
+        # like any other task
+        self.assertEqual(executor['inline'], 0)
+        self.assertGreaterEqual(executor['submitted'], 4 + 4 * 6)
@@ -0,0 +1,131 @@
+# Copyright (c) 2018 University of Illinois Board of Trustees
+# All rights reserved.
+#
+# Developed by:       Technology Services
+#                     University of Illinois at Urbana-Champaign
+#                     https://techservices.illinois.edu/
+#
+#
+# Permission is hereby granted, free of charge, to any person obtaining
+# a copy of this software and associated documentation files (the
+# "Software"), to deal with the Software without restriction, including
+# without limitation the rights to use, copy, modify, merge, publish,
+# distribute, sublicense, and/or sell copies of the Software, and to
+# permit persons to whom the Software is furnished to do so, subject to
+# the following conditions:
+#
+# - Redistributions of source code must retain the above copyright
+#   notice, this list of conditions and the following disclaimers.
+# - Redistributions in binary form must reproduce the above copyright
+#   notice, this list of conditions and the following disclaimers in the
+#   documentation and/or other materials provided with the distribution.
+# - Neither the names of Technology Services, University of Illinois at
+#   Urbana-Champaign, nor the names of its contributors may be used to
+#   endorse or promote products derived from this Software without
+#   specific prior written permission.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+# EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+# MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+# IN NO EVENT SHALL THE CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+# ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+# CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+# WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS WITH THE SOFTWARE.
+import os
+import time
+
+from . import ToolTestCase
+
+class KeysIndexTestCase(ToolTestCase):
+    KEYS_INDEX = os.environ.get('UIUC_SHIBPLUGINS_STORE_KEYS_INDEX', 'ContextKeys')
+
+    SETUP_BATCH_WRITES = [
+        {'PutRequest': {'Item': {
+            'Context': {'S': 'indexContext'},
+            'Key': {'S': f'testKey{i}'},
+            'Expires': {'N': '2147483647'},
+            'Value': {'S': 'this is a test string'},
+            'Version': {'N': '1'},
+        }}}
+        for i in range(3)
+    ]
+    TEARDOWN_BATCH_WRITES = [
+        {'DeleteRequest': {'Key': {
+            'Context': {'S': 'indexContext'},
+            'Key': {'S': f'testKey{i}'},
+        }}}
+        for i in range(3)
+    ]
+
+
+    def setUp(self):
+        super().setUp()
+
+        table = self.dyndb_clnt.describe_table(TableName=self.TOOL_TABLE)['Table']
+        indexes = [i['IndexName'] for i in table.get('GlobalSecondaryIndexes', [])]
+        if self.KEYS_INDEX not in indexes:
+            self.skipTest(f'table has no {self.KEYS_INDEX} index')
+
+        # the index is only eventually consistent with the table
+        for _ in range(20):
+            result = self.dyndb_clnt.query(
+                TableName=self.TOOL_TABLE,
+                IndexName=self.KEYS_INDEX,
+                KeyConditionExpression='#C = :context',
+                ExpressionAttributeNames={'#C': 'Context'},
+                ExpressionAttributeValues={':context': {'S': 'indexContext'}},
+            )
+            if result['Count'] == 3:
+                break
+            time.sleep(0.5)
+
+
+    def tool_config(self):
+        return f"<Storage tableName='{self.TOOL_TABLE}' region='{self.TOOL_REGION}' keysIndexName='{self.KEYS_INDEX}' warmup='true' warmupConnections='1'/>"
+
+
+    def test_deleteContext(self):
+        result = self.tool(
+            'deleteContext',
+            'indexContext'
+        )
+
+        self.assertTrue(result['result'])
+
+        result = self.dyndb_clnt.query(
+            TableName=self.TOOL_TABLE,
+            KeyConditionExpression='#C = :context',
+            ExpressionAttributeNames={'#C': 'Context'},
+            ExpressionAttributeValues={':context': {'S': 'indexContext'}},
+            ConsistentRead=True
+        )
+        self.assertEqual(result['Count'], 0)
+
+    def test_deleteContextNewKey(self):
+        # written just before, so the index might not list it yet
+        self.dyndb_clnt.put_item(
+            TableName=self.TOOL_TABLE,
+            Item={
+                'Context': {'S': 'indexContext'},
+                'Key': {'S': 'testKey3'},
+                'Expires': {'N': '2147483647'},
+                'Value': {'S': 'this is a test string'},
+                'Version': {'N': '1'},
+            }
+        )
+
+        result = self.tool(
+            'deleteContext',
+            'indexContext'
+        )
+
+        self.assertTrue(result['result'])
+
+        result = self.dyndb_clnt.query(
+            TableName=self.TOOL_TABLE,
+            KeyConditionExpression='#C = :context',
+            ExpressionAttributeNames={'#C': 'Context'},
+            ExpressionAttributeValues={':context': {'S': 'indexContext'}},
+            ConsistentRead=True
+        )
+        self.assertEqual(result['Count'], 0)
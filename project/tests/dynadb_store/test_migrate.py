@@ -0,0 +1,136 @@
+# Copyright (c) 2018 University of Illinois Board of Trustees
+# All rights reserved.
+#
+# Developed by:       Technology Services
+#                     University of Illinois at Urbana-Champaign
+#                     https://techservices.illinois.edu/
+#
+#
+# Permission is hereby granted, free of charge, to any person obtaining
+# a copy of this software and associated documentation files (the
+# "Software"), to deal with the Software without restriction, including
+# without limitation the rights to use, copy, modify, merge, publish,
+# distribute, sublicense, and/or sell copies of the Software, and to
+# permit persons to whom the Software is furnished to do so, subject to
+# the following conditions:
+#
+# - Redistributions of source code must retain the above copyright
+#   notice, this list of conditions and the following disclaimers.
+# - Redistributions in binary form must reproduce the above copyright
+#   notice, this list of conditions and the following disclaimers in the
+#   documentation and/or other materials provided with the distribution.
+# - Neither the names of Technology Services, University of Illinois at
+#   Urbana-Champaign, nor the names of its contributors may be used to
+#   endorse or promote products derived from this Software without
+#   specific prior written permission.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+# EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+# MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+# IN NO EVENT SHALL THE CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+# ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+# CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+# WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS WITH THE SOFTWARE.
+import os
+
+from . import ToolTestCase
+from .test_attributeNames import CUSTOM_NAMES
+
+class MigrateTestCase(ToolTestCase):
+    # A second table with the legacy key schema to copy from. The test
+    # table, with other attribute names, is the destination.
+    SOURCE_TABLE = os.environ.get('UIUC_SHIBPLUGINS_STORE_MIGRATE_TABLE', None)
+
+    SOURCE_ITEMS = [
+        {
+            'Context': {'S': 'migrateContext'},
+            'Key': {'S': 'copiedKey'},
+            'Expires': {'N': '2147483647'},
+            'Value': {'S': 'this is a copied string'},
+            'Version': {'N': '1'},
+        },
+        {
+            'Context': {'S': 'migrateContext'},
+            'Key': {'S': 'newerKey'},
+            'Expires': {'N': '2147483647'},
+            'Value': {'S': 'this is an older string'},
+            'Version': {'N': '1'},
+        },
+        {
+            'Context': {'S': 'migrateContext'},
+            'Key': {'S': 'expiredKey'},
+            'Expires': {'N': '1'},
+            'Value': {'S': 'this is an expired string'},
+            'Version': {'N': '1'},
+        },
+    ]
+
+    # written to the destination after the source was read
+    SETUP_BATCH_WRITES = [
+        {'PutRequest': {'Item': {
+            'Context': {'S': 'migrateContext'},
+            'Key': {'S': 'newerKey'},
+            'Exp': {'N': '2147483647'},
+            'Val': {'S': 'this is a newer string'},
+            'Ver': {'N': '5'},
+        }}},
+    ]
+    TEARDOWN_BATCH_WRITES = [
+        {'DeleteRequest': {'Key': {
+            'Context': {'S': 'migrateContext'},
+            'Key': {'S': k},
+        }}}
+        for k in ('copiedKey', 'newerKey', 'expiredKey')
+    ]
+
+    def setUp(self):
+        if not self.SOURCE_TABLE:
+            self.skipTest('no UIUC_SHIBPLUGINS_STORE_MIGRATE_TABLE to copy from')
+
+        super().setUp()
+
+        for item in self.SOURCE_ITEMS:
+            self.dyndb_clnt.put_item(TableName=self.SOURCE_TABLE, Item=item)
+
+    def tearDown(self):
+        for item in self.SOURCE_ITEMS:
+            self.dyndb_clnt.delete_item(
+                TableName=self.SOURCE_TABLE,
+                Key={'Context': item['Context'], 'Key': item['Key']}
+            )
+
+        super().tearDown()
+
+    def tool_config(self):
+        return f"<Storage tableName='{self.TOOL_TABLE}' region='{self.TOOL_REGION}' attributeNames='{CUSTOM_NAMES}'/>"
+
+    def get_item(self, key):
+        return self.dyndb_clnt.get_item(
+            TableName=self.TOOL_TABLE,
+            Key={'Context': {'S': 'migrateContext'}, 'Key': {'S': key}},
+            ConsistentRead=True
+        ).get('Item', {})
+
+    def test_migrate(self):
+        result = self.tool(
+            'migrate',
+            self.SOURCE_TABLE,
+            **{'source-names': 'legacy'}
+        )
+
+        self.assertTrue(result['result'])
+        self.assertGreaterEqual(result['copied'], 1)
+        self.assertGreaterEqual(result['skipped'], 1)
+
+        item = self.get_item('copiedKey')
+        self.assertEqual(item['Val']['S'], 'this is a copied string')
+        self.assertEqual(item['Exp']['N'], '2147483647')
+        self.assertEqual(item['Ver']['N'], '1')
+        self.assertNotIn('Value', item)
+
+        # the newer item in the destination isn't overwritten
+        item = self.get_item('newerKey')
+        self.assertEqual(item['Val']['S'], 'this is a newer string')
+        self.assertEqual(item['Ver']['N'], '5')
+
+        self.assertEqual(self.get_item('expiredKey'), {})
@@ -0,0 +1,137 @@
+# Copyright (c) 2018 University of Illinois Board of Trustees
+# All rights reserved.
+#
+# Developed by:       Technology Services
+#                     University of Illinois at Urbana-Champaign
+#                     https://techservices.illinois.edu/
+#
+#
+# Permission is hereby granted, free of charge, to any person obtaining
+# a copy of this software and associated documentation files (the
+# "Software"), to deal with the Software without restriction, including
+# without limitation the rights to use, copy, modify, merge, publish,
+# distribute, sublicense, and/or sell copies of the Software, and to
+# permit persons to whom the Software is furnished to do so, subject to
+# the following conditions:
+#
+# - Redistributions of source code must retain the above copyright
+#   notice, this list of conditions and the following disclaimers.
+# - Redistributions in binary form must reproduce the above copyright
+#   notice, this list of conditions and the following disclaimers in the
+#   documentation and/or other materials provided with the distribution.
+# - Neither the names of Technology Services, University of Illinois at
+#   Urbana-Champaign, nor the names of its contributors may be used to
+#   endorse or promote products derived from this Software without
+#   specific prior written permission.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+# EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+# MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+# IN NO EVENT SHALL THE CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+# ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+# CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+# WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS WITH THE SOFTWARE.
+from . import ToolTestCase
+
+class PrefetchTestCase(ToolTestCase):
+    SETUP_BATCH_WRITES = [
+        {'PutRequest': {'Item': {
+            'Context': {'S': 'prefetchContext'},
+            'Key': {'S': f'testKey{i}'},
+            'Expires': {'N': '2147483647'},
+            'Value': {'S': f'this is test string {i}'},
+            'Version': {'N': '2'},
+        }}}
+        for i in range(3)
+    ]
+    TEARDOWN_BATCH_WRITES = [
+        {'DeleteRequest': {'Key': {
+            'Context': {'S': 'prefetchContext'},
+            'Key': {'S': f'testKey{i}'},
+        }}}
+        for i in range(3)
+    ]
+
+    def tool_config(self):
+        return (
+            f"<Storage tableName='{self.TOOL_TABLE}' region='{self.TOOL_REGION}' capacityProfile='true' prefetchTTLMS='60000'>"
+            f"<Prefetch prefix='prefetch'/>"
+            f"</Storage>"
+        )
+
+    def test_readString(self):
+        result = self.tool(
+            'readString',
+            'prefetchContext',
+            'testKey1'
+        )
+
+        self.assertTrue(result['result'])
+        self.assertEqual(result['version'], 2)
+        self.assertEqual(result['value'], 'this is test string 1')
+        self.assertEqual(result['expiration'], 2147483647)
+
+    def test_readStringVersion(self):
+        result = self.tool(
+            'readString',
+            'prefetchContext',
+            'testKey1',
+            version=2
+        )
+
+        self.assertTrue(result['result'])
+        self.assertFalse(result['version_changed'])
+
+    def test_readStringMissing(self):
+        result = self.tool(
+            'readString',
+            'prefetchContext',
+            'missingKey'
+        )
+
+        self.assertFalse(result['result'])
+
+    def test_oneQuery(self):
+        result = self.tool(
+            'bench',
+            'prefetchContext',
+            'testKey0',
+            iterations=5
+        )
+
+        self.assertTrue(result['result'])
+
+        capacity = result.get('capacity')
+        if capacity is None:
+            self.skipTest('store-tool is not linked against the loaded plugin')
+
+        operations = {c['operation']: c['requests'] for c in capacity}
+        self.assertEqual(operations, {'Query': 1})
+
+class PrefetchTooLargeTestCase(ToolTestCase):
+    SETUP_BATCH_WRITES = PrefetchTestCase.SETUP_BATCH_WRITES
+    TEARDOWN_BATCH_WRITES = PrefetchTestCase.TEARDOWN_BATCH_WRITES
+
+    def tool_config(self):
+        return (
+            f"<Storage tableName='{self.TOOL_TABLE}' region='{self.TOOL_REGION}' capacityProfile='true' prefetchTTLMS='60000' prefetchMaxItems='2'>"
+            f"<Prefetch prefix='prefetch'/>"
+            f"</Storage>"
+        )
+
+    def test_oneQuery(self):
+        result = self.tool(
+            'bench',
+            'prefetchContext',
+            'testKey0',
+            iterations=5
+        )
+
+        self.assertTrue(result['result'])
+
+        capacity = result.get('capacity')
+        if capacity is None:
+            self.skipTest('store-tool is not linked against the loaded plugin')
+
+        operations = {c['operation']: c['requests'] for c in capacity}
+        self.assertEqual(operations, {'Query': 1, 'GetItem': 5})
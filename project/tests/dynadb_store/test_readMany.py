@@ -0,0 +1,97 @@
+# Copyright (c) 2018 University of Illinois Board of Trustees
+# All rights reserved.
+#
+# Developed by:       Technology Services
+#                     University of Illinois at Urbana-Champaign
+#                     https://techservices.illinois.edu/
+#
+#
+# Permission is hereby granted, free of charge, to any person obtaining
+# a copy of this software and associated documentation files (the
+# "Software"), to deal with the Software without restriction, including
+# without limitation the rights to use, copy, modify, merge, publish,
+# distribute, sublicense, and/or sell copies of the Software, and to
+# permit persons to whom the Software is furnished to do so, subject to
+# the following conditions:
+#
+# - Redistributions of source code must retain the above copyright
+#   notice, this list of conditions and the following disclaimers.
+# - Redistributions in binary form must reproduce the above copyright
+#   notice, this list of conditions and the following disclaimers in the
+#   documentation and/or other materials provided with the distribution.
+# - Neither the names of Technology Services, University of Illinois at
+#   Urbana-Champaign, nor the names of its contributors may be used to
+#   endorse or promote products derived from this Software without
+#   specific prior written permission.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+# EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+# MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+# IN NO EVENT SHALL THE CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+# ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+# CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+# WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS WITH THE SOFTWARE.
+from . import ToolTestCase
+
+class ReadManyTestCase(ToolTestCase):
+    SETUP_BATCH_WRITES = [
+        {'PutRequest': {'Item': {
+            'Context': {'S': 'testContext'},
+            'Key': {'S': f'testKey{i}'},
+            'Expires': {'N': '2147483647'},
+            'Value': {'S': f'this is test string {i}'},
+            'Version': {'N': '1'},
+        }}}
+        for i in range(120)
+    ] + [
+        {'PutRequest': {'Item': {
+            'Context': {'S': 'testContext'},
+            'Key': {'S': 'expiredKey'},
+            'Expires': {'N': '1'},
+            'Value': {'S': 'this is a test string'},
+            'Version': {'N': '1'},
+        }}},
+    ]
+    TEARDOWN_BATCH_WRITES = [
+        {'DeleteRequest': {'Key': {
+            'Context': {'S': 'testContext'},
+            'Key': {'S': f'testKey{i}'},
+        }}}
+        for i in range(120)
+    ] + [
+        {'DeleteRequest': {'Key': {
+            'Context': {'S': 'testContext'},
+            'Key': {'S': 'expiredKey'},
+        }}},
+    ]
+
+    def test_readMany(self):
+        args = []
+        for i in range(120):
+            args.extend(['testContext', f'testKey{i}'])
+        args.extend(['testContext', 'expiredKey', 'testContext', 'missingKey', 'testContext', 'testKey0'])
+
+        result = self.tool('readMany', *args)
+
+        self.assertTrue(result['result'])
+        items = result['items']
+        self.assertEqual(len(items), 123)
+        for i in range(120):
+            self.assertTrue(items[i]['result'])
+            self.assertEqual(items[i]['key'], f'testKey{i}')
+            self.assertEqual(items[i]['version'], 1)
+            self.assertEqual(items[i]['value'], f'this is test string {i}')
+        self.assertFalse(items[120]['result'])
+        self.assertFalse(items[121]['result'])
+        self.assertEqual(items[122]['value'], 'this is test string 0')
+
+    def test_readManyVersion(self):
+        result = self.tool(
+            'readMany',
+            'testContext', 'testKey1',
+            version=1
+        )
+
+        self.assertTrue(result['result'])
+        self.assertFalse(result['items'][0]['version_changed'])
+        self.assertNotIn('value', result['items'][0])
@@ -0,0 +1,83 @@
+# Copyright (c) 2018 University of Illinois Board of Trustees
+# All rights reserved.
+#
+# Developed by:       Technology Services
+#                     University of Illinois at Urbana-Champaign
+#                     https://techservices.illinois.edu/
+#
+#
+# Permission is hereby granted, free of charge, to any person obtaining
+# a copy of this software and associated documentation files (the
+# "Software"), to deal with the Software without restriction, including
+# without limitation the rights to use, copy, modify, merge, publish,
+# distribute, sublicense, and/or sell copies of the Software, and to
+# permit persons to whom the Software is furnished to do so, subject to
+# the following conditions:
+#
+# - Redistributions of source code must retain the above copyright
+#   notice, this list of conditions and the following disclaimers.
+# - Redistributions in binary form must reproduce the above copyright
+#   notice, this list of conditions and the following disclaimers in the
+#   documentation and/or other materials provided with the distribution.
+# - Neither the names of Technology Services, University of Illinois at
+#   Urbana-Champaign, nor the names of its contributors may be used to
+#   endorse or promote products derived from this Software without
+#   specific prior written permission.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+# EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+# MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+# IN NO EVENT SHALL THE CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+# ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+# CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+# WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS WITH THE SOFTWARE.
+from . import ToolTestCase
+
+class RouteTestCase(ToolTestCase):
+    TEARDOWN_BATCH_WRITES = [
+        {'DeleteRequest': {'Key': {
+            'Context': {'S': 'routedContext'},
+            'Key': {'S': 'testKey'},
+        }}},
+    ]
+
+    def tool_config(self):
+        return (
+            f"<Storage tableName='{self.TOOL_TABLE}' region='{self.TOOL_REGION}' maxRetries='0'>"
+            f"<Route prefix='routed' maxConnections='2' requestTimeoutMS='1000'/>"
+            f"<Route prefix='missing' tableName='{self.TOOL_TABLE}-missing'/>"
+            f"</Storage>"
+        )
+
+    def test_routedClients(self):
+        result = self.tool(
+            'createString',
+            'routedContext',
+            'testKey',
+            'this is a test string',
+            2147483647
+        )
+        self.assertTrue(result['result'])
+
+        result = self.dyndb_clnt.get_item(
+            TableName=self.TOOL_TABLE,
+            Key={'Context': {'S': 'routedContext'}, 'Key': {'S': 'testKey'}},
+            ConsistentRead=True
+        )
+        self.assertEqual(result['Item']['Value'], {'S': 'this is a test string'})
+
+    def test_routedTable(self):
+        # the missing table proves the read did not go to the main table
+        with self.assertRaises(AssertionError):
+            self.tool(
+                'readString',
+                'missingContext',
+                'testKey'
+            )
+
+        result = self.tool(
+            'readString',
+            'otherContext',
+            'testKey'
+        )
+        self.assertFalse(result['result'])
@@ -0,0 +1,140 @@
+# Copyright (c) 2018 University of Illinois Board of Trustees
+# All rights reserved.
+#
+# Developed by:       Technology Services
+#                     University of Illinois at Urbana-Champaign
+#                     https://techservices.illinois.edu/
+#
+#
+# Permission is hereby granted, free of charge, to any person obtaining
+# a copy of this software and associated documentation files (the
+# "Software"), to deal with the Software without restriction, including
+# without limitation the rights to use, copy, modify, merge, publish,
+# distribute, sublicense, and/or sell copies of the Software, and to
+# permit persons to whom the Software is furnished to do so, subject to
+# the following conditions:
+#
+# - Redistributions of source code must retain the above copyright
+#   notice, this list of conditions and the following disclaimers.
+# - Redistributions in binary form must reproduce the above copyright
+#   notice, this list of conditions and the following disclaimers in the
+#   documentation and/or other materials provided with the distribution.
+# - Neither the names of Technology Services, University of Illinois at
+#   Urbana-Champaign, nor the names of its contributors may be used to
+#   endorse or promote products derived from this Software without
+#   specific prior written permission.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+# EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+# MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+# IN NO EVENT SHALL THE CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+# ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+# CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+# WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS WITH THE SOFTWARE.
+from datetime import datetime, timezone, timedelta
+
+from . import ToolTestCase
+
+SHARD_SEPARATOR = '\x1e'
+SHARD_COUNT = 4
+SHARD_KEYS = [f'shardKey{i}' for i in range(8)]
+
+def shard_partition(context, key, count=SHARD_COUNT):
+    # FNV-1a, the same as the plugin, so the test knows which
+    # partition a key lands on
+    h = 2166136261
+    for c in key.encode('utf-8'):
+        h ^= c
+        h = (h * 16777619) & 0xffffffff
+    return f'{context}{SHARD_SEPARATOR}{h % count}'
+
+
+class ShardTestCase(ToolTestCase):
+    SETUP_BATCH_WRITES = [
+        {'PutRequest': {'Item': {
+            'Context': {'S': shard_partition('shardContext', k)},
+            'Key': {'S': k},
+            'Expires': {'N': '2147483647'},
+            'Value': {'S': 'this is a test string'},
+            'Version': {'N': '1'},
+        }}}
+        for k in SHARD_KEYS
+    ]
+    TEARDOWN_BATCH_WRITES = [
+        {'DeleteRequest': {'Key': {
+            'Context': {'S': shard_partition('shardContext', k)},
+            'Key': {'S': k},
+        }}}
+        for k in SHARD_KEYS + ['newShardKey']
+    ]
+
+    def tool_config(self):
+        return (
+            f"<Storage tableName='{self.TOOL_TABLE}' region='{self.TOOL_REGION}'>"
+            f"<Shard prefix='shardContext' count='{SHARD_COUNT}'/>"
+            f"</Storage>"
+        )
+
+    def get_item(self, key):
+        return self.dyndb_clnt.get_item(
+            TableName=self.TOOL_TABLE,
+            Key={'Context': {'S': shard_partition('shardContext', key)}, 'Key': {'S': key}},
+            ConsistentRead=True
+        ).get('Item', {})
+
+    def test_spread(self):
+        # otherwise the rest of the tests could pass on one partition
+        self.assertGreater(len({shard_partition('shardContext', k) for k in SHARD_KEYS}), 1)
+
+    def test_readString(self):
+        for k in SHARD_KEYS:
+            result = self.tool(
+                'readString',
+                'shardContext',
+                k
+            )
+
+            self.assertTrue(result['result'])
+            self.assertEqual(result['value'], 'this is a test string')
+            self.assertEqual(result['version'], 1)
+
+    def test_createString(self):
+        expires = int((datetime.now(timezone.utc) + timedelta(hours=1)).timestamp())
+        result = self.tool(
+            'createString',
+            'shardContext',
+            'newShardKey',
+            'this is a new string',
+            expires
+        )
+
+        self.assertTrue(result['result'])
+
+        item = self.get_item('newShardKey')
+        self.assertEqual(item['Value']['S'], 'this is a new string')
+        self.assertEqual(item['Expires']['N'], str(expires))
+
+    def test_updateContext(self):
+        expires = int((datetime.now(timezone.utc) + timedelta(hours=1)).timestamp())
+        result = self.tool(
+            'updateContext',
+            'shardContext',
+            expires
+        )
+
+        self.assertTrue(result['result'])
+
+        for k in SHARD_KEYS:
+            item = self.get_item(k)
+            self.assertEqual(item['Expires']['N'], str(expires))
+
+    def test_deleteContext(self):
+        result = self.tool(
+            'deleteContext',
+            'shardContext'
+        )
+
+        self.assertTrue(result['result'])
+
+        for k in SHARD_KEYS:
+            self.assertEqual(self.get_item(k), {})
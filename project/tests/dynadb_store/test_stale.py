@@ -0,0 +1,146 @@
+# Copyright (c) 2018 University of Illinois Board of Trustees
+# All rights reserved.
+#
+# Developed by:       Technology Services
+#                     University of Illinois at Urbana-Champaign
+#                     https://techservices.illinois.edu/
+#
+#
+# Permission is hereby granted, free of charge, to any person obtaining
+# a copy of this software and associated documentation files (the
+# "Software"), to deal with the Software without restriction, including
+# without limitation the rights to use, copy, modify, merge, publish,
+# distribute, sublicense, and/or sell copies of the Software, and to
+# permit persons to whom the Software is furnished to do so, subject to
+# the following conditions:
+#
+# - Redistributions of source code must retain the above copyright
+#   notice, this list of conditions and the following disclaimers.
+# - Redistributions in binary form must reproduce the above copyright
+#   notice, this list of conditions and the following disclaimers in the
+#   documentation and/or other materials provided with the distribution.
+# - Neither the names of Technology Services, University of Illinois at
+#   Urbana-Champaign, nor the names of its contributors may be used to
+#   endorse or promote products derived from this Software without
+#   specific prior written permission.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+# EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+# MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+# IN NO EVENT SHALL THE CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+# ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+# CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+# WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS WITH THE SOFTWARE.
+from http.server import BaseHTTPRequestHandler, ThreadingHTTPServer
+import json
+import threading
+
+from . import ToolTestCase
+
+class FlakyDynamoDBHandler(BaseHTTPRequestHandler):
+    # Answers the first GetItem with the item and fails everything after
+    # it, like a table that goes away in the middle of a run.
+    ITEM = {
+        'Context': {'S': 'testContext'},
+        'Key': {'S': 'testKey'},
+        'Expires': {'N': '2147483647'},
+        'Value': {'S': 'this is a stale string'},
+        'Version': {'N': '1'},
+    }
+
+    def do_POST(self):
+        self.rfile.read(int(self.headers.get('Content-Length', 0)))
+
+        with self.server.lock:
+            answer = self.server.answers > 0
+            self.server.answers -= 1
+
+        if answer:
+            self.respond(200, {'Item': self.ITEM})
+        else:
+            self.respond(500, {
+                '__type': 'com.amazonaws.dynamodb.v20120810#InternalServerError',
+                'message': 'the table is unavailable',
+            })
+
+    def respond(self, status, body):
+        data = json.dumps(body).encode('utf-8')
+        self.send_response(status)
+        self.send_header('Content-Type', 'application/x-amz-json-1.0')
+        self.send_header('Content-Length', str(len(data)))
+        self.end_headers()
+        self.wfile.write(data)
+
+    def log_message(self, format, *args):
+        pass
+
+class FlakyEndpointTestCase(ToolTestCase):
+    STALE_BYTES = 16777216
+
+    def setUp(self):
+        self.server = ThreadingHTTPServer(('127.0.0.1', 0), FlakyDynamoDBHandler)
+        self.server.lock = threading.Lock()
+        self.server.answers = 1
+        self.thread = threading.Thread(target=self.server.serve_forever, daemon=True)
+        self.thread.start()
+
+        super().setUp()
+
+    def tearDown(self):
+        super().tearDown()
+
+        self.server.shutdown()
+        self.server.server_close()
+
+    def tool_config(self):
+        port = self.server.server_address[1]
+        return (
+            f"<Storage tableName='{self.TOOL_TABLE}' endpoint='http://127.0.0.1:{port}' region='{self.TOOL_REGION}'"
+            f" maxRetries='0' breakerFailures='0' staleIfErrorMS='60000' staleIfErrorBytes='{self.STALE_BYTES}'/>"
+        )
+
+class StaleTestCase(FlakyEndpointTestCase):
+    def test_serveStale(self):
+        # The untimed first read is answered and kept; every timed read
+        # after it fails and is served from what was kept.
+        result = self.tool(
+            'bench',
+            'testContext',
+            'testKey',
+            iterations=3
+        )
+
+        self.assertTrue(result['result'])
+        self.assertEqual(result['version'], 1)
+        self.assertEqual(result['stale']['served'], 3)
+        self.assertGreater(result['stale']['bytes'], 0)
+
+    def test_keepRead(self):
+        result = self.tool(
+            'readString',
+            'testContext',
+            'testKey'
+        )
+
+        self.assertTrue(result['result'])
+        self.assertEqual(result['value'], 'this is a stale string')
+        self.assertEqual(result['stale']['served'], 0)
+        self.assertEqual(
+            result['stale']['bytes'],
+            len('testContext') + len('testKey') + len('this is a stale string')
+        )
+
+class StaleBudgetTestCase(FlakyEndpointTestCase):
+    # smaller than the one item, so it is dropped as soon as it is kept
+    STALE_BYTES = 16
+
+    def test_keepRead(self):
+        result = self.tool(
+            'readString',
+            'testContext',
+            'testKey'
+        )
+
+        self.assertTrue(result['result'])
+        self.assertEqual(result['stale']['served'], 0)
+        self.assertEqual(result['stale']['bytes'], 0)
@@ -0,0 +1,150 @@
+# Copyright (c) 2018 University of Illinois Board of Trustees
+# All rights reserved.
+#
+# Developed by:       Technology Services
+#                     University of Illinois at Urbana-Champaign
+#                     https://techservices.illinois.edu/
+#
+#
+# Permission is hereby granted, free of charge, to any person obtaining
+# a copy of this software and associated documentation files (the
+# "Software"), to deal with the Software without restriction, including
+# without limitation the rights to use, copy, modify, merge, publish,
+# distribute, sublicense, and/or sell copies of the Software, and to
+# permit persons to whom the Software is furnished to do so, subject to
+# the following conditions:
+#
+# - Redistributions of source code must retain the above copyright
+#   notice, this list of conditions and the following disclaimers.
+# - Redistributions in binary form must reproduce the above copyright
+#   notice, this list of conditions and the following disclaimers in the
+#   documentation and/or other materials provided with the distribution.
+# - Neither the names of Technology Services, University of Illinois at
+#   Urbana-Champaign, nor the names of its contributors may be used to
+#   endorse or promote products derived from this Software without
+#   specific prior written permission.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+# EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+# MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+# IN NO EVENT SHALL THE CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+# ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+# CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+# WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS WITH THE SOFTWARE.
+import os
+from tempfile import TemporaryDirectory
+
+from . import ToolTestCase
+
+TRACE_MAGIC = b'UIUCTRC1'
+TRACE_RECORD_SIZE = 48
+TRACE_NO_VALUE = 1
+
+
+def fnv1a64(value):
+    h = 14695981039346656037
+    for b in value.encode('utf-8'):
+        h ^= b
+        h = (h * 1099511628211) & 0xffffffffffffffff
+    return h
+
+
+class TraceTestCase(ToolTestCase):
+    TEARDOWN_BATCH_WRITES = [
+        {'DeleteRequest': {'Key': {
+            'Context': {'S': 'traceContext'},
+            'Key': {'S': 'traceKey'},
+        }}},
+        {'DeleteRequest': {'Key': {
+            'Context': {'S': f"replay-{fnv1a64('traceContext'):016x}"},
+            'Key': {'S': f"{fnv1a64('traceKey'):016x}"},
+        }}},
+    ]
+
+    def setUp(self):
+        self.trace_dir = TemporaryDirectory(prefix='uiuc-shibplugins-trace.')
+        self.trace_file = os.path.join(self.trace_dir.name, 'trace.bin')
+        super().setUp()
+
+    def tearDown(self):
+        super().tearDown()
+        self.trace_dir.cleanup()
+
+    def tool_config(self):
+        return f"<Storage tableName='{self.TOOL_TABLE}' region='{self.TOOL_REGION}' traceFile='{self.trace_file}'/>"
+
+    def test_recordAndReplay(self):
+        result = self.tool(
+            'createString',
+            'traceContext',
+            'traceKey',
+            'this is a test string',
+            2147483647
+        )
+        self.assertTrue(result['result'])
+
+        result = self.tool(
+            'readString',
+            'traceContext',
+            'traceKey'
+        )
+        self.assertTrue(result['result'])
+
+        with open(self.trace_file, 'rb') as f:
+            trace = f.read()
+        self.assertEqual(trace[:len(TRACE_MAGIC)], TRACE_MAGIC)
+        self.assertEqual(len(trace), len(TRACE_MAGIC) + 2 * TRACE_RECORD_SIZE)
+
+        # replay a copy so the replay itself is not recorded over
+        replay_file = self.trace_file + '.replay'
+        os.rename(self.trace_file, replay_file)
+
+        result = self.tool(
+            'replay',
+            replay_file,
+            speed=0
+        )
+
+        self.assertTrue(result['result'])
+        self.assertEqual(result['records'], 2)
+        self.assertEqual(result['errors'], 0)
+        self.assertEqual(result['mismatches'], 0)
+
+    def test_replayExpirationUpdate(self):
+        result = self.tool(
+            'createString',
+            'traceContext',
+            'traceKey',
+            'this is a test string',
+            2147483647
+        )
+        self.assertTrue(result['result'])
+
+        # no value, which replay has to pass on as such
+        result = self.tool(
+            'updateString',
+            'traceContext',
+            'traceKey',
+            expiration=2147483646
+        )
+        self.assertTrue(result['result'])
+
+        with open(self.trace_file, 'rb') as f:
+            trace = f.read()
+        self.assertEqual(len(trace), len(TRACE_MAGIC) + 2 * TRACE_RECORD_SIZE)
+        update = trace[len(TRACE_MAGIC) + TRACE_RECORD_SIZE:]
+        self.assertEqual(update[42], TRACE_NO_VALUE)
+
+        replay_file = self.trace_file + '.replay'
+        os.rename(self.trace_file, replay_file)
+
+        result = self.tool(
+            'replay',
+            replay_file,
+            speed=0
+        )
+
+        self.assertTrue(result['result'])
+        self.assertEqual(result['records'], 2)
+        self.assertEqual(result['errors'], 0)
+        self.assertEqual(result['mismatches'], 0)
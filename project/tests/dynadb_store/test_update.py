@@ -205,3 +205,29 @@ class UpdateTestCase(ToolTestCase):
             'Value': {'S': 'this is a test string'},
             'Version': {'N': '1'},
         })
+
+    def test_updateStringExpirationOnly(self):
+        expires = int((datetime.now(timezone.utc) + timedelta(days=365)).timestamp())
+
+        result = self.tool(
+            'updateString',
+            'testContext',
+            'testKey',
+            expiration=expires
+        )
+
+        self.assertTrue(result['result'])
+        self.assertEqual(result['version'], 2)
+
+        result = self.dyndb_clnt.get_item(
+            TableName=self.TOOL_TABLE,
+            Key={'Context': {'S': 'testContext'}, 'Key': {'S': 'testKey'}},
+            ConsistentRead=True
+        )
+        self.assertEqual(result.get('Item', {}), {
+            'Context': {'S': 'testContext'},
+            'Key': {'S': 'testKey'},
+            'Expires': {'N': str(expires)},
+            'Value': {'S': 'this is a test string'},
+            'Version': {'N': '2'},
+        })